@@ -1,18 +1,87 @@
+#include <stdio.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "blink_pattern.h"
+#include "blink_rmt.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#define GPIO_NUM_2 2
+#else
 #include <driver/gpio.h>
+#endif
 
 #define BLINK_GPIO GPIO_NUM_2  // Pin where the LED is connected
+#define PATTERN_SHOW_MS 10000  // How long each demo pattern runs
+
+static const char *TAG = "blink";
+
+// Pattern descriptions: brightness from, to and duration in ms per step
+static const blink_step_t blink_1hz[] = {
+    {255, 255, 1000},
+    {0, 0, 1000},
+};
+
+static const blink_step_t heartbeat[] = {
+    {255, 255, 100},
+    {0, 0, 150},
+    {255, 255, 100},
+    {0, 0, 650},
+};
+
+static const blink_step_t breathe[] = {
+    {0, 255, 1200},
+    {255, 0, 1200},
+    {0, 0, 400},
+};
+
+#define STEP_COUNT(steps) (sizeof(steps) / sizeof(steps[0]))
+#define PATTERN_COUNT 4
+
+// Compiled patterns are large, keep them off the task stack
+static blink_pattern_t patterns[PATTERN_COUNT];
+
+// Keep a compiled pattern only if it compiled and fits this chip's RMT memory
+static bool pattern_ready(const char *name, esp_err_t err, const blink_pattern_t *pattern) {
+    if (err == ESP_OK && pattern->count > blink_rmt_max_pulses()) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Skipping pattern %s: %s", name, esp_err_to_name(err));
+    }
+    return err == ESP_OK;
+}
 
 void app_main(void) {
-    // Initialize the GPIO
-    gpio_reset_pin(BLINK_GPIO);
-    gpio_set_direction(BLINK_GPIO, GPIO_MODE_OUTPUT);
+    bool ready[PATTERN_COUNT];
+    size_t ready_count = 0;
+
+    if (blink_rmt_init(BLINK_GPIO) != ESP_OK) {
+        return;
+    }
+    ready[0] = pattern_ready("1hz", blink_pattern_compile(blink_1hz, STEP_COUNT(blink_1hz), &patterns[0]), &patterns[0]);
+    ready[1] = pattern_ready("heartbeat", blink_pattern_compile(heartbeat, STEP_COUNT(heartbeat), &patterns[1]), &patterns[1]);
+    ready[2] = pattern_ready("breathe", blink_pattern_compile(breathe, STEP_COUNT(breathe), &patterns[2]), &patterns[2]);
+    ready[3] = pattern_ready("code 3", blink_pattern_code(3, &patterns[3]), &patterns[3]);
+    for (size_t i = 0; i < PATTERN_COUNT; i++) {
+        ready_count += ready[i];
+    }
+    if (ready_count == 0) {
+        return;
+    }
 
+    // The RMT repeats each pattern on its own, this task only wakes to switch
     while (1) {
-        gpio_set_level(BLINK_GPIO, 1);  // Turn the LED on
-        vTaskDelay(1000 / portTICK_PERIOD_MS);  // Wait for 1 second
-        gpio_set_level(BLINK_GPIO, 0);  // Turn the LED off
-        vTaskDelay(1000 / portTICK_PERIOD_MS);  // Wait for 1 second
+        for (size_t i = 0; i < PATTERN_COUNT; i++) {
+            if (!ready[i]) {
+                continue;
+            }
+            esp_err_t err = blink_rmt_play(&patterns[i]);
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Pattern %u failed to start: %s", (unsigned)i, esp_err_to_name(err));
+            }
+            vTaskDelay(PATTERN_SHOW_MS / portTICK_PERIOD_MS);
+        }
     }
-}
\ No newline at end of file
+}
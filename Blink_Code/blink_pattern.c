@@ -0,0 +1,106 @@
+#include <stdbool.h>
+#include <string.h>
+#include "blink_pattern.h"
+
+#define BLINK_CODE_MAX 15
+#define BLINK_CODE_ON_MS 200
+#define BLINK_CODE_OFF_MS 300
+#define BLINK_CODE_PAUSE_MS 1500
+
+// Append `ticks` at `level`, extending the last pulse when the level repeats
+static bool emit(blink_pattern_t *pattern, uint8_t level, uint32_t ticks) {
+    if (ticks && pattern->count > 0 && pattern->pulses[pattern->count - 1].level == level) {
+        blink_pulse_t *last = &pattern->pulses[pattern->count - 1];
+        uint32_t add = BLINK_PULSE_MAX_TICKS - last->ticks;
+        add = add < ticks ? add : ticks;
+        last->ticks += add;
+        ticks -= add;
+    }
+    while (ticks > 0) {
+        if (pattern->count == BLINK_PATTERN_MAX_PULSES) {
+            return false;
+        }
+        uint32_t len = ticks < BLINK_PULSE_MAX_TICKS ? ticks : BLINK_PULSE_MAX_TICKS;
+        pattern->pulses[pattern->count++] = (blink_pulse_t){len, level};
+        ticks -= len;
+    }
+    return true;
+}
+
+// High time of one PWM period; squaring the brightness makes ramps look linear
+static uint32_t pwm_high_ticks(int brightness) {
+    return (uint32_t)(brightness * brightness) * BLINK_PWM_PERIOD_TICKS / (255 * 255);
+}
+
+static bool emit_step(blink_pattern_t *pattern, const blink_step_t *step) {
+    uint32_t ticks = (uint32_t)step->duration_ms * BLINK_TICK_HZ / 1000;
+
+    if (step->from == step->to && (step->from == 0 || step->from == 255)) {
+        return emit(pattern, step->from != 0, ticks);
+    }
+    uint32_t periods = (ticks + BLINK_PWM_PERIOD_TICKS / 2) / BLINK_PWM_PERIOD_TICKS;
+    periods = periods ? periods : 1;
+    for (uint32_t k = 0; k < periods; k++) {
+        // Brightness at the middle of the period
+        int brightness = step->from + ((int)step->to - step->from) * (int)(2 * k + 1) / (int)(2 * periods);
+        uint32_t high = pwm_high_ticks(brightness);
+        if (!emit(pattern, 1, high) || !emit(pattern, 0, BLINK_PWM_PERIOD_TICKS - high)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t blink_pattern_compile(const blink_step_t *steps, size_t step_count, blink_pattern_t *pattern) {
+    pattern->count = 0;
+    for (size_t i = 0; i < step_count; i++) {
+        if (!emit_step(pattern, &steps[i])) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+    if (pattern->count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // RMT symbols hold pulses in pairs: split the longest pulse to even the count
+    if (pattern->count % 2) {
+        size_t longest = 0;
+        for (size_t i = 1; i < pattern->count; i++) {
+            if (pattern->pulses[i].ticks > pattern->pulses[longest].ticks) {
+                longest = i;
+            }
+        }
+        if (pattern->count == BLINK_PATTERN_MAX_PULSES || pattern->pulses[longest].ticks < 2) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        blink_pulse_t *pulse = &pattern->pulses[longest];
+        memmove(pulse + 1, pulse, (pattern->count - longest) * sizeof(*pulse));
+        pulse[0].ticks /= 2;
+        pulse[1].ticks -= pulse[0].ticks;
+        pattern->count++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t blink_pattern_code(unsigned code, blink_pattern_t *pattern) {
+    blink_step_t steps[2 * BLINK_CODE_MAX + 1];
+    size_t count = 0;
+
+    if (code == 0 || code > BLINK_CODE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (unsigned i = 0; i < code; i++) {
+        steps[count++] = (blink_step_t){255, 255, BLINK_CODE_ON_MS};
+        steps[count++] = (blink_step_t){0, 0, BLINK_CODE_OFF_MS};
+    }
+    steps[count++] = (blink_step_t){0, 0, BLINK_CODE_PAUSE_MS};
+    return blink_pattern_compile(steps, count, pattern);
+}
+
+uint32_t blink_pattern_period_ticks(const blink_pattern_t *pattern) {
+    uint32_t ticks = 0;
+    for (size_t i = 0; i < pattern->count; i++) {
+        ticks += pattern->pulses[i].ticks;
+    }
+    return ticks;
+}
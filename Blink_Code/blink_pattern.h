@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define BLINK_TICK_HZ 10000          // Timeline resolution, one tick is 100 us
+#define BLINK_PWM_PERIOD_TICKS 100   // Dim levels and ramps are rendered as 100 Hz PWM
+#define BLINK_PULSE_MAX_TICKS 32767  // Longest level one RMT symbol half can hold
+#define BLINK_PATTERN_MAX_PULSES 512 // Two per RMT symbol; smaller chips loop fewer, see blink_rmt_max_pulses
+
+// One step of a pattern description: brightness goes from `from` to `to` (0-255)
+// over `duration_ms`. Equal values hold a level; 0 and 255 are plain off and on.
+typedef struct {
+    uint8_t from;
+    uint8_t to;
+    uint16_t duration_ms;
+} blink_step_t;
+
+// The output stays at `level` for `ticks`
+typedef struct {
+    uint16_t ticks;
+    uint8_t level;
+} blink_pulse_t;
+
+// Compiled pattern: the edge timeline of one period, looped by the hardware.
+// Adjacent equal levels are merged and the pulse count is always even.
+typedef struct {
+    size_t count;
+    blink_pulse_t pulses[BLINK_PATTERN_MAX_PULSES];
+} blink_pattern_t;
+
+// Compile `steps` into a timeline. Ramps and dim levels cost two pulses per PWM
+// period, so a description that does not fit gives ESP_ERR_INVALID_SIZE; an
+// empty one gives ESP_ERR_INVALID_ARG. Pure function, no hardware access.
+esp_err_t blink_pattern_compile(const blink_step_t *steps, size_t step_count, blink_pattern_t *pattern);
+
+// Blink code: `code` short flashes (1-15) followed by a pause
+esp_err_t blink_pattern_code(unsigned code, blink_pattern_t *pattern);
+
+// Length of one period of the pattern in ticks
+uint32_t blink_pattern_period_ticks(const blink_pattern_t *pattern);
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "blink_rmt.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#define BLINK_RMT_SYMBOLS (BLINK_PATTERN_MAX_PULSES / 2)
+
+// Host simulation: there is no RMT peripheral, so log one period of the timeline
+#define BLINK_LOG_PULSES 16
+
+static int blink_pin;
+
+esp_err_t blink_rmt_init(int pin) {
+    blink_pin = pin;
+    return ESP_OK;
+}
+
+size_t blink_rmt_max_pulses(void) {
+    return 2 * BLINK_RMT_SYMBOLS;
+}
+
+esp_err_t blink_rmt_play(const blink_pattern_t *pattern) {
+    if (pattern->count > 2 * BLINK_RMT_SYMBOLS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    printf("[GPIO %d]> pattern of %u pulses, %lu ms period\n", blink_pin, (unsigned)pattern->count,
+           (unsigned long)(blink_pattern_period_ticks(pattern) * 1000 / BLINK_TICK_HZ));
+    for (size_t i = 0; i < pattern->count && i < BLINK_LOG_PULSES; i++) {
+        printf("[GPIO %d]> %u for %u us\n", blink_pin, pattern->pulses[i].level,
+               (unsigned)pattern->pulses[i].ticks * (1000000 / BLINK_TICK_HZ));
+    }
+    return ESP_OK;
+}
+
+esp_err_t blink_rmt_stop(void) {
+    printf("[GPIO %d]> 0\n", blink_pin);
+    return ESP_OK;
+}
+#else
+#include <sys/param.h>
+#include "driver/rmt_tx.h"
+#include "soc/soc_caps.h"
+
+// Loop mode replays the channel memory, so a pattern must fit in it. A channel
+// can take the blocks of the TX channels after it: 512 words on the ESP32,
+// 96 on the C3 and 192 on the S3. Blink has the RMT to itself.
+#define BLINK_RMT_SYMBOLS MIN(BLINK_PATTERN_MAX_PULSES / 2, \
+                              SOC_RMT_MEM_WORDS_PER_CHANNEL * SOC_RMT_TX_CANDIDATES_PER_GROUP)
+
+// The ESP32 APB clock cannot be divided down to 10 kHz, the 1 MHz REF_TICK can
+#if CONFIG_IDF_TARGET_ESP32
+#define BLINK_RMT_CLK_SRC RMT_CLK_SRC_REF_TICK
+#else
+#define BLINK_RMT_CLK_SRC RMT_CLK_SRC_DEFAULT
+#endif
+
+static const char *TAG = "blink_rmt";
+
+static rmt_channel_handle_t blink_channel;
+static rmt_encoder_handle_t blink_encoder;
+static rmt_symbol_word_t blink_symbols[BLINK_RMT_SYMBOLS];
+static bool blink_running;
+
+esp_err_t blink_rmt_init(int pin) {
+    const rmt_tx_channel_config_t channel_config = {
+        .gpio_num = pin,
+        .clk_src = BLINK_RMT_CLK_SRC,
+        .resolution_hz = BLINK_TICK_HZ,
+        .mem_block_symbols = BLINK_RMT_SYMBOLS,
+        .trans_queue_depth = 1,
+    };
+    esp_err_t err = rmt_new_tx_channel(&channel_config, &blink_channel);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No RMT channel for GPIO %d: %s", pin, esp_err_to_name(err));
+        return err;
+    }
+    const rmt_copy_encoder_config_t encoder_config = {};
+    err = rmt_new_copy_encoder(&encoder_config, &blink_encoder);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return rmt_enable(blink_channel);
+}
+
+size_t blink_rmt_max_pulses(void) {
+    return 2 * BLINK_RMT_SYMBOLS;
+}
+
+esp_err_t blink_rmt_play(const blink_pattern_t *pattern) {
+    const rmt_transmit_config_t transmit_config = {
+        .loop_count = -1, // Repeat until the next play or stop
+        .flags.eot_level = 0,
+    };
+
+    if (pattern->count > 2 * BLINK_RMT_SYMBOLS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    blink_rmt_stop();
+    for (size_t i = 0; i < pattern->count / 2; i++) {
+        const blink_pulse_t *pulse = &pattern->pulses[2 * i];
+        blink_symbols[i] = (rmt_symbol_word_t){
+            .duration0 = pulse[0].ticks,
+            .level0 = pulse[0].level,
+            .duration1 = pulse[1].ticks,
+            .level1 = pulse[1].level,
+        };
+    }
+    rmt_encoder_reset(blink_encoder);
+    esp_err_t err = rmt_transmit(blink_channel, blink_encoder, blink_symbols,
+                                 pattern->count / 2 * sizeof(rmt_symbol_word_t), &transmit_config);
+    blink_running = err == ESP_OK;
+    return err;
+}
+
+esp_err_t blink_rmt_stop(void) {
+    if (!blink_running) {
+        return ESP_OK;
+    }
+    // Disabling aborts the looping transaction and the pin returns to the idle level
+    blink_running = false;
+    rmt_disable(blink_channel);
+    return rmt_enable(blink_channel);
+}
+#endif
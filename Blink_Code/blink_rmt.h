@@ -0,0 +1,20 @@
+#pragma once
+
+#include "sdkconfig.h"
+#include "blink_pattern.h"
+
+// Pattern player: an RMT TX channel in loop mode drives the LED pin from a
+// compiled timeline, so once a pattern starts the hardware repeats it with no
+// task or timer wakeups. On the linux target the timeline is logged instead.
+esp_err_t blink_rmt_init(int pin);
+
+// Most pulses a pattern may have on this target, at most BLINK_PATTERN_MAX_PULSES.
+// Chips with less RMT memory than the ESP32 cannot loop the longest patterns.
+size_t blink_rmt_max_pulses(void);
+
+// Replace the running pattern, takes effect at once. `pattern` is copied.
+// ESP_ERR_INVALID_SIZE if it has more than blink_rmt_max_pulses() pulses.
+esp_err_t blink_rmt_play(const blink_pattern_t *pattern);
+
+// Stop the pattern and leave the LED off
+esp_err_t blink_rmt_stop(void);
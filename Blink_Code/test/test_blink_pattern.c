@@ -0,0 +1,182 @@
+// Host test for the pattern compiler: checks the generated edge timelines.
+// Build and run from the project directory:
+//
+//   gcc -std=gnu11 -O2 -Itest/host -I. test/test_blink_pattern.c blink_pattern.c -o /tmp/test_blink_pattern && /tmp/test_blink_pattern
+#include <stdio.h>
+#include <stdlib.h>
+#include "blink_pattern.h"
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+#define STEP_COUNT(steps) (sizeof(steps) / sizeof(steps[0]))
+#define MS(ms) ((ms) * BLINK_TICK_HZ / 1000)
+
+// Compiled patterns are large, keep them off the stack
+static blink_pattern_t pattern;
+
+// Invariants of every timeline: an even pulse count, pulses of 1 to 32767 ticks,
+// and levels that alternate. A run of one level is only split into as many
+// pulses as 32767 ticks each need, plus one extra split in the whole timeline
+// to even the count.
+static void check_timeline(const blink_pattern_t *p, uint32_t period_ticks) {
+    size_t extra_splits = 0;
+
+    CHECK(p->count > 0 && p->count % 2 == 0);
+    CHECK(p->count <= BLINK_PATTERN_MAX_PULSES);
+    for (size_t i = 0; i < p->count;) {
+        size_t run = 0;
+        uint32_t run_ticks = 0;
+        for (; i + run < p->count && p->pulses[i + run].level == p->pulses[i].level; run++) {
+            CHECK(p->pulses[i + run].ticks >= 1 && p->pulses[i + run].ticks <= BLINK_PULSE_MAX_TICKS);
+            CHECK(p->pulses[i + run].level <= 1);
+            run_ticks += p->pulses[i + run].ticks;
+        }
+        extra_splits += run - (run_ticks + BLINK_PULSE_MAX_TICKS - 1) / BLINK_PULSE_MAX_TICKS;
+        i += run;
+    }
+    CHECK(extra_splits <= 1);
+    CHECK(blink_pattern_period_ticks(p) == period_ticks);
+}
+
+static void check_pulse(const blink_pattern_t *p, size_t i, uint8_t level, uint16_t ticks) {
+    CHECK(p->pulses[i].level == level);
+    CHECK(p->pulses[i].ticks == ticks);
+}
+
+static void test_square_wave(void) {
+    const blink_step_t steps[] = {{255, 255, 1000}, {0, 0, 1000}};
+
+    CHECK(blink_pattern_compile(steps, STEP_COUNT(steps), &pattern) == ESP_OK);
+    check_timeline(&pattern, MS(2000));
+    CHECK(pattern.count == 2);
+    check_pulse(&pattern, 0, 1, MS(1000));
+    check_pulse(&pattern, 1, 0, MS(1000));
+}
+
+// Adjacent steps at the same level merge into one pulse
+static void test_merge(void) {
+    const blink_step_t steps[] = {{255, 255, 100}, {255, 255, 200}, {0, 0, 300}, {0, 0, 400}};
+
+    CHECK(blink_pattern_compile(steps, STEP_COUNT(steps), &pattern) == ESP_OK);
+    check_timeline(&pattern, MS(1000));
+    CHECK(pattern.count == 2);
+    check_pulse(&pattern, 0, 1, MS(300));
+    check_pulse(&pattern, 1, 0, MS(700));
+}
+
+// An odd pulse count is evened by halving the longest pulse
+static void test_odd_count(void) {
+    const blink_step_t steps[] = {{255, 255, 100}, {0, 0, 300}, {255, 255, 100}};
+
+    CHECK(blink_pattern_compile(steps, STEP_COUNT(steps), &pattern) == ESP_OK);
+    check_timeline(&pattern, MS(500));
+    CHECK(pattern.count == 4);
+    check_pulse(&pattern, 0, 1, MS(100));
+    check_pulse(&pattern, 1, 0, MS(150));
+    check_pulse(&pattern, 2, 0, MS(150));
+    check_pulse(&pattern, 3, 1, MS(100));
+}
+
+// A level longer than one RMT symbol half is split at 32767 ticks
+static void test_long_pulse_split(void) {
+    const blink_step_t steps[] = {{255, 255, 5000}, {0, 0, 6000}};
+
+    CHECK(blink_pattern_compile(steps, STEP_COUNT(steps), &pattern) == ESP_OK);
+    check_timeline(&pattern, MS(11000));
+    CHECK(pattern.count == 4);
+    check_pulse(&pattern, 0, 1, BLINK_PULSE_MAX_TICKS);
+    check_pulse(&pattern, 1, 1, MS(5000) - BLINK_PULSE_MAX_TICKS);
+    check_pulse(&pattern, 2, 0, BLINK_PULSE_MAX_TICKS);
+    check_pulse(&pattern, 3, 0, MS(6000) - BLINK_PULSE_MAX_TICKS);
+
+    // Two pulses cover 65530 ticks on, and evening the count splits the first of them
+    const blink_step_t exact[] = {{255, 255, 6553}, {0, 0, 100}};
+    CHECK(blink_pattern_compile(exact, STEP_COUNT(exact), &pattern) == ESP_OK);
+    check_timeline(&pattern, MS(6553) + MS(100));
+    CHECK(pattern.count == 4);
+    check_pulse(&pattern, 0, 1, BLINK_PULSE_MAX_TICKS / 2);
+    check_pulse(&pattern, 1, 1, BLINK_PULSE_MAX_TICKS - BLINK_PULSE_MAX_TICKS / 2);
+    check_pulse(&pattern, 2, 1, MS(6553) - BLINK_PULSE_MAX_TICKS);
+    check_pulse(&pattern, 3, 0, MS(100));
+}
+
+// Dim levels become PWM periods of the same high time
+static void test_dim_level(void) {
+    const blink_step_t steps[] = {{128, 128, 50}};
+
+    CHECK(blink_pattern_compile(steps, STEP_COUNT(steps), &pattern) == ESP_OK);
+    check_timeline(&pattern, MS(50));
+    CHECK(pattern.count == 2 * MS(50) / BLINK_PWM_PERIOD_TICKS);
+    for (size_t i = 0; i < pattern.count; i += 2) {
+        check_pulse(&pattern, i, 1, 25);
+        check_pulse(&pattern, i + 1, 0, BLINK_PWM_PERIOD_TICKS - 25);
+    }
+}
+
+// A ramp brightens period by period; the breathe demo needs 434 pulses
+static void test_breathe(void) {
+    const blink_step_t steps[] = {{0, 255, 1200}, {255, 0, 1200}, {0, 0, 400}};
+    uint16_t last_high = 0;
+
+    CHECK(blink_pattern_compile(steps, STEP_COUNT(steps), &pattern) == ESP_OK);
+    check_timeline(&pattern, MS(2800));
+    CHECK(pattern.count == 434);
+
+    // High time of each PWM period on the way up never drops
+    uint32_t ticks = 0;
+    for (size_t i = 0; i < pattern.count && ticks < MS(1200); i++) {
+        if (pattern.pulses[i].level == 1 && pattern.pulses[i].ticks < BLINK_PWM_PERIOD_TICKS) {
+            CHECK(pattern.pulses[i].ticks >= last_high);
+            last_high = pattern.pulses[i].ticks;
+        }
+        ticks += pattern.pulses[i].ticks;
+    }
+    CHECK(last_high > BLINK_PWM_PERIOD_TICKS * 9 / 10);
+}
+
+static void test_code(void) {
+    CHECK(blink_pattern_code(3, &pattern) == ESP_OK);
+    check_timeline(&pattern, 3 * MS(200 + 300) + MS(1500));
+    CHECK(pattern.count == 6);
+    for (size_t i = 0; i < 4; i += 2) {
+        check_pulse(&pattern, i, 1, MS(200));
+        check_pulse(&pattern, i + 1, 0, MS(300));
+    }
+    check_pulse(&pattern, 4, 1, MS(200));
+    check_pulse(&pattern, 5, 0, MS(300 + 1500));
+
+    CHECK(blink_pattern_code(1, &pattern) == ESP_OK);
+    check_timeline(&pattern, MS(200 + 300 + 1500));
+    CHECK(blink_pattern_code(15, &pattern) == ESP_OK);
+    check_timeline(&pattern, 15 * MS(200 + 300) + MS(1500));
+    CHECK(blink_pattern_code(0, &pattern) == ESP_ERR_INVALID_ARG);
+    CHECK(blink_pattern_code(16, &pattern) == ESP_ERR_INVALID_ARG);
+}
+
+static void test_errors(void) {
+    const blink_step_t nothing[] = {{255, 255, 0}};
+    const blink_step_t too_long[] = {{0, 255, 1500}, {255, 0, 1500}};
+
+    CHECK(blink_pattern_compile(NULL, 0, &pattern) == ESP_ERR_INVALID_ARG);
+    CHECK(blink_pattern_compile(nothing, STEP_COUNT(nothing), &pattern) == ESP_ERR_INVALID_ARG);
+    CHECK(blink_pattern_compile(too_long, STEP_COUNT(too_long), &pattern) == ESP_ERR_INVALID_SIZE);
+}
+
+int main(void) {
+    test_square_wave();
+    test_merge();
+    test_odd_count();
+    test_long_pulse_split();
+    test_dim_level();
+    test_breathe();
+    test_code();
+    test_errors();
+    printf("blink_pattern: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "esp_log.h"
+#include "dht11_rmt.h"
+
+#define START_SIGNAL_US 20000     // Host holds the line low for at least 18 ms
+#define RMT_RESOLUTION_HZ 1000000 // 1 us per tick
+#define RMT_GLITCH_NS 1000
+#define RMT_IDLE_NS 200000        // Line high this long means the frame is over
+
+#if CONFIG_IDF_TARGET_LINUX
+// Host simulation: synthesize a slowly drifting reading, offset per pin, and capture it instantly
+esp_err_t dht11_rmt_init(dht11_rmt_t *sensor, int pin) {
+    sensor->pin = pin;
+    sensor->done = xQueueCreate(1, sizeof(size_t));
+    return sensor->done ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t dht11_rmt_select_pin(dht11_rmt_t *sensor, int pin) {
+    sensor->pin = pin;
+    return ESP_OK;
+}
+
+esp_err_t dht11_rmt_start(dht11_rmt_t *sensor) {
+    static int step = 0;
+    step = (step + 1) % 20;
+    dht11_reading_t reading = {
+        .temperature = 22.0f + step / 10.0f + sensor->pin % 8,
+        .humidity = 45.0f + step / 4.0f,
+    };
+    size_t count = dht11_encode(&reading, sensor->pulses);
+    xQueueOverwrite(sensor->done, &count);
+    return ESP_OK;
+}
+
+esp_err_t dht11_rmt_wait(dht11_rmt_t *sensor, dht11_reading_t *reading, TickType_t timeout) {
+    size_t count;
+    if (xQueueReceive(sensor->done, &count, timeout) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return dht11_decode(sensor->pulses, count, reading);
+}
+#else
+#include "driver/gpio.h"
+#include "esp_rom_gpio.h"
+#include "soc/gpio_struct.h"
+#include "soc/rmt_periph.h"
+
+static const char *TAG = "dht11_rmt";
+
+static bool IRAM_ATTR dht11_rx_done(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *event, void *arg) {
+    dht11_rmt_t *sensor = arg;
+    BaseType_t woken = pdFALSE;
+    size_t count = event->num_symbols;
+    xQueueSendFromISR(sensor->done, &count, &woken);
+    return woken == pdTRUE;
+}
+
+// End of the start signal: arm the receiver, then let the line go so the sensor can answer
+static void dht11_release_line(void *arg) {
+    dht11_rmt_t *sensor = arg;
+    const rmt_receive_config_t receive_config = {
+        .signal_range_min_ns = RMT_GLITCH_NS,
+        .signal_range_max_ns = RMT_IDLE_NS,
+    };
+    rmt_receive(sensor->channel, sensor->symbols, sizeof(sensor->symbols), &receive_config);
+    gpio_set_level(sensor->pin, 1);
+}
+
+// The RMT only listens, the host drives the start signal through the open-drain output
+static void dht11_setup_line(int pin) {
+    gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+    gpio_set_level(pin, 1);
+}
+
+// The driver does not expose the channel's index, so find the RMT RX input the
+// GPIO matrix routes from `pin` right after the channel was created on it
+static int dht11_find_rx_signal(int pin) {
+    for (int i = 0; i < SOC_RMT_CHANNELS_PER_GROUP; i++) {
+        int signal = rmt_periph_signals.groups[0].channels[i].rx_sig;
+        if (signal >= 0 && GPIO.func_in_sel_cfg[signal].sig_in_sel &&
+            GPIO.func_in_sel_cfg[signal].func_sel == pin) {
+            return signal;
+        }
+    }
+    return -1;
+}
+
+// Create the RX channel on `pin` and set the line up as an open-drain output idling high
+static esp_err_t dht11_attach(dht11_rmt_t *sensor, int pin) {
+    const rmt_rx_channel_config_t channel_config = {
+        .gpio_num = pin,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT11_RMT_SYMBOLS,
+    };
+    esp_err_t err = rmt_new_rx_channel(&channel_config, &sensor->channel);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No RMT channel for GPIO %d: %s", pin, esp_err_to_name(err));
+        sensor->channel = NULL;
+        return err;
+    }
+    const rmt_rx_event_callbacks_t callbacks = {
+        .on_recv_done = dht11_rx_done,
+    };
+    rmt_rx_register_event_callbacks(sensor->channel, &callbacks, sensor);
+    rmt_enable(sensor->channel);
+
+    dht11_setup_line(pin);
+    sensor->rx_signal = dht11_find_rx_signal(pin);
+    sensor->pin = pin;
+    return ESP_OK;
+}
+
+esp_err_t dht11_rmt_init(dht11_rmt_t *sensor, int pin) {
+    sensor->done = xQueueCreate(1, sizeof(size_t));
+    if (sensor->done == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = dht11_attach(sensor, pin);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = dht11_release_line,
+        .arg = sensor,
+        .name = "dht11_start",
+    };
+    return esp_timer_create(&timer_args, &sensor->start_timer);
+}
+
+esp_err_t dht11_rmt_select_pin(dht11_rmt_t *sensor, int pin) {
+    if (pin == sensor->pin && sensor->channel != NULL) {
+        return ESP_OK;
+    }
+
+    // Reads never overlap, so the channel is idle: switch its input to the new
+    // line. The previous line stays an open-drain output idling high.
+    if (sensor->channel != NULL && sensor->rx_signal >= 0) {
+        dht11_setup_line(pin);
+        esp_rom_gpio_connect_in_signal(pin, sensor->rx_signal, false);
+        sensor->pin = pin;
+        return ESP_OK;
+    }
+
+    // Fallback when the input signal is unknown: recreate the channel on the pin
+    if (sensor->channel != NULL) {
+        rmt_disable(sensor->channel);
+        rmt_del_channel(sensor->channel);
+        sensor->channel = NULL;
+    }
+    return dht11_attach(sensor, pin);
+}
+
+esp_err_t dht11_rmt_start(dht11_rmt_t *sensor) {
+    if (sensor->channel == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xQueueReset(sensor->done);
+    gpio_set_level(sensor->pin, 0);
+    return esp_timer_start_once(sensor->start_timer, START_SIGNAL_US);
+}
+
+esp_err_t dht11_rmt_wait(dht11_rmt_t *sensor, dht11_reading_t *reading, TickType_t timeout) {
+    size_t symbols;
+    if (sensor->channel == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xQueueReceive(sensor->done, &symbols, timeout) != pdTRUE) {
+        // Abort the pending receive so the next start can re-arm it
+        esp_timer_stop(sensor->start_timer);
+        rmt_disable(sensor->channel);
+        rmt_enable(sensor->channel);
+        gpio_set_level(sensor->pin, 1);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < symbols; i++) {
+        const rmt_symbol_word_t *symbol = &sensor->symbols[i];
+        sensor->pulses[count++] = (dht11_pulse_t){symbol->level0, symbol->duration0};
+        if (symbol->duration1) {
+            sensor->pulses[count++] = (dht11_pulse_t){symbol->level1, symbol->duration1};
+        }
+    }
+    return dht11_decode(sensor->pulses, count, reading);
+}
+#endif
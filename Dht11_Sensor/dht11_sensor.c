@@ -1,23 +1,85 @@
+#include <stdio.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <driver/gpio.h>
-#include "esp32-dht11.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dht11_rmt.h"
+#include "sensor_log.h"
+#include "low_power.h"
 
-#define CONFIG_DHT11_PIN GPIO_NUM_4
-#define CONFIG_CONNECTION_TIMEOUT 5
+#define CONFIG_DHT11_PIN 4
+#define CONFIG_READ_TIMEOUT_MS 100
+#define CONFIG_SAMPLE_PERIOD_MS 2000 // Light sleep between samples
+#define CONFIG_SAMPLE_BATCH 5        // Readings collected before printing, 1 prints each one
+
+static const char *TAG = "dht11_sensor";
+
+// Print the batched readings and the power counters in one burst of UART activity
+static void print_batch(const dht11_reading_t *batch, size_t count)
+{
+  low_power_stats_t stats;
+  low_power_get_stats(&stats);
+  for (size_t i = 0; i < count; i++)
+  {
+    printf("[Temperature]> %.2f \n",batch[i].temperature);
+    printf("[Humidity]> %.2f \n",batch[i].humidity);
+  }
+  uint64_t total_us = stats.awake_us + stats.sleep_us;
+  printf("[Power]> samples %lu, wakeups %lu (%lu early), awake %llu us/sample, sleep %llu.%llu%%, ~%lu uJ/sample\n",
+         (unsigned long)stats.samples, (unsigned long)stats.wakeups, (unsigned long)stats.early_wakeups,
+         (unsigned long long)(stats.samples ? stats.awake_us / stats.samples : 0),
+         (unsigned long long)(total_us ? stats.sleep_us * 100 / total_us : 0),
+         (unsigned long long)(total_us ? stats.sleep_us * 1000 / total_us % 10 : 0),
+         (unsigned long)low_power_energy_per_sample_uj(&stats));
+}
 
 void app_main() {
-    dht11_t dht11_sensor;
-    dht11_sensor.dht11_pin = CONFIG_DHT11_PIN;
+    static dht11_rmt_t dht11_sensor;
+    dht11_reading_t reading;
+    esp_err_t err = dht11_rmt_init(&dht11_sensor, CONFIG_DHT11_PIN);
+    if (err != ESP_OK)
+    {
+      // Nothing to sample without the RMT channel
+      ESP_LOGE(TAG, "DHT11 on GPIO %d unavailable: %s", CONFIG_DHT11_PIN, esp_err_to_name(err));
+      vTaskDelete(NULL);
+    }
 
-    // Read data
+    // Report what survived the last reboot
+    if (sensor_log_init() == ESP_OK)
+    {
+      sensor_log_reader_t reader;
+      sensor_log_record_t record;
+      uint32_t count = 0;
+      sensor_log_reader_init(&reader);
+      while (sensor_log_read_next(&reader, &record))
+      {
+        count++;
+      }
+      printf("[Log]> %lu stored readings\n", (unsigned long)count);
+    }
+
+    // Read data on a fixed schedule, in light sleep between samples
+    dht11_reading_t batch[CONFIG_SAMPLE_BATCH];
+    size_t batch_count = 0;
+    low_power_init();
+    int64_t next_sample_us = esp_timer_get_time();
     while(1)
     {
-      if(!dht11_read(&dht11_sensor, CONFIG_CONNECTION_TIMEOUT))
-      {  
-        printf("[Temperature]> %.2f \n",dht11_sensor.temperature);
-        printf("[Humidity]> %.2f \n",dht11_sensor.humidity);
+      // The capture runs in hardware, the CPU is idle until it completes
+      dht11_rmt_start(&dht11_sensor);
+      if(!dht11_rmt_wait(&dht11_sensor, &reading, pdMS_TO_TICKS(CONFIG_READ_TIMEOUT_MS)))
+      {
+        batch[batch_count++] = reading;
+        sensor_log_append(esp_timer_get_time() / 1000000, reading.temperature, reading.humidity);
+      }
+      low_power_sample_done();
+      if (batch_count == CONFIG_SAMPLE_BATCH)
+      {
+        print_batch(batch, batch_count);
+        batch_count = 0;
       }
-      vTaskDelay(2000 / portTICK_PERIOD_MS);
-    } 
+      next_sample_us += CONFIG_SAMPLE_PERIOD_MS * 1000LL;
+      low_power_sleep_until(next_sample_us);
+    }
 }
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "low_power.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_sleep.h"
+#include "driver/uart.h"
+#endif
+
+// Only the sampling task touches these
+static low_power_stats_t stats;
+static int64_t awake_since_us;
+
+void low_power_init(void) {
+    stats = (low_power_stats_t){0};
+    awake_since_us = esp_timer_get_time();
+}
+
+void low_power_sample_done(void) {
+    stats.samples++;
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+static bool sleep_once(uint64_t duration_us) {
+    vTaskDelay(pdMS_TO_TICKS(duration_us / 1000));
+    return true;
+}
+#else
+// Returns false when something other than the timer ended the sleep
+static bool sleep_once(uint64_t duration_us) {
+    // The UART clock stops in light sleep, let pending output drain first
+    fflush(stdout);
+    uart_wait_tx_idle_polling(CONFIG_ESP_CONSOLE_UART_NUM);
+    esp_sleep_enable_timer_wakeup(duration_us);
+    esp_light_sleep_start();
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+}
+#endif
+
+void low_power_sleep_until(int64_t wake_at_us) {
+    int64_t now = esp_timer_get_time();
+    stats.awake_us += now - awake_since_us;
+
+    while (now < wake_at_us) {
+        bool timer = sleep_once(wake_at_us - now);
+        int64_t woke = esp_timer_get_time();
+        stats.sleep_us += woke - now;
+        stats.wakeups++;
+        stats.early_wakeups += !timer;
+        now = woke;
+    }
+    awake_since_us = now;
+}
+
+void low_power_get_stats(low_power_stats_t *out) {
+    *out = stats;
+    out->awake_us += esp_timer_get_time() - awake_since_us;
+}
+
+uint32_t low_power_energy_per_sample_uj(const low_power_stats_t *s) {
+    if (s->samples == 0) {
+        return 0;
+    }
+    // uA * us * mV is 1e-15 J; average per sample first so the product stays in range
+    uint64_t awake_us = s->awake_us / s->samples;
+    uint64_t sleep_us = s->sleep_us / s->samples;
+    uint64_t charge = awake_us * LOW_POWER_ACTIVE_UA + sleep_us * LOW_POWER_SLEEP_UA;
+    return charge * LOW_POWER_SUPPLY_MV / 1000000000;
+}
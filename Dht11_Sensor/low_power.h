@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Current draw used for the energy estimate, measure the board to tune these
+#define LOW_POWER_ACTIVE_UA 40000 // CPU on at 80-160 MHz, radio off
+#define LOW_POWER_SLEEP_UA 800    // Light sleep, RTC timer running
+#define LOW_POWER_SUPPLY_MV 3300
+
+// Counters since low_power_init(). Awake time is everything not spent in light sleep.
+typedef struct {
+    uint32_t samples;
+    uint32_t wakeups;       // Returns from light sleep
+    uint32_t early_wakeups; // Woken by something other than the timer
+    uint64_t awake_us;
+    uint64_t sleep_us;
+} low_power_stats_t;
+
+// Start counting; the caller is awake from here
+void low_power_init(void);
+
+// Count one completed sample
+void low_power_sample_done(void);
+
+// Enter light sleep until esp_timer time `wake_at_us`, going back to sleep after
+// early wakeups. Returns at once if that time has passed. On the linux target the
+// task just sleeps, so the same counters can be exercised on the host.
+void low_power_sleep_until(int64_t wake_at_us);
+
+void low_power_get_stats(low_power_stats_t *stats);
+
+// Estimated energy per sample in microjoules from the counters above
+uint32_t low_power_energy_per_sample_uj(const low_power_stats_t *stats);
@@ -0,0 +1,459 @@
+#include <stdio.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sensor_log.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_partition.h"
+#endif
+
+// Layout: the partition is a ring of sectors. Each sector starts with a header
+// {magic, seq, boot} and holds blocks of [len:2][crc8:1][payload]. A payload is the
+// boot number followed by a run of records, the first one absolute and the rest
+// deltas against the previous one, all as zigzag varints: time_s, temperature,
+// humidity. Erased flash (0xFF) ends a sector; a block whose length or CRC does not
+// check out was torn by a power loss.
+//
+// Nothing sets the clock, so times are seconds since boot and the boot number,
+// one more than the highest one found in the log at mount, tells boots apart.
+#define SECTOR_MAGIC 0x32474c53 // "SLG2"
+#define SECTOR_HEADER_SIZE 12
+#define BLOCK_HEADER_SIZE 3
+#define BLOCK_PAYLOAD_MAX (SENSOR_LOG_BATCH_SIZE - BLOCK_HEADER_SIZE)
+#define BLOCK_END 0xFFFF
+#define RECORD_MAX 20 // Boot number and three varints of at most five bytes each
+
+static const char *TAG = "sensor_log";
+
+static SemaphoreHandle_t log_lock;
+static uint32_t sector_count;
+static uint32_t cur_sector;
+static uint32_t cur_seq;
+static uint32_t write_offset;
+static uint32_t boot;
+
+// Block being filled, header bytes reserved up front so a flush is a single write
+static uint8_t batch[SENSOR_LOG_BATCH_SIZE];
+static size_t batch_len = BLOCK_HEADER_SIZE;
+static sensor_log_record_t batch_last;
+
+static sensor_log_stats_t stats;
+
+#if CONFIG_IDF_TARGET_LINUX
+// Host stand-in: a plain file with NOR-like erase semantics
+static FILE *log_file;
+
+static esp_err_t storage_erase(size_t offset, size_t len) {
+    uint8_t erased[64];
+    memset(erased, 0xFF, sizeof(erased));
+    fseek(log_file, offset, SEEK_SET);
+    for (size_t done = 0; done < len; done += sizeof(erased)) {
+        fwrite(erased, 1, sizeof(erased), log_file);
+    }
+    return fflush(log_file) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t storage_open(uint32_t *size) {
+    log_file = fopen(SENSOR_LOG_HOST_PATH, "r+b");
+    if (log_file == NULL) {
+        log_file = fopen(SENSOR_LOG_HOST_PATH, "w+b");
+        if (log_file == NULL) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        storage_erase(0, SENSOR_LOG_HOST_SIZE);
+    }
+    // A file cut short, e.g. by a crash during a copy, reads as erased flash past its end
+    fseek(log_file, 0, SEEK_END);
+    long file_size = ftell(log_file);
+    if (file_size >= 0 && file_size < SENSOR_LOG_HOST_SIZE) {
+        storage_erase(file_size, SENSOR_LOG_HOST_SIZE - file_size);
+    }
+    *size = SENSOR_LOG_HOST_SIZE;
+    return ESP_OK;
+}
+
+static esp_err_t storage_read(size_t offset, void *buf, size_t len) {
+    fseek(log_file, offset, SEEK_SET);
+    return fread(buf, 1, len, log_file) == len ? ESP_OK : ESP_FAIL;
+}
+
+// Programming NOR flash can only clear bits, so the new data is ANDed into what is there
+static esp_err_t storage_write(size_t offset, const void *buf, size_t len) {
+    const uint8_t *data = buf;
+    uint8_t chunk[64];
+
+    for (size_t done = 0; done < len; done += sizeof(chunk)) {
+        size_t n = len - done < sizeof(chunk) ? len - done : sizeof(chunk);
+        fseek(log_file, offset + done, SEEK_SET);
+        if (fread(chunk, 1, n, log_file) != n) {
+            return ESP_FAIL;
+        }
+        for (size_t i = 0; i < n; i++) {
+            chunk[i] &= data[done + i];
+        }
+        fseek(log_file, offset + done, SEEK_SET);
+        if (fwrite(chunk, 1, n, log_file) != n) {
+            return ESP_FAIL;
+        }
+    }
+    return fflush(log_file) == 0 ? ESP_OK : ESP_FAIL;
+}
+#else
+static const esp_partition_t *log_partition;
+
+static esp_err_t storage_open(uint32_t *size) {
+    log_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                             SENSOR_LOG_PARTITION_LABEL);
+    if (log_partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *size = log_partition->size;
+    return ESP_OK;
+}
+
+static esp_err_t storage_read(size_t offset, void *buf, size_t len) {
+    return esp_partition_read(log_partition, offset, buf, len);
+}
+
+static esp_err_t storage_write(size_t offset, const void *buf, size_t len) {
+    return esp_partition_write(log_partition, offset, buf, len);
+}
+
+static esp_err_t storage_erase(size_t offset, size_t len) {
+    return esp_partition_erase_range(log_partition, offset, len);
+}
+#endif
+
+static uint8_t crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static size_t put_varint(uint8_t *out, int32_t value) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    size_t len = 0;
+    while (zigzag >= 0x80) {
+        out[len++] = (zigzag & 0x7F) | 0x80;
+        zigzag >>= 7;
+    }
+    out[len++] = zigzag;
+    return len;
+}
+
+static bool get_varint(const uint8_t *in, size_t len, size_t *pos, int32_t *value) {
+    uint32_t zigzag = 0;
+    for (int shift = 0; shift < 35 && *pos < len; shift += 7) {
+        uint8_t byte = in[(*pos)++];
+        zigzag |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int16_t to_centi(float value) {
+    return (int16_t)(value * 100.0f + (value < 0 ? -0.5f : 0.5f));
+}
+
+struct sector_header {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t boot; // Boot that started the sector
+};
+
+static bool read_sector_header(uint32_t sector, struct sector_header *header) {
+    return storage_read(sector * SENSOR_LOG_SECTOR_SIZE, header, sizeof(*header)) == ESP_OK &&
+           header->magic == SECTOR_MAGIC;
+}
+
+static esp_err_t start_sector(uint32_t sector, uint32_t seq) {
+    struct sector_header header = {SECTOR_MAGIC, seq, boot};
+    esp_err_t err = storage_erase(sector * SENSOR_LOG_SECTOR_SIZE, SENSOR_LOG_SECTOR_SIZE);
+    if (err == ESP_OK) {
+        err = storage_write(sector * SENSOR_LOG_SECTOR_SIZE, &header, sizeof(header));
+    }
+    if (err == ESP_OK) {
+        stats.sectors_erased++;
+        cur_sector = sector;
+        cur_seq = seq;
+        write_offset = SECTOR_HEADER_SIZE;
+    }
+    return err;
+}
+
+// Read and verify the block at `offset`, returns its payload length or 0 at the end of the sector
+static size_t read_block(uint32_t sector, uint32_t offset, uint8_t *block) {
+    uint8_t *payload = block + BLOCK_HEADER_SIZE;
+    if (offset + BLOCK_HEADER_SIZE > SENSOR_LOG_SECTOR_SIZE ||
+        storage_read(sector * SENSOR_LOG_SECTOR_SIZE + offset, block, BLOCK_HEADER_SIZE) != ESP_OK) {
+        return 0;
+    }
+    size_t len = block[0] | block[1] << 8;
+    if (len == BLOCK_END || len == 0 || len > BLOCK_PAYLOAD_MAX ||
+        offset + BLOCK_HEADER_SIZE + len > SENSOR_LOG_SECTOR_SIZE ||
+        storage_read(sector * SENSOR_LOG_SECTOR_SIZE + offset + BLOCK_HEADER_SIZE, payload, len) != ESP_OK ||
+        crc8(payload, len) != block[2]) {
+        return 0;
+    }
+    return len;
+}
+
+esp_err_t sensor_log_init(void) {
+    uint32_t size;
+    esp_err_t err = storage_open(&size);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No '%s' partition", SENSOR_LOG_PARTITION_LABEL);
+        return err;
+    }
+    sector_count = size / SENSOR_LOG_SECTOR_SIZE;
+
+    // The newest sector is the one with the highest sequence number
+    struct sector_header header;
+    bool found = false;
+    for (uint32_t sector = 0; sector < sector_count; sector++) {
+        if (read_sector_header(sector, &header) && (!found || header.seq > cur_seq)) {
+            found = true;
+            cur_sector = sector;
+            cur_seq = header.seq;
+        }
+    }
+    if (!found) {
+        ESP_LOGI(TAG, "Formatting %lu sectors", (unsigned long)sector_count);
+        boot = 1;
+        err = start_sector(0, 1);
+        if (err == ESP_OK) {
+            log_lock = xSemaphoreCreateMutex();
+        }
+        return err;
+    }
+
+    // Walk the valid blocks; stop at erased flash or at a block torn by a power loss.
+    // The last boot is the newest sector's, or a later one its blocks carry.
+    read_sector_header(cur_sector, &header);
+    uint32_t last_boot = header.boot;
+    write_offset = SECTOR_HEADER_SIZE;
+    size_t len;
+    while ((len = read_block(cur_sector, write_offset, batch)) > 0) {
+        size_t pos = BLOCK_HEADER_SIZE;
+        int32_t block_boot;
+        if (get_varint(batch, BLOCK_HEADER_SIZE + len, &pos, &block_boot) && (uint32_t)block_boot > last_boot) {
+            last_boot = block_boot;
+        }
+        write_offset += BLOCK_HEADER_SIZE + len;
+    }
+    boot = last_boot + 1;
+    if (write_offset + BLOCK_HEADER_SIZE <= SENSOR_LOG_SECTOR_SIZE) {
+        uint8_t next[2];
+        storage_read(cur_sector * SENSOR_LOG_SECTOR_SIZE + write_offset, next, sizeof(next));
+        if (next[0] != 0xFF || next[1] != 0xFF) {
+            // Torn block, the rest of the sector cannot be programmed again before an erase
+            ESP_LOGW(TAG, "Discarding torn block in sector %lu", (unsigned long)cur_sector);
+            write_offset = SENSOR_LOG_SECTOR_SIZE;
+        }
+    }
+    ESP_LOGI(TAG, "Boot %lu, resuming at sector %lu offset %lu",
+             (unsigned long)boot, (unsigned long)cur_sector, (unsigned long)write_offset);
+    log_lock = xSemaphoreCreateMutex();
+    return ESP_OK;
+}
+
+static esp_err_t flush_locked(void) {
+    size_t payload_len = batch_len - BLOCK_HEADER_SIZE;
+    if (payload_len == 0) {
+        return ESP_OK;
+    }
+    if (write_offset + batch_len > SENSOR_LOG_SECTOR_SIZE) {
+        esp_err_t err = start_sector((cur_sector + 1) % sector_count, cur_seq + 1);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    batch[0] = payload_len & 0xFF;
+    batch[1] = payload_len >> 8;
+    batch[2] = crc8(batch + BLOCK_HEADER_SIZE, payload_len);
+    esp_err_t err = storage_write(cur_sector * SENSOR_LOG_SECTOR_SIZE + write_offset, batch, batch_len);
+    if (err == ESP_OK) {
+        stats.flushes++;
+        stats.bytes_written += batch_len;
+        write_offset += batch_len;
+        batch_len = BLOCK_HEADER_SIZE;
+    }
+    return err;
+}
+
+static size_t encode_record(uint8_t *out, const sensor_log_record_t *record, const sensor_log_record_t *prev) {
+    size_t len = 0;
+    if (prev == NULL) {
+        len += put_varint(out + len, (int32_t)boot);
+        len += put_varint(out + len, (int32_t)record->time_s);
+        len += put_varint(out + len, record->temperature);
+        len += put_varint(out + len, record->humidity);
+    } else {
+        len += put_varint(out + len, (int32_t)(record->time_s - prev->time_s));
+        len += put_varint(out + len, record->temperature - prev->temperature);
+        len += put_varint(out + len, record->humidity - prev->humidity);
+    }
+    return len;
+}
+
+esp_err_t sensor_log_append(uint32_t time_s, float temperature, float humidity) {
+    sensor_log_record_t record = {.time_s = time_s, .temperature = to_centi(temperature), .humidity = to_centi(humidity)};
+    uint8_t encoded[RECORD_MAX];
+    esp_err_t err = ESP_OK;
+
+    // The log stays unmounted if sensor_log_init failed
+    if (log_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    bool first = batch_len == BLOCK_HEADER_SIZE;
+    size_t len = encode_record(encoded, &record, first ? NULL : &batch_last);
+    if (batch_len + len > SENSOR_LOG_BATCH_SIZE) {
+        // Each block starts from an absolute record so it decodes on its own
+        err = flush_locked();
+        len = encode_record(encoded, &record, NULL);
+    }
+    if (err == ESP_OK) {
+        memcpy(batch + batch_len, encoded, len);
+        batch_len += len;
+        batch_last = record;
+        stats.samples++;
+    }
+    xSemaphoreGive(log_lock);
+    return err;
+}
+
+esp_err_t sensor_log_flush(void) {
+    if (log_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    esp_err_t err = flush_locked();
+    xSemaphoreGive(log_lock);
+    return err;
+}
+
+void sensor_log_get_stats(sensor_log_stats_t *out) {
+    if (log_lock == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    *out = stats;
+    out->pending_bytes = batch_len - BLOCK_HEADER_SIZE;
+    xSemaphoreGive(log_lock);
+}
+
+// Point the reader at the start of the oldest valid sector. Sectors are written
+// in ring order, so the oldest one follows the newest and the chain is followed
+// for as long as the sequence numbers are consecutive.
+static void seek_oldest_locked(sensor_log_reader_t *reader) {
+    struct sector_header header;
+    uint32_t oldest = cur_sector;
+    uint32_t oldest_seq = cur_seq;
+    for (uint32_t back = 1; back < sector_count; back++) {
+        uint32_t sector = (cur_sector + sector_count - back) % sector_count;
+        if (!read_sector_header(sector, &header) || header.seq != oldest_seq - 1) {
+            break;
+        }
+        oldest = sector;
+        oldest_seq = header.seq;
+    }
+    reader->sector = oldest;
+    reader->seq = oldest_seq;
+    reader->offset = SECTOR_HEADER_SIZE;
+}
+
+void sensor_log_reader_init(sensor_log_reader_t *reader) {
+    memset(reader, 0, sizeof(*reader));
+    if (log_lock == NULL) {
+        reader->pending_done = true;
+        return;
+    }
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    seek_oldest_locked(reader);
+    xSemaphoreGive(log_lock);
+}
+
+// Load the next block from flash, or the unflushed batch once flash is exhausted.
+// The writer keeps going while a reader runs: sectors it starts are read too, and
+// if it recycles the sector being read the reader skips ahead to the oldest
+// sector still there, losing only the records that were overwritten.
+static bool load_block(sensor_log_reader_t *reader) {
+    bool loaded = false;
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    while (!loaded && (int32_t)(cur_seq - reader->seq) >= 0) {
+        struct sector_header header;
+        if (!read_sector_header(reader->sector, &header) || header.seq != reader->seq) {
+            uint32_t stale_seq = reader->seq;
+            seek_oldest_locked(reader);
+            if (reader->seq == stale_seq) {
+                // Not recycled but unreadable, give up on flash
+                reader->seq = cur_seq + 1;
+            }
+            continue;
+        }
+        size_t len = read_block(reader->sector, reader->offset, reader->block);
+        if (len > 0) {
+            memmove(reader->block, reader->block + BLOCK_HEADER_SIZE, len);
+            reader->block_len = len;
+            reader->offset += BLOCK_HEADER_SIZE + len;
+            loaded = true;
+        } else {
+            reader->sector = (reader->sector + 1) % sector_count;
+            reader->seq++;
+            reader->offset = SECTOR_HEADER_SIZE;
+        }
+    }
+    if (!loaded && !reader->pending_done) {
+        reader->pending_done = true;
+        reader->block_len = batch_len - BLOCK_HEADER_SIZE;
+        memcpy(reader->block, batch + BLOCK_HEADER_SIZE, reader->block_len);
+        loaded = reader->block_len > 0;
+    }
+    xSemaphoreGive(log_lock);
+
+    reader->block_pos = 0;
+    return loaded;
+}
+
+bool sensor_log_read_next(sensor_log_reader_t *reader, sensor_log_record_t *record) {
+    if (reader->block_pos >= reader->block_len && !load_block(reader)) {
+        return false;
+    }
+
+    bool first = reader->block_pos == 0;
+    int32_t block_boot = 0, time_s, temperature, humidity;
+    if ((first && !get_varint(reader->block, reader->block_len, &reader->block_pos, &block_boot)) ||
+        !get_varint(reader->block, reader->block_len, &reader->block_pos, &time_s) ||
+        !get_varint(reader->block, reader->block_len, &reader->block_pos, &temperature) ||
+        !get_varint(reader->block, reader->block_len, &reader->block_pos, &humidity)) {
+        // Cannot happen for a block that passed its CRC, skip the rest of it
+        reader->block_pos = reader->block_len;
+        return sensor_log_read_next(reader, record);
+    }
+    if (first) {
+        reader->last.boot = (uint32_t)block_boot;
+        reader->last.time_s = (uint32_t)time_s;
+        reader->last.temperature = (int16_t)temperature;
+        reader->last.humidity = (int16_t)humidity;
+    } else {
+        reader->last.time_s += (uint32_t)time_s;
+        reader->last.temperature += (int16_t)temperature;
+        reader->last.humidity += (int16_t)humidity;
+    }
+    *record = reader->last;
+    return true;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+// Single-threaded host tests: just enough of the FreeRTOS types to compile
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdTRUE 1
+#define pdFALSE 0
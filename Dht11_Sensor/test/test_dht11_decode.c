@@ -0,0 +1,191 @@
+// Host harness for the DHT11 decoder: round trips every reading through
+// dht11_encode and dht11_decode, mutates pulse widths and counts, replays
+// captures and times the decoder. Build and run from the project directory:
+//
+//   gcc -std=gnu11 -O2 -Itest/host -I. test/test_dht11_decode.c dht11_decode.c -o /tmp/test_dht11_decode && /tmp/test_dht11_decode
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dht11_decode.h"
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+// Waveforms in the form dht11_rmt.c hands to the decoder: the pull-up between
+// the start signal and the response, per-edge jitter within the datasheet
+// tolerances and the final 50 us low before the line idles
+static const dht11_pulse_t capture_45rh_23c1[] = {
+    {1, 29}, {0, 86}, {1, 88}, {0, 55}, {1, 26}, {0, 56}, {1, 29}, {0, 51}, {1, 69}, {0, 56}, {1,
+    26}, {0, 50}, {1, 68}, {0, 55}, {1, 70}, {0, 50}, {1, 23}, {0, 56}, {1, 74}, {0, 48}, {1, 27},
+    {0, 54}, {1, 26}, {0, 50}, {1, 27}, {0, 48}, {1, 29}, {0, 56}, {1, 23}, {0, 48}, {1, 23}, {0,
+    51}, {1, 24}, {0, 48}, {1, 29}, {0, 55}, {1, 25}, {0, 55}, {1, 27}, {0, 51}, {1, 27}, {0, 51},
+    {1, 73}, {0, 52}, {1, 26}, {0, 48}, {1, 73}, {0, 49}, {1, 71}, {0, 52}, {1, 71}, {0, 56}, {1,
+    29}, {0, 49}, {1, 28}, {0, 52}, {1, 25}, {0, 51}, {1, 27}, {0, 52}, {1, 23}, {0, 49}, {1, 27},
+    {0, 49}, {1, 26}, {0, 49}, {1, 74}, {0, 52}, {1, 26}, {0, 49}, {1, 68}, {0, 48}, {1, 24}, {0,
+    51}, {1, 23}, {0, 55}, {1, 26}, {0, 54}, {1, 71}, {0, 49}, {1, 27}, {0, 51}, {1, 74}, {0, 55}
+};
+
+static const dht11_pulse_t capture_61rh_19c8[] = {
+    {1, 26}, {0, 82}, {1, 84}, {0, 52}, {1, 25}, {0, 48}, {1, 26}, {0, 49}, {1, 69}, {0, 51}, {1,
+    73}, {0, 49}, {1, 68}, {0, 48}, {1, 71}, {0, 55}, {1, 24}, {0, 56}, {1, 69}, {0, 55}, {1, 27},
+    {0, 51}, {1, 28}, {0, 50}, {1, 26}, {0, 54}, {1, 23}, {0, 54}, {1, 26}, {0, 51}, {1, 23}, {0,
+    52}, {1, 29}, {0, 52}, {1, 23}, {0, 51}, {1, 24}, {0, 54}, {1, 29}, {0, 49}, {1, 23}, {0, 50},
+    {1, 69}, {0, 55}, {1, 25}, {0, 48}, {1, 29}, {0, 53}, {1, 74}, {0, 52}, {1, 71}, {0, 49}, {1,
+    23}, {0, 49}, {1, 24}, {0, 51}, {1, 23}, {0, 53}, {1, 25}, {0, 55}, {1, 69}, {0, 55}, {1, 29},
+    {0, 50}, {1, 29}, {0, 54}, {1, 24}, {0, 50}, {1, 25}, {0, 51}, {1, 74}, {0, 51}, {1, 28}, {0,
+    51}, {1, 69}, {0, 56}, {1, 69}, {0, 54}, {1, 26}, {0, 49}, {1, 26}, {0, 48}, {1, 23}, {0, 50}
+};
+
+static int tenths(float value) {
+    return (int)(value * 10.0f + (value < 0 ? -0.5f : 0.5f));
+}
+
+static bool same_reading(const dht11_reading_t *a, const dht11_reading_t *b) {
+    return tenths(a->temperature) == tenths(b->temperature) && tenths(a->humidity) == tenths(b->humidity);
+}
+
+static void test_captures(void) {
+    dht11_reading_t reading;
+
+    CHECK(dht11_decode(capture_45rh_23c1, sizeof(capture_45rh_23c1) / sizeof(capture_45rh_23c1[0]), &reading) == ESP_OK);
+    CHECK(tenths(reading.humidity) == 450 && tenths(reading.temperature) == 231);
+    CHECK(dht11_decode(capture_61rh_19c8, sizeof(capture_61rh_19c8) / sizeof(capture_61rh_19c8[0]), &reading) == ESP_OK);
+    CHECK(tenths(reading.humidity) == 610 && tenths(reading.temperature) == 198);
+}
+
+// Every humidity from 0 to 99.9 % against every temperature from -50 to 50 C, in tenths
+static void test_round_trip(void) {
+    dht11_pulse_t pulses[DHT11_FRAME_PULSES];
+    dht11_reading_t in, out;
+    unsigned frames = 0;
+
+    for (int humidity = 0; humidity < 1000; humidity++) {
+        for (int temperature = -500; temperature <= 500; temperature++) {
+            in.humidity = humidity / 10.0f;
+            in.temperature = temperature / 10.0f;
+            CHECK(dht11_encode(&in, pulses) == DHT11_FRAME_PULSES);
+            CHECK(dht11_decode(pulses, DHT11_FRAME_PULSES, &out) == ESP_OK);
+            CHECK(tenths(out.humidity) == humidity && tenths(out.temperature) == temperature);
+            frames++;
+        }
+    }
+    printf("round trip: %u readings\n", frames);
+}
+
+// Any single pulse of any width, a dropped or an extra pulse, or a short frame
+// must give the original reading or an error, never a different reading
+static void test_mutations(void) {
+    const dht11_reading_t in = {.temperature = 23.1f, .humidity = 45.0f};
+    dht11_pulse_t pulses[DHT11_FRAME_PULSES];
+    dht11_pulse_t mutated[DHT11_FRAME_PULSES + 8];
+    dht11_reading_t out;
+    unsigned rejected = 0, accepted = 0;
+
+    dht11_encode(&in, pulses);
+    for (size_t i = 0; i < DHT11_FRAME_PULSES; i++) {
+        for (unsigned width = 0; width <= 200; width++) {
+            for (uint8_t level = 0; level <= 1; level++) {
+                memcpy(mutated, pulses, sizeof(pulses));
+                mutated[i] = (dht11_pulse_t){level, width};
+                if (dht11_decode(mutated, DHT11_FRAME_PULSES, &out) == ESP_OK) {
+                    CHECK(same_reading(&out, &in));
+                    accepted++;
+                } else {
+                    rejected++;
+                }
+            }
+        }
+
+        // Drop pulse i
+        memcpy(mutated, pulses, i * sizeof(pulses[0]));
+        memcpy(mutated + i, pulses + i + 1, (DHT11_FRAME_PULSES - i - 1) * sizeof(pulses[0]));
+        CHECK(dht11_decode(mutated, DHT11_FRAME_PULSES - 1, &out) != ESP_OK);
+
+        // Split pulse i in two with a glitch of the other level
+        memcpy(mutated, pulses, i * sizeof(pulses[0]));
+        mutated[i] = (dht11_pulse_t){pulses[i].level, pulses[i].duration_us / 2};
+        mutated[i + 1] = (dht11_pulse_t){!pulses[i].level, 2};
+        mutated[i + 2] = (dht11_pulse_t){pulses[i].level, pulses[i].duration_us / 2};
+        memcpy(mutated + i + 3, pulses + i + 1, (DHT11_FRAME_PULSES - i - 1) * sizeof(pulses[0]));
+        if (dht11_decode(mutated, DHT11_FRAME_PULSES + 2, &out) == ESP_OK) {
+            CHECK(same_reading(&out, &in));
+        }
+    }
+
+    for (size_t count = 0; count < DHT11_FRAME_PULSES; count++) {
+        CHECK(dht11_decode(pulses, count, &out) != ESP_OK);
+    }
+
+    // Leading noise before the response is skipped
+    for (size_t noise = 1; noise <= 8; noise++) {
+        for (size_t i = 0; i < noise; i++) {
+            mutated[i] = (dht11_pulse_t){i & 1, 10 + i * 7};
+        }
+        memcpy(mutated + noise, pulses, sizeof(pulses));
+        CHECK(dht11_decode(mutated, DHT11_FRAME_PULSES + noise, &out) == ESP_OK);
+        CHECK(same_reading(&out, &in));
+    }
+    printf("mutations: %u accepted unchanged, %u rejected\n", accepted, rejected);
+}
+
+// Random waveforms must never read past the end of the buffer (run under
+// -fsanitize=address to check) and only decode when their checksum matches
+static void test_random(void) {
+    dht11_pulse_t pulses[DHT11_FRAME_PULSES + 16];
+    dht11_reading_t out;
+    unsigned decoded = 0;
+
+    srand(9);
+    for (int round = 0; round < 200000; round++) {
+        size_t count = rand() % (sizeof(pulses) / sizeof(pulses[0]) + 1);
+        size_t response = rand() % 4;
+        for (size_t i = 0; i < count; i++) {
+            uint8_t level = (i + response) & 1;
+            if (i == response || i == response + 1) {
+                // Usually a valid response, so most frames reach the bit decoder
+                pulses[i] = (dht11_pulse_t){level, rand() % 8 ? 80 : rand() % 200};
+            } else if (rand() % 64 == 0) {
+                pulses[i] = (dht11_pulse_t){rand() & 1, rand() % 65536};
+            } else {
+                pulses[i] = (dht11_pulse_t){level, level ? 20 + rand() % 60 : 50};
+            }
+        }
+        if (dht11_decode(pulses, count, &out) == ESP_OK) {
+            CHECK(out.humidity >= 0 && out.humidity < 256 + 25.6f);
+            decoded++;
+        }
+    }
+    printf("random: %u of 200000 decoded\n", decoded);
+}
+
+static void bench(void) {
+    const int rounds = 1000000;
+    const size_t count = sizeof(capture_45rh_23c1) / sizeof(capture_45rh_23c1[0]);
+    dht11_reading_t out;
+    volatile float sink = 0;
+
+    clock_t start = clock();
+    for (int i = 0; i < rounds; i++) {
+        dht11_decode(capture_45rh_23c1, count, &out);
+        sink += out.temperature;
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("decode: %.1f ns per frame\n", seconds * 1e9 / rounds);
+}
+
+int main(void) {
+    test_captures();
+    test_round_trip();
+    test_mutations();
+    test_random();
+    bench();
+    printf("dht11_decode: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,188 @@
+// Host harness for sensor_log.c: write throughput, bytes per sample, crash
+// recovery and wrap-around on the file-backed stand-in. Build and run from the
+// project directory:
+//
+//   gcc -std=gnu11 -O2 -Itest/host -I. test/test_sensor_log.c -o /tmp/test_sensor_log && /tmp/test_sensor_log
+//
+// The log module is included directly so each simulated reboot can drop its state.
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../sensor_log.c"
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+// Forget everything but the file, as a reset or power loss would
+static void reboot(void) {
+    if (log_file != NULL) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+    log_lock = NULL;
+    cur_sector = cur_seq = write_offset = boot = 0;
+    batch_len = BLOCK_HEADER_SIZE;
+    memset(&stats, 0, sizeof(stats));
+    CHECK(sensor_log_init() == ESP_OK);
+}
+
+static float sample_temperature(uint32_t i) {
+    return 20.0f + (i % 37) * 0.13f;
+}
+
+static float sample_humidity(uint32_t i) {
+    return 40.0f + (i % 23) * 0.7f;
+}
+
+// Append samples time_s = first .. first + count - 1, two seconds apart on the record
+static void append_samples(uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; i++) {
+        CHECK(sensor_log_append(i * 2, sample_temperature(i), sample_humidity(i)) == ESP_OK);
+    }
+}
+
+// Read the whole log and check it holds samples `first` .. `last` of `boot_no`, in order
+static uint32_t check_log(uint32_t boot_no, uint32_t first, uint32_t last) {
+    sensor_log_reader_t reader;
+    sensor_log_record_t record;
+    uint32_t count = 0;
+    uint32_t i = first;
+
+    sensor_log_reader_init(&reader);
+    while (sensor_log_read_next(&reader, &record)) {
+        if (record.boot != boot_no) {
+            continue;
+        }
+        CHECK(i <= last);
+        CHECK(record.time_s == i * 2);
+        CHECK(record.temperature == to_centi(sample_temperature(i)));
+        CHECK(record.humidity == to_centi(sample_humidity(i)));
+        i++;
+        count++;
+    }
+    CHECK(i == last + 1);
+    return count;
+}
+
+static void test_throughput(void) {
+    const uint32_t count = 2000;
+    sensor_log_stats_t log_stats;
+
+    reboot();
+    CHECK(boot == 1);
+    clock_t start = clock();
+    append_samples(0, count);
+    CHECK(sensor_log_flush() == ESP_OK);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    sensor_log_get_stats(&log_stats);
+    CHECK(log_stats.samples == count);
+    CHECK(log_stats.pending_bytes == 0);
+    printf("append: %u samples in %.1f ms, %.0f samples/s, %.2f bytes/sample, %lu block writes\n",
+           (unsigned)count, seconds * 1000, count / seconds,
+           (double)log_stats.bytes_written / count, (unsigned long)log_stats.flushes);
+    CHECK(log_stats.bytes_written < count * 5);
+
+    reboot();
+    CHECK(boot == 2);
+    CHECK(check_log(1, 0, count - 1) == count);
+}
+
+// A power loss while a block is programmed leaves its tail erased: the block must be
+// dropped, everything before it kept, and writing resume in a fresh sector
+static void test_torn_block(void) {
+    reboot();
+    uint32_t kept_boot = boot;
+    append_samples(0, 100);
+    CHECK(sensor_log_flush() == ESP_OK);
+    uint32_t kept_end = write_offset;
+    append_samples(100, 100);
+    CHECK(sensor_log_flush() == ESP_OK);
+    uint32_t torn_sector = cur_sector;
+    CHECK(write_offset > kept_end);
+    CHECK(cur_seq > 0);
+
+    // Cut the file in the middle of the last block
+    fclose(log_file);
+    log_file = NULL;
+    CHECK(truncate(SENSOR_LOG_HOST_PATH, torn_sector * SENSOR_LOG_SECTOR_SIZE + kept_end + 5) == 0);
+
+    reboot();
+    CHECK(write_offset == SENSOR_LOG_SECTOR_SIZE);
+    uint32_t kept = check_log(kept_boot, 0, 99);
+    CHECK(kept == 100);
+
+    uint32_t next_boot = boot;
+    append_samples(500, 50);
+    CHECK(sensor_log_flush() == ESP_OK);
+    CHECK(cur_sector == (torn_sector + 1) % sector_count);
+    reboot();
+    CHECK(check_log(kept_boot, 0, 99) == 100);
+    CHECK(check_log(next_boot, 500, 549) == 50);
+}
+
+// Records lost to a crash before the batch was flushed never show up half-written
+static void test_unflushed_batch(void) {
+    reboot();
+    uint32_t crashed_boot = boot;
+    append_samples(0, 10);
+    reboot();
+    CHECK(check_log(crashed_boot, 0, -1) == 0);
+}
+
+// Once the ring wraps the oldest sectors are recycled and the reader starts at the oldest one left
+static void test_wrap(void) {
+    sensor_log_reader_t reader;
+    sensor_log_record_t record;
+    const uint32_t count = 40000;
+
+    remove(SENSOR_LOG_HOST_PATH);
+    reboot();
+    append_samples(0, count);
+    CHECK(sensor_log_flush() == ESP_OK);
+    CHECK(cur_seq > sector_count);
+
+    reboot();
+    sensor_log_reader_init(&reader);
+    CHECK(sensor_log_read_next(&reader, &record));
+    uint32_t first = record.time_s / 2;
+    CHECK(first > 0);
+    CHECK(check_log(1, first, count - 1) == count - first);
+
+    // A reader overtaken by the writer skips what was overwritten and stays in order
+    sensor_log_reader_init(&reader);
+    CHECK(sensor_log_read_next(&reader, &record));
+    uint32_t prev = record.time_s;
+    append_samples(count, count);
+    CHECK(sensor_log_flush() == ESP_OK);
+    uint32_t read = 0;
+    while (sensor_log_read_next(&reader, &record)) {
+        CHECK(record.time_s > prev);
+        prev = record.time_s;
+        read++;
+    }
+    CHECK(prev == (2 * count - 1) * 2);
+    CHECK(read < 2 * count);
+}
+
+int main(void) {
+    char dir[] = "/tmp/sensor_log_test.XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    CHECK(chdir(dir) == 0);
+
+    test_throughput();
+    test_torn_block();
+    test_unflushed_batch();
+    test_wrap();
+
+    remove(SENSOR_LOG_HOST_PATH);
+    rmdir(dir);
+    printf("sensor_log: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <stdbool.h>
+#include <string.h>
+#include "resp_template.h"
+
+// Response being assembled by resp_template_send
+struct send_buffer {
+    httpd_req_t *req;
+    bool chunked; // Part of the body already went out as a chunk
+    size_t len;
+    char data[RESP_TEMPLATE_SEND_BUF];
+};
+
+static esp_err_t send_chunk(struct send_buffer *out, const char *data, size_t len) {
+    out->chunked = true;
+    return httpd_resp_send_chunk(out->req, data, len);
+}
+
+static esp_err_t flush(struct send_buffer *out) {
+    esp_err_t err = out->len ? send_chunk(out, out->data, out->len) : ESP_OK;
+    out->len = 0;
+    return err;
+}
+
+// Buffer a static piece; one too big to be worth copying is sent straight from flash
+static esp_err_t put_text(struct send_buffer *out, const char *text, size_t len) {
+    if (len > sizeof(out->data) - out->len) {
+        if (flush(out) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (len > sizeof(out->data) / 2) {
+            return send_chunk(out, text, len);
+        }
+    }
+    memcpy(out->data + out->len, text, len);
+    out->len += len;
+    return ESP_OK;
+}
+
+esp_err_t resp_template_send(httpd_req_t *req, const resp_template_piece_t *pieces,
+                             resp_template_slot_fn_t render, const void *ctx) {
+    struct send_buffer out = {.req = req};
+
+    for (const resp_template_piece_t *piece = pieces; piece->text; piece++) {
+        if (put_text(&out, piece->text, piece->len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (piece->slot != RESP_TEMPLATE_NO_SLOT) {
+            if (sizeof(out.data) - out.len < RESP_TEMPLATE_SLOT_MAX && flush(&out) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            out.len += render(piece->slot, out.data + out.len, ctx);
+        }
+    }
+
+    // A body that fit in the buffer goes out in one send with a Content-Length
+    if (!out.chunked) {
+        return httpd_resp_send(req, out.data, out.len);
+    }
+    if (flush(&out) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+size_t resp_template_render(const resp_template_piece_t *pieces, resp_template_slot_fn_t render,
+                            const void *ctx, char *buf, size_t size) {
+    size_t len = 0;
+
+    for (const resp_template_piece_t *piece = pieces; piece->text; piece++) {
+        if (piece->len > size - len) {
+            return 0;
+        }
+        memcpy(buf + len, piece->text, piece->len);
+        len += piece->len;
+        if (piece->slot != RESP_TEMPLATE_NO_SLOT) {
+            // Render straight into the output when a whole slot fits, else via a scratch buffer
+            char slot[RESP_TEMPLATE_SLOT_MAX];
+            char *out = size - len >= RESP_TEMPLATE_SLOT_MAX ? buf + len : slot;
+            size_t slot_len = render(piece->slot, out, ctx);
+            if (slot_len > size - len) {
+                return 0;
+            }
+            if (out == slot) {
+                memcpy(buf + len, slot, slot_len);
+            }
+            len += slot_len;
+        }
+    }
+    return len;
+}
+
+size_t resp_template_uint(char *buf, uint64_t value) {
+    char digits[20];
+    size_t count = 0;
+
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    for (size_t i = 0; i < count; i++) {
+        buf[i] = digits[count - 1 - i];
+    }
+    return count;
+}
+
+size_t resp_template_fixed(char *buf, int32_t value, unsigned decimals) {
+    static const uint32_t scale[] = {1, 10, 100, 1000};
+    size_t len = 0;
+    uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+
+    decimals = decimals < 3 ? decimals : 3;
+    if (value < 0) {
+        buf[len++] = '-';
+    }
+    len += resp_template_uint(buf + len, magnitude / scale[decimals]);
+    if (decimals) {
+        uint32_t fraction = magnitude % scale[decimals];
+        buf[len++] = '.';
+        for (unsigned i = decimals; i > 0; i--) {
+            buf[len + i - 1] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        len += decimals;
+    }
+    return len;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#define RESP_TEMPLATE_NO_SLOT -1
+#define RESP_TEMPLATE_SLOT_MAX 32 // Largest rendered slot, e.g. an IP address or a number
+#define RESP_TEMPLATE_SEND_BUF 384 // Pieces and slots are gathered into sends of up to this size
+
+// One static piece of a response and the dynamic slot that follows it.
+// The text is a compile-time constant and is never copied when streamed.
+typedef struct {
+    const char *text;
+    size_t len;
+    int slot;
+} resp_template_piece_t;
+
+#define RESP_PIECE(_text, _slot) {(_text), sizeof(_text) - 1, (_slot)}
+#define RESP_TEMPLATE_END {NULL, 0, RESP_TEMPLATE_NO_SLOT}
+
+// Render `slot` into `buf` (RESP_TEMPLATE_SLOT_MAX bytes) and return its length
+typedef size_t (*resp_template_slot_fn_t)(int slot, char *buf, const void *ctx);
+
+// Send a template, rendering only the slots. Pieces and slots are gathered in a
+// small stack buffer: a body that fits goes out in one send, a longer one is
+// streamed in chunks and static pieces too big to copy go straight from flash,
+// so the page size has no limit.
+esp_err_t resp_template_send(httpd_req_t *req, const resp_template_piece_t *pieces,
+                             resp_template_slot_fn_t render, const void *ctx);
+
+// Render a template into `buf` for small bodies sent in one piece. Returns the
+// length, or 0 if it does not fit; `buf` is not NUL-terminated.
+size_t resp_template_render(const resp_template_piece_t *pieces, resp_template_slot_fn_t render,
+                            const void *ctx, char *buf, size_t size);
+
+// Slot helpers: decimal integer and fixed point with `decimals` fraction digits
+// (e.g. 2250 with 2 decimals is "22.50"), without going through printf.
+// `buf` needs room for 20 characters.
+size_t resp_template_uint(char *buf, uint64_t value);
+size_t resp_template_fixed(char *buf, int32_t value, unsigned decimals);
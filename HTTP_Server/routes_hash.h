@@ -0,0 +1,14 @@
+// Generated by tools/route_hash.py from http_server.c, do not edit
+// 1 paths in 1 slots
+#ifndef ROUTES_HASH_H
+#define ROUTES_HASH_H
+
+#include <stdint.h>
+
+#define ROUTES_SEED 0x00000000u
+
+static const uint8_t routes_slots[1] = {
+    1, // /
+};
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include <esp_http_server.h>
+
+// Sockets available to clients; httpd keeps three of the lwIP sockets for itself.
+// Raise CONFIG_LWIP_MAX_SOCKETS (e.g. to 24) to keep 20+ pollers connected.
+#if CONFIG_LWIP_MAX_SOCKETS
+#define SERVER_MAX_SOCKETS (CONFIG_LWIP_MAX_SOCKETS - 3)
+#else
+#define SERVER_MAX_SOCKETS 32 // Linux target, host sockets have no lwIP limit
+#endif
+
+#define SERVER_BACKLOG 16            // Pending connections queued while a burst is accepted
+#define SERVER_RECV_TIMEOUT_S 3      // A stalled client frees its socket after this
+#define SERVER_SEND_TIMEOUT_S 3
+#define SERVER_KEEP_ALIVE_IDLE_S 15  // TCP keep-alive probes drop dead peers
+#define SERVER_KEEP_ALIVE_INTERVAL_S 5
+#define SERVER_KEEP_ALIVE_COUNT 3
+#define SERVER_MIN_FREE_HEAP 16384   // New connections get a 503 below this
+
+typedef struct {
+    uint32_t open_sessions;
+    uint32_t accepted;
+    uint32_t rejected; // Refused with 503 for lack of memory
+} server_tuning_stats_t;
+
+// Fill in the connection settings above: persistent connections, LRU purge of
+// the least recently used socket when all are taken, socket timeouts and TCP
+// keep-alive. New connections are answered with a canned 503 and closed when
+// free heap is short, rather than failing halfway through a response.
+// Installs open_fn/close_fn, so callers must not set their own.
+void server_tuning_apply(httpd_config_t *config);
+
+void server_tuning_get_stats(server_tuning_stats_t *stats);
@@ -0,0 +1,7 @@
+#pragma once
+
+// The subset of ESP-IDF's esp_err.h the host tests need
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "esp_err.h"
+
+// Just the response calls resp_template.c makes; the test provides them
+typedef struct httpd_req httpd_req_t;
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len);
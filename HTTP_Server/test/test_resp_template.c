@@ -0,0 +1,163 @@
+// Host test for resp_template.c: checks the bytes sent and counts the socket
+// writes and CPU time per response. Build and run from the project directory:
+//
+//   gcc -std=gnu11 -O2 -Itest/host -I. test/test_resp_template.c resp_template.c -o /tmp/test_resp_template && /tmp/test_resp_template
+//
+// Socket writes are modelled on esp_http_server: the headers take two writes
+// (status and headers, then the blank line), a body sent with httpd_resp_send
+// one more, each chunk three (size line, data, CRLF) and the final empty chunk two.
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include "resp_template.h"
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+// Captured response
+struct httpd_req {
+    bool headers_sent;
+    bool finished;
+    bool chunked;
+    unsigned writes;
+    size_t len;
+    char body[16384];
+};
+
+static void send_headers(httpd_req_t *req) {
+    if (!req->headers_sent) {
+        req->headers_sent = true;
+        req->writes += 2;
+    }
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len) {
+    CHECK(!req->headers_sent && !req->finished);
+    send_headers(req);
+    memcpy(req->body, buf, buf_len);
+    req->len = buf_len;
+    req->writes += buf_len > 0;
+    req->finished = true;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len) {
+    CHECK(!req->finished);
+    CHECK(!req->headers_sent || req->chunked);
+    send_headers(req);
+    req->chunked = true;
+    if (buf == NULL || buf_len == 0) {
+        // An empty chunk ends the response, so only the terminator may be empty
+        CHECK(buf == NULL);
+        req->writes += 2;
+        req->finished = true;
+        return ESP_OK;
+    }
+    CHECK(req->len + buf_len <= sizeof(req->body));
+    memcpy(req->body + req->len, buf, buf_len);
+    req->len += buf_len;
+    req->writes += 3;
+    return ESP_OK;
+}
+
+enum {
+    SLOT_IP,
+    SLOT_NUMBER,
+    SLOT_FIXED,
+};
+
+static size_t render_slot(int slot, char *buf, const void *ctx) {
+    switch (slot) {
+    case SLOT_IP:
+        memcpy(buf, "192.168.100.200", 15);
+        return 15;
+    case SLOT_NUMBER:
+        return resp_template_uint(buf, 18446744073709551615ull);
+    default:
+        return resp_template_fixed(buf, -2250, 2);
+    }
+}
+
+// The HTTP_Server home page
+static const resp_template_piece_t home_page[] = {
+    RESP_PIECE("<!DOCTYPE html><html><head><title>ESP32 Web Server</title>"
+               "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
+               "<style>body { font-family: Arial; text-align: center; margin-top: 50px; }</style>"
+               "</head><body><h1>Hello, World!</h1><p>Welcome to the ESP32 Web Server.</p>"
+               "<p>IP Address: ", SLOT_IP),
+    RESP_PIECE("</p></body></html>", RESP_TEMPLATE_NO_SLOT),
+    RESP_TEMPLATE_END,
+};
+
+// Many short pieces, like the sample JSON
+static const resp_template_piece_t many_slots[] = {
+    RESP_PIECE("{\"a\": ", SLOT_NUMBER),  RESP_PIECE(", \"b\": ", SLOT_FIXED),
+    RESP_PIECE(", \"c\": ", SLOT_FIXED),  RESP_PIECE(", \"d\": ", SLOT_FIXED),
+    RESP_PIECE(", \"e\": ", SLOT_FIXED),  RESP_PIECE(", \"f\": ", SLOT_NUMBER),
+    RESP_PIECE(", \"g\": ", SLOT_FIXED),  RESP_PIECE(", \"h\": ", SLOT_FIXED),
+    RESP_PIECE(", \"i\": ", SLOT_FIXED),  RESP_PIECE(", \"j\": ", SLOT_FIXED),
+    RESP_PIECE(", \"k\": ", SLOT_FIXED),  RESP_PIECE(", \"l\": ", SLOT_FIXED),
+    RESP_PIECE(", \"m\": ", SLOT_FIXED),  RESP_PIECE(", \"n\": ", SLOT_FIXED),
+    RESP_PIECE(", \"o\": ", SLOT_NUMBER), RESP_PIECE(", \"p\": ", SLOT_IP),
+    RESP_PIECE("\"}", RESP_TEMPLATE_NO_SLOT),
+    RESP_TEMPLATE_END,
+};
+
+#define KB_TEXT "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef" \
+                "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+
+// A page larger than the send buffer, with big and small pieces mixed
+static const resp_template_piece_t large_page[] = {
+    RESP_PIECE("<html><body>", SLOT_IP),
+    RESP_PIECE(KB_TEXT KB_TEXT KB_TEXT KB_TEXT KB_TEXT KB_TEXT KB_TEXT KB_TEXT, SLOT_NUMBER),
+    RESP_PIECE("<p>", SLOT_FIXED),
+    RESP_PIECE(KB_TEXT KB_TEXT, SLOT_FIXED),
+    RESP_PIECE(KB_TEXT, SLOT_IP),
+    RESP_PIECE(KB_TEXT KB_TEXT KB_TEXT, SLOT_NUMBER),
+    RESP_PIECE("</body></html>", RESP_TEMPLATE_NO_SLOT),
+    RESP_TEMPLATE_END,
+};
+
+// Send `pieces`, check the body against resp_template_render and report the cost
+static void check_send(const char *name, const resp_template_piece_t *pieces) {
+    static struct httpd_req req;
+    static char expected[sizeof(req.body)];
+    const int rounds = 100000;
+
+    size_t expected_len = resp_template_render(pieces, render_slot, NULL, expected, sizeof(expected));
+    CHECK(expected_len > 0);
+
+    memset(&req, 0, sizeof(req));
+    CHECK(resp_template_send(&req, pieces, render_slot, NULL) == ESP_OK);
+    CHECK(req.finished);
+    CHECK(req.len == expected_len);
+    CHECK(memcmp(req.body, expected, expected_len) == 0);
+    unsigned writes = req.writes;
+    bool chunked = req.chunked;
+
+    clock_t start = clock();
+    for (int i = 0; i < rounds; i++) {
+        memset(&req, 0, offsetof(struct httpd_req, body));
+        resp_template_send(&req, pieces, render_slot, NULL);
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("%-10s %5u bytes, %s, %2u socket writes, %.0f ns per response\n", name, (unsigned)expected_len,
+           chunked ? "chunked" : "one send", writes, seconds * 1e9 / rounds);
+}
+
+int main(void) {
+    check_send("home", home_page);
+    check_send("slots", many_slots);
+    check_send("large", large_page);
+    printf("resp_template: all tests passed\n");
+    return 0;
+}
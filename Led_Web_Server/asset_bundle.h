@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+// Read-only bundle of web assets in its own data partition (see partitions.csv),
+// built by tools/asset_pack.py and flashed independently of the firmware. The
+// partition is memory mapped once and files are sent straight from the mapping.
+// On the linux target a file stands in for the partition.
+#define ASSET_PARTITION_LABEL "assets"
+#define ASSET_HOST_PATH "assets.bin"
+
+// Layout, little endian: a header, the index sorted by path hash, a string table
+// of NUL-terminated paths, MIME types and ETags, then the file data 4-byte aligned.
+// The CRC covers everything after the header, so a half-written update is refused.
+#define ASSET_MAGIC 0x31425341 // "ASB1"
+#define ASSET_VERSION 2
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;        // Index entries
+    uint32_t strings_size; // Bytes of string table
+    uint32_t total_size;   // Bundle bytes, header included
+    uint32_t crc32;        // zlib CRC-32 of bytes [sizeof(header), total_size)
+} asset_bundle_header_t;
+
+typedef struct {
+    uint32_t hash;        // asset_hash() of the path
+    uint32_t offset;      // Plain content, from the start of the bundle
+    uint32_t length;
+    uint32_t gz_offset;   // Gzip encoding, gz_length 0 if it did not pay off
+    uint32_t gz_length;
+    uint16_t path;        // String table offsets
+    uint16_t mime;
+    uint16_t etag;        // Quoted, ready for the ETag header
+    uint16_t gz_etag;     // Tag of the gzip encoding, the same as etag without one
+} asset_entry_t;
+
+typedef struct {
+    const uint8_t *base;
+    const asset_entry_t *index;
+    const char *strings;
+    uint16_t count;
+    uint32_t strings_size;
+} asset_bundle_t;
+
+// One file of the bundle, pointing into the mapping
+typedef struct {
+    const char *path;
+    const char *mime;
+    const char *etag;
+    const char *gz_etag;
+    const uint8_t *data;
+    size_t length;
+    const uint8_t *gz_data;
+    size_t gz_length;
+} asset_t;
+
+// FNV-1a over the path, as computed by the packer
+uint32_t asset_hash(const char *path, size_t len);
+
+// Check a bundle image in memory and index it, without copying. Pure, so the
+// host build and tools can run it on a file read or mapped from disk.
+esp_err_t asset_bundle_open(asset_bundle_t *bundle, const void *image, size_t size);
+
+// Map the assets partition (or ASSET_HOST_PATH) and open it. The mapping stays
+// for the life of the program. ESP_ERR_NOT_FOUND without a partition,
+// ESP_ERR_INVALID_CRC or ESP_ERR_INVALID_VERSION for a bad image.
+esp_err_t asset_bundle_mount(asset_bundle_t *bundle);
+
+// Look up a path; `len` excludes any query string
+bool asset_bundle_find(const asset_bundle_t *bundle, const char *path, size_t len, asset_t *asset);
+
+// Send an asset, picking the gzip encoding when the client accepts it, with the
+// ETag of the encoding sent; a matching If-None-Match is answered with 304
+esp_err_t asset_send(httpd_req_t *req, const asset_t *asset);
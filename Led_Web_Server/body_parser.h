@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+// Incremental parser for request bodies: a form-urlencoded or flat JSON object
+// is fed in chunks of any size and each known key's value is handed to a typed
+// callback as soon as it ends. Memory is the parser struct, whatever the body
+// size; keys are matched in place and text values arrive in fragments.
+//
+//   form: led=on&name=desk%20lamp    JSON: {"led": true, "name": "desk lamp"}
+//
+// Unknown keys are skipped, as are nested JSON objects and arrays. JSON values
+// may be strings or bare tokens, so "5" and 5 both fill an integer field.
+
+#define BODY_FIELDS_MAX 32  // Fields in one table, one candidate bit each
+#define BODY_TEXT_CHUNK 32  // Largest text fragment passed to a callback
+
+typedef enum {
+    BODY_FORMAT_FORM,
+    BODY_FORMAT_JSON,
+} body_format_t;
+
+typedef enum {
+    BODY_FIELD_TEXT, // Fragments of the decoded value, the last one with `last` set
+    BODY_FIELD_INT,  // Optional '-' then decimal digits, fits in int32_t
+    BODY_FIELD_BOOL, // true/false, on/off, 1/0; a bare form key counts as true
+} body_field_type_t;
+
+// A callback returning anything but ESP_OK stops the parse with that error
+typedef struct {
+    const char *key;
+    body_field_type_t type;
+    union {
+        esp_err_t (*on_text)(const char *data, size_t len, bool last, void *ctx);
+        esp_err_t (*on_int)(int32_t value, void *ctx);
+        esp_err_t (*on_bool)(bool value, void *ctx);
+    };
+} body_field_t;
+
+#define BODY_TEXT(_key, _fn) {.key = (_key), .type = BODY_FIELD_TEXT, .on_text = (_fn)}
+#define BODY_INT(_key, _fn) {.key = (_key), .type = BODY_FIELD_INT, .on_int = (_fn)}
+#define BODY_BOOL(_key, _fn) {.key = (_key), .type = BODY_FIELD_BOOL, .on_bool = (_fn)}
+
+typedef struct {
+    const body_field_t *fields;
+    size_t field_count;
+    void *ctx;
+    body_format_t format;
+    esp_err_t err;           // Sticky, the first error stops the parse
+    uint8_t state;
+    uint8_t escape;          // Progress through a %XX or \uXXXX escape
+    uint16_t code;           // Escape digits so far
+    uint32_t candidates;     // Fields whose key still matches the key so far
+    uint8_t key_len;
+    const body_field_t *field; // Field of the value being read, NULL to skip it
+    bool negative;
+    bool has_digits;
+    int32_t number;
+    uint8_t depth;           // Nesting of a skipped JSON value
+    uint8_t text_len;
+    char text[BODY_TEXT_CHUNK];
+} body_parser_t;
+
+void body_parser_init(body_parser_t *parser, body_format_t format, const body_field_t *fields, size_t field_count,
+                      void *ctx);
+
+// Feed the next chunk; chunks may split keys, values and escapes anywhere
+esp_err_t body_parser_feed(body_parser_t *parser, const char *data, size_t len);
+
+// End of body: flush the last value and check nothing was left open.
+// ESP_ERR_INVALID_ARG for a malformed body or a value of the wrong type.
+esp_err_t body_parser_finish(body_parser_t *parser);
+
+// Receive the whole body through a small stack buffer, calling `chunk` for each
+// piece as it arrives. ESP_FAIL if the connection failed or the client stopped
+// sending for several receive timeouts in a row.
+esp_err_t body_recv_chunks(httpd_req_t *req, esp_err_t (*chunk)(const char *data, size_t len, void *ctx), void *ctx);
+
+// Parse the request body into `fields`, as JSON if the Content-Type says so and
+// as a form otherwise. ESP_FAIL if the connection failed, in which case there is
+// nothing left to answer; any other error is the client's, worth a 400.
+esp_err_t body_parser_recv(httpd_req_t *req, const body_field_t *fields, size_t field_count, void *ctx);
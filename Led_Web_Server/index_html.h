@@ -0,0 +1,134 @@
+// Generated by tools/gzip_asset.py from index.html, do not edit
+// 1949 bytes plain, 765 bytes gzip
+#ifndef INDEX_HTML_H
+#define INDEX_HTML_H
+
+#include <stdint.h>
+
+#define INDEX_HTML_ETAG "\"8d7f0b13a2900b4a\""
+#define INDEX_HTML_ETAG_GZ "\"8d7f0b13a2900b4a-gz\""
+
+static const char index_html[] =
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "    <meta charset=\"UTF-8\">\n"
+    "    <title>ESP32 LED Control</title>\n"
+    "    <style>\n"
+    "        body {\n"
+    "            font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;\n"
+    "            background-color: #f0f0f0;\n"
+    "            color: #333;\n"
+    "            text-align: center;\n"
+    "            margin: 0;\n"
+    "            padding: 0;\n"
+    "            display: flex;\n"
+    "            flex-direction: column;\n"
+    "            justify-content: center;\n"
+    "            align-items: center;\n"
+    "            height: 100vh;\n"
+    "        }\n"
+    "        h1 {\n"
+    "            color: #007BFF;\n"
+    "        }\n"
+    "        .container {\n"
+    "            background: #fff;\n"
+    "            border-radius: 8px;\n"
+    "            box-shadow: 0 4px 8px rgba(0,0,0,0.1);\n"
+    "            padding: 20px;\n"
+    "            width: 300px;\n"
+    "            margin: 20px;\n"
+    "        }\n"
+    "        button {\n"
+    "            background-color: #007BFF;\n"
+    "            border: none;\n"
+    "            color: white;\n"
+    "            padding: 15px 30px;\n"
+    "            font-size: 16px;\n"
+    "            border-radius: 5px;\n"
+    "            cursor: pointer;\n"
+    "            margin: 10px;\n"
+    "            transition: background-color 0.3s, transform 0.3s;\n"
+    "        }\n"
+    "        button:hover {\n"
+    "            background-color: #0056b3;\n"
+    "            transform: scale(1.05);\n"
+    "        }\n"
+    "        button:active {\n"
+    "            background-color: #003d7a;\n"
+    "        }\n"
+    "    </style>\n"
+    "    <script>\n"
+    "        function toggleLED(state) {\n"
+    "            fetch('/ws', {\n"
+    "                method: 'POST',\n"
+    "                headers: { 'Content-Type': 'application/x-www-form-urlencoded' },\n"
+    "                body: 'led=' + state\n"
+    "            })\n"
+    "            .then(response => response.text())\n"
+    "            .then(data => console.log(data))\n"
+    "            .catch(error => console.error('Error:', error));\n"
+    "        }\n"
+    "    </script>\n"
+    "</head>\n"
+    "<body>\n"
+    "    <div class=\"container\">\n"
+    "        <h1>ESP32 LED Control</h1>\n"
+    "        <button onclick=\"toggleLED('on')\">Turn On</button>\n"
+    "        <button onclick=\"toggleLED('off')\">Turn Off</button>\n"
+    "    </div>\n"
+    "</body>\n"
+    "</html>\n";
+
+static const uint8_t index_html_gz[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x55, 0xdf, 0x6f, 0xda, 0x30,
+    0x10, 0x7e, 0xef, 0x5f, 0xe1, 0xb1, 0x87, 0x80, 0x46, 0x20, 0x34, 0xa3, 0xad, 0x58, 0xe0, 0x61,
+    0x2d, 0x9d, 0x26, 0x4d, 0x6a, 0xa5, 0xd2, 0x49, 0x7b, 0x34, 0xf1, 0x25, 0xf1, 0x6a, 0xec, 0xc8,
+    0x76, 0xf8, 0xb1, 0xaa, 0xff, 0xfb, 0xce, 0x01, 0x9a, 0x26, 0x40, 0x55, 0xe7, 0x21, 0xb6, 0xef,
+    0x3b, 0xdf, 0xdd, 0x77, 0xbe, 0x73, 0xf4, 0xe9, 0xe6, 0xee, 0x7a, 0xf6, 0xe7, 0x7e, 0x4a, 0x32,
+    0xbb, 0x10, 0x93, 0xb3, 0x68, 0xff, 0x03, 0xca, 0x26, 0x67, 0x04, 0x47, 0xb4, 0x00, 0x4b, 0x49,
+    0x9c, 0x51, 0x6d, 0xc0, 0x8e, 0x5b, 0x8f, 0xb3, 0x5b, 0xff, 0xaa, 0xb5, 0x13, 0x59, 0x6e, 0x05,
+    0x4c, 0xa6, 0x0f, 0xf7, 0xe1, 0x39, 0xf9, 0x35, 0xbd, 0x21, 0xd7, 0x4a, 0x5a, 0xad, 0x44, 0xd4,
+    0xdf, 0x0a, 0xb6, 0x20, 0x63, 0x37, 0xfb, 0xb9, 0x1b, 0x73, 0xc5, 0x36, 0xe4, 0xf9, 0x75, 0xe9,
+    0x46, 0x82, 0x6a, 0x7e, 0x42, 0x17, 0x5c, 0x6c, 0x46, 0xc4, 0x7b, 0x80, 0x54, 0x01, 0x79, 0xfc,
+    0xe9, 0x75, 0xc9, 0x8c, 0x66, 0x6a, 0x41, 0xbb, 0xe4, 0x07, 0x48, 0x58, 0xe2, 0xff, 0x37, 0x68,
+    0x46, 0x25, 0x4e, 0x0c, 0x95, 0xc6, 0x37, 0xa0, 0x79, 0xf2, 0xad, 0x76, 0xd2, 0x9c, 0xc6, 0x4f,
+    0xa9, 0x56, 0x85, 0x64, 0x7e, 0xac, 0x84, 0xd2, 0x23, 0xf2, 0x39, 0x09, 0xdc, 0x57, 0x87, 0xed,
+    0x65, 0x61, 0x18, 0xd6, 0x05, 0x16, 0xd6, 0xd6, 0xa7, 0x82, 0xa7, 0x72, 0x44, 0x62, 0x90, 0x16,
+    0x74, 0x5d, 0xbe, 0xa0, 0x3a, 0xe5, 0x28, 0x6b, 0x9c, 0x97, 0x53, 0xc6, 0xb8, 0x4c, 0x0f, 0xf6,
+    0x19, 0x37, 0xb9, 0xa0, 0x18, 0x54, 0x22, 0x60, 0x5d, 0x17, 0xb9, 0x1d, 0x9f, 0x71, 0x0d, 0xb1,
+    0xe5, 0xca, 0x59, 0x53, 0xa2, 0x58, 0xc8, 0x3a, 0xe6, 0x6f, 0x61, 0x2c, 0x4f, 0x36, 0x18, 0x0a,
+    0x7a, 0x22, 0xed, 0x71, 0x97, 0x4a, 0x6f, 0x7d, 0x6e, 0x61, 0x61, 0x8e, 0x03, 0x32, 0xe0, 0x69,
+    0x86, 0xca, 0x83, 0x20, 0x58, 0x66, 0x95, 0xe8, 0xe5, 0x75, 0x96, 0x0d, 0x1a, 0xf9, 0xd8, 0xd3,
+    0x13, 0x04, 0x97, 0xdf, 0x6f, 0x6f, 0x8f, 0xa9, 0xf4, 0x9c, 0x4b, 0x94, 0x4b, 0xd0, 0x0d, 0xd5,
+    0x2a, 0x01, 0x8e, 0xfa, 0xa4, 0x99, 0x1e, 0xa5, 0x19, 0x68, 0x5f, 0x53, 0xc6, 0x0b, 0xf4, 0xf6,
+    0x2a, 0x5f, 0x37, 0xe5, 0x6b, 0xdf, 0x64, 0x94, 0xa9, 0x15, 0x52, 0x49, 0xbe, 0xe6, 0x6b, 0x07,
+    0x21, 0x3a, 0x9d, 0xd3, 0x76, 0xd0, 0x2d, 0xbf, 0xde, 0xa0, 0x73, 0x82, 0xfa, 0xf3, 0xa0, 0x79,
+    0xda, 0x8a, 0x33, 0x9b, 0x8d, 0x48, 0x18, 0x1c, 0x48, 0xf6, 0x69, 0xac, 0xeb, 0x54, 0xe1, 0xcd,
+    0x0b, 0x6b, 0x95, 0x3c, 0x19, 0x9a, 0x7f, 0x8a, 0xa0, 0x2a, 0xc6, 0x11, 0x91, 0x4a, 0xc2, 0xd1,
+    0x5b, 0xb7, 0xca, 0x30, 0x59, 0x27, 0x82, 0x18, 0x0c, 0x31, 0xde, 0xf0, 0xc0, 0xdf, 0xb2, 0x40,
+    0x0c, 0xff, 0x07, 0x88, 0xb8, 0x38, 0x24, 0xad, 0x46, 0xea, 0xb0, 0x29, 0x8f, 0x0b, 0x6d, 0x9c,
+    0xdd, 0x5c, 0xf1, 0xd3, 0x17, 0x7a, 0x70, 0x60, 0xd3, 0x6a, 0xac, 0x31, 0xbe, 0xbd, 0x9c, 0xcd,
+    0xd0, 0x49, 0xd0, 0x0b, 0x4d, 0x77, 0x0b, 0x49, 0x94, 0x5e, 0x94, 0xeb, 0xd3, 0x44, 0x8e, 0x32,
+    0xb5, 0x7c, 0xe7, 0xa6, 0xbc, 0xa1, 0x73, 0x78, 0x31, 0x0f, 0x8f, 0xb8, 0xe1, 0x6c, 0x8c, 0x88,
+    0x89, 0xa9, 0x80, 0xf6, 0xa0, 0x17, 0x0c, 0x3b, 0xef, 0xd8, 0xa2, 0x58, 0x50, 0x4b, 0xf8, 0x88,
+    0xb1, 0x90, 0x5d, 0xd2, 0xe6, 0x41, 0x51, 0xff, 0x4d, 0xbb, 0x8a, 0x4c, 0xac, 0x79, 0x6e, 0xab,
+    0xde, 0x95, 0x14, 0xb2, 0x2c, 0x57, 0x62, 0x55, 0x9a, 0x0a, 0xc0, 0x96, 0xd7, 0x36, 0x96, 0x5a,
+    0xe8, 0x34, 0x1b, 0x1a, 0xd8, 0x38, 0x6b, 0x7b, 0xfd, 0x95, 0xc1, 0x26, 0x56, 0x17, 0x95, 0xa4,
+    0x83, 0xcd, 0x14, 0x16, 0x88, 0x77, 0x7f, 0xf7, 0x30, 0xf3, 0xba, 0x07, 0x72, 0xd7, 0x7c, 0x41,
+    0x63, 0x2e, 0x9f, 0x89, 0x77, 0xbd, 0xad, 0x7d, 0x7f, 0xb6, 0xc9, 0xc1, 0x43, 0x15, 0x9a, 0xe7,
+    0x82, 0xc7, 0xd4, 0x79, 0xd1, 0x5f, 0xfb, 0xab, 0xd5, 0xca, 0x77, 0xe4, 0xf8, 0x85, 0x16, 0x20,
+    0x63, 0xc5, 0x80, 0x79, 0xe4, 0xe5, 0xf0, 0x44, 0xd7, 0x74, 0x51, 0x59, 0x00, 0x1b, 0x7b, 0xe4,
+    0x0b, 0x29, 0x9d, 0xae, 0x81, 0x5e, 0x3a, 0xb5, 0x65, 0xcf, 0x66, 0x20, 0xdb, 0x1a, 0x4c, 0xae,
+    0xa4, 0x01, 0x32, 0x9e, 0x90, 0xfd, 0xbc, 0xe7, 0x5a, 0x64, 0xbb, 0x73, 0x0c, 0xce, 0x28, 0x3e,
+    0x14, 0x08, 0xc5, 0xde, 0x60, 0x94, 0x80, 0x9e, 0x50, 0x69, 0xb9, 0xd7, 0x04, 0xa3, 0xf7, 0xc8,
+    0x0e, 0x68, 0x8d, 0x17, 0xe9, 0x0d, 0xbc, 0xdc, 0x68, 0x7b, 0x53, 0xf7, 0x1b, 0x21, 0x6f, 0xe5,
+    0xba, 0xd3, 0x39, 0x92, 0xa1, 0x5d, 0x56, 0xa2, 0xfe, 0xf6, 0x95, 0x8a, 0x5c, 0x74, 0xbb, 0x8c,
+    0x31, 0xbe, 0x24, 0xb1, 0xa0, 0xc6, 0x8c, 0x5b, 0xaf, 0x2d, 0xaa, 0x55, 0x25, 0x30, 0xca, 0x06,
+    0xc7, 0x9e, 0x2b, 0xdc, 0xad, 0x20, 0xbb, 0xe2, 0x57, 0x32, 0x46, 0xa2, 0x9f, 0xc6, 0xad, 0x2a,
+    0xd7, 0x9e, 0x92, 0x5e, 0xa7, 0x35, 0x99, 0x15, 0x5a, 0x92, 0x3b, 0x19, 0xf5, 0xb7, 0xc8, 0x0f,
+    0xaa, 0x26, 0x49, 0xa5, 0x9b, 0x24, 0x75, 0xe5, 0xa8, 0x8f, 0x7e, 0xbb, 0x80, 0xb6, 0x91, 0xa0,
+    0x43, 0xe5, 0x2b, 0xfc, 0x1f, 0x3b, 0xdc, 0xe8, 0xf5, 0x9d, 0x07, 0x00, 0x00,
+};
+
+#endif
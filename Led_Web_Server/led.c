@@ -1,251 +1,323 @@
 #include <stdio.h>
 #include <sys/param.h>
-#include "esp_wifi.h"
+#include "sdkconfig.h"
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
-#include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 #include <esp_http_server.h>
-#include "my_data.h"
+#include "index_html.h"
+#include "led_control.h"
+#include "wifi_station.h"
+#include "server_tuning.h"
+#include "metrics.h"
+#include "router.h"
+#include "routes_hash.h"
+#include "body_parser.h"
+#include "asset_bundle.h"
 
-#define LED_PIN GPIO_NUM_2
+// Unprivileged port for the host simulation build
+#define SIM_SERVER_PORT 8080
 
-static char ip_address[16] = {0};  // Buffer to hold the IP address as a string
+// Command API channel driving the LED on GPIO 2
+#define LED_CHANNEL 0
 
 static const char *TAG = "Websocket Server: ";
 
-static void wifi_event_handler(void *event_handler_arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
-{
-    switch (event_id)
-    {
-    case WIFI_EVENT_STA_START:
-        printf("WiFi connecting ... \n");
-        break;
-    case WIFI_EVENT_STA_CONNECTED:
-        printf("WiFi connected ... \n");
-        break;
-    case WIFI_EVENT_STA_DISCONNECTED:
-        printf("WiFi lost connection ... \n");
-        break;
-    case IP_EVENT_STA_GOT_IP:
-        printf("WiFi got IP ... \n\n");
-        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        snprintf(ip_address, sizeof(ip_address), IPSTR, IP2STR(&event->ip_info.ip));
-        printf("IP Address: %s\n", ip_address);  // Print IP address to the serial monitor
-        break;
-    default:
-        break;
-    }
+// Initialize the LED and the other command API outputs
+void init_led()
+{
+    led_control_init();
 }
 
-void wifi_connection()
-{
-    nvs_flash_init();
-    // 1 - Wi-Fi/LwIP Init Phase
-    esp_netif_init();                    // TCP/IP initiation 					s1.1
-    esp_event_loop_create_default();     // event loop 			                s1.2
-    esp_netif_create_default_wifi_sta(); // WiFi station 	                    s1.3
-    wifi_init_config_t wifi_initiation = WIFI_INIT_CONFIG_DEFAULT();
-    esp_wifi_init(&wifi_initiation); // 					                    s1.4
-    // 2 - Wi-Fi Configuration Phase
-    esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event_handler, NULL);
-    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL);
-    wifi_config_t wifi_configuration = {
-        .sta = {
-            .ssid = SSID,
-            .password = PASS}};
-    esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_configuration);
-    // 3 - Wi-Fi Start Phase
-    esp_wifi_start();
-    // 4- Wi-Fi Connect Phase
-    esp_wifi_connect();
-}
-
-// Initialize the LED
-void init_led()
+// Instrumentation exported at /metrics
+static metrics_histogram_t index_latency = METRICS_HISTOGRAM("http_request_duration_seconds", "route=\"/\"");
+static metrics_histogram_t post_latency = METRICS_HISTOGRAM("http_request_duration_seconds", "route=\"POST /ws\"");
+static metrics_histogram_t batch_latency = METRICS_HISTOGRAM("http_request_duration_seconds", "route=\"POST /led\"");
+
+// /metrics runs on the httpd task, so the current task is the one to measure
+static uint32_t httpd_task_stack_free(void)
 {
-    esp_rom_gpio_pad_select_gpio(LED_PIN);
-    gpio_set_direction(LED_PIN, GPIO_MODE_OUTPUT);
+    return uxTaskGetStackHighWaterMark(NULL);
 }
 
-// Asynchronous response data structure
-struct async_resp_arg
+static uint32_t http_open_sessions(void)
 {
-    httpd_handle_t hd; // Server instance
-    int fd;            // Session socket file descriptor for cilent
-};
+    server_tuning_stats_t stats;
+    server_tuning_get_stats(&stats);
+    return stats.open_sessions;
+}
 
-// Serve the HTML page
-esp_err_t index_handler(httpd_req_t *req)
+static uint32_t http_rejected_sessions(void)
 {
-    const char *html_page =
-        "<!DOCTYPE html>"
-        "<html>"
-        "<head>"
-        "    <meta charset=\"UTF-8\">"
-        "    <title>ESP32 LED Control</title>"
-        "    <style>"
-        "        body {"
-        "            font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;"
-        "            background-color: #f0f0f0;"
-        "            color: #333;"
-        "            text-align: center;"
-        "            margin: 0;"
-        "            padding: 0;"
-        "            display: flex;"
-        "            flex-direction: column;"
-        "            justify-content: center;"
-        "            align-items: center;"
-        "            height: 100vh;"
-        "        }"
-        "        h1 {"
-        "            color: #007BFF;"
-        "        }"
-        "        .container {"
-        "            background: #fff;"
-        "            border-radius: 8px;"
-        "            box-shadow: 0 4px 8px rgba(0,0,0,0.1);"
-        "            padding: 20px;"
-        "            width: 300px;"
-        "            margin: 20px;"
-        "        }"
-        "        button {"
-        "            background-color: #007BFF;"
-        "            border: none;"
-        "            color: white;"
-        "            padding: 15px 30px;"
-        "            font-size: 16px;"
-        "            border-radius: 5px;"
-        "            cursor: pointer;"
-        "            margin: 10px;"
-        "            transition: background-color 0.3s, transform 0.3s;"
-        "        }"
-        "        button:hover {"
-        "            background-color: #0056b3;"
-        "            transform: scale(1.05);"
-        "        }"
-        "        button:active {"
-        "            background-color: #003d7a;"
-        "        }"
-        "    </style>"
-        "    <script>"
-        "        function toggleLED(state) {"
-        "            fetch('/ws', {"
-        "                method: 'POST',"
-        "                headers: { 'Content-Type': 'application/x-www-form-urlencoded' },"
-        "                body: 'led=' + state"
-        "            })"
-        "            .then(response => response.text())"
-        "            .then(data => console.log(data))"
-        "            .catch(error => console.error('Error:', error));"
-        "        }"
-        "    </script>"
-        "</head>"
-        "<body>"
-        "    <div class=\"container\">"
-        "        <h1>ESP32 LED Control</h1>"
-        "        <button onclick=\"toggleLED('on')\">Turn On</button>"
-        "        <button onclick=\"toggleLED('off')\">Turn Off</button>"
-        "    </div>"
-        "</body>"
-        "</html>";
-
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, html_page, strlen(html_page));
-    return ESP_OK;
+    server_tuning_stats_t stats;
+    server_tuning_get_stats(&stats);
+    return stats.rejected;
 }
 
-// The asynchronous response POST
-static void generate_async_resp_post(void *arg)
+static uint32_t wifi_first_request_ms(void)
 {
-    // Data format to be sent from the server as a response to the client
-    char http_string[250];
-    char *data_string = "POST response from ESP32 websocket server ...";
-    sprintf(http_string, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", strlen(data_string));
+    wifi_station_stats_t stats;
+    wifi_station_get_stats(&stats);
+    return stats.boot_to_first_request_ms < 0 ? 0 : stats.boot_to_first_request_ms;
+}
 
-    // Initialize asynchronous response data structure
-    struct async_resp_arg *resp_arg = (struct async_resp_arg *)arg;
-    httpd_handle_t hd = resp_arg->hd;
-    int fd = resp_arg->fd;
+static void init_metrics(void)
+{
+    metrics_init();
+    metrics_register_histogram(&index_latency, "Time spent in the request handler");
+    metrics_register_histogram(&post_latency, "Time spent in the request handler");
+    metrics_register_histogram(&batch_latency, "Time spent in the request handler");
+    metrics_register_gauge("task_stack_free_min_bytes", "task=\"httpd\"", "Stack high-water mark", httpd_task_stack_free);
+    metrics_register_gauge("http_open_sessions", NULL, "Open client connections", http_open_sessions);
+    metrics_register_counter_fn("http_rejected_sessions_total", NULL, "Connections refused with 503", http_rejected_sessions);
+    metrics_register_gauge("wifi_first_request_ms", NULL, "Boot to first served request, 0 until then", wifi_first_request_ms);
+    led_control_register_metrics();
+}
+
+// The POST reply never changes, so header and body are built once and sent in one call
+#define POST_RESP_BODY "POST response from ESP32 websocket server ..."
 
-    // Send data to the client
-    ESP_LOGI(TAG, "Executing queued work POST fd : %d", fd);
-    httpd_socket_send(hd, fd, http_string, strlen(http_string), 0);
-    httpd_socket_send(hd, fd, data_string, strlen(data_string), 0);
+static char post_response[128];
+static size_t post_response_len;
 
-    free(arg);
+static void init_post_response(void)
+{
+    post_response_len = snprintf(post_response, sizeof(post_response),
+                                 "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n\r\n%s",
+                                 (unsigned)strlen(POST_RESP_BODY), POST_RESP_BODY);
 }
 
-// Initialize a queue for asynchronous communication for POST
-esp_err_t async_post_handler(httpd_req_t *req)
+// Serve a precompressed page with a strong ETag per encoding, a matching If-None-Match gets a bodyless 304
+static esp_err_t send_page(httpd_req_t *req, const char *type, const char *etag, const char *etag_gz,
+                           const char *page, size_t page_len, const uint8_t *page_gz, size_t page_gz_len)
+{
+    char header[64];
+    bool gzip = httpd_req_get_hdr_value_str(req, "Accept-Encoding", header, sizeof(header)) == ESP_OK &&
+                strstr(header, "gzip") != NULL;
+
+    // Each coding is its own representation, so it gets its own strong ETag
+    if (gzip)
+    {
+        etag = etag_gz;
+    }
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", header, sizeof(header)) == ESP_OK &&
+        strstr(header, etag) != NULL)
+    {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, type);
+    if (gzip)
+    {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        return httpd_resp_send(req, (const char *)page_gz, page_gz_len);
+    }
+    return httpd_resp_send(req, page, page_len);
+}
+
+// Web assets flashed separately from the firmware, empty if none are
+static asset_bundle_t assets;
+
+// Serve the HTML page: /index.html from the asset bundle if it has one, else the
+// copy built into the firmware (generated from index.html by tools/gzip_asset.py)
+esp_err_t index_handler(httpd_req_t *req)
 {
-    // Read data sent by the client
-    char content[100];
-    size_t recv_size = MIN(req->content_len, sizeof(content));
-    httpd_req_recv(req, content, recv_size);
-    printf("Data sent by the client: %.*s\n", recv_size, content);
+    asset_t asset;
 
-    // Control the LED based on the received data
-    if (strstr(content, "led=on"))
+    wifi_station_note_request();
+    if (asset_bundle_find(&assets, "/index.html", strlen("/index.html"), &asset))
     {
-        gpio_set_level(LED_PIN, 1);
+        return asset_send(req, &asset);
     }
-    else if (strstr(content, "led=off"))
+    return send_page(req, "text/html", INDEX_HTML_ETAG, INDEX_HTML_ETAG_GZ,
+                     index_html, sizeof(index_html) - 1, index_html_gz, sizeof(index_html_gz));
+}
+
+// Any other GET is looked up in the asset bundle
+static esp_err_t asset_get_handler(httpd_req_t *req)
+{
+    asset_t asset;
+
+    wifi_station_note_request();
+    if (!asset_bundle_find(req->user_ctx, req->uri, strcspn(req->uri, "?"), &asset))
     {
-        gpio_set_level(LED_PIN, 0);
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, NULL);
     }
+    return asset_send(req, &asset);
+}
 
-    // Generate server response queue
-    struct async_resp_arg *resp_arg = malloc(sizeof(struct async_resp_arg));
-    resp_arg->hd = req->handle;
-    resp_arg->fd = httpd_req_to_sockfd(req);
-    ESP_LOGI(TAG, "Queuing work POST fd : %d", resp_arg->fd);
-    httpd_queue_work(req->handle, generate_async_resp_post, resp_arg);
+// Shed load while the actuator task is behind
+static esp_err_t send_busy(httpd_req_t *req)
+{
+    ESP_LOGW(TAG, "LED command queue full, rejecting POST");
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_hdr(req, "Retry-After", "1");
+    return httpd_resp_send(req, NULL, 0);
+}
+
+static esp_err_t post_led_field(bool on, void *ctx)
+{
+    led_batch_t *batch = ctx;
+    batch->ops[0].value = on;
+    batch->count = 1;
     return ESP_OK;
 }
 
-// Create URI (Uniform Resource Identifier) handler structure for GET
-// for the server which is added to default gateway
-static const httpd_uri_t uri_get = {
-    .uri = "/",
-    .method = HTTP_GET,
-    .handler = index_handler,
-    .user_ctx = NULL,
+// Fields of the POST body, led=on/off from the page or {"led": true} as JSON
+static const body_field_t post_fields[] = {
+    BODY_BOOL("led", post_led_field),
 };
 
-// URI handler structure for POST
-httpd_uri_t uri_post = {
-    .uri = "/ws",
-    .method = HTTP_POST,
-    .handler = async_post_handler,
-    .user_ctx = NULL
+esp_err_t async_post_handler(httpd_req_t *req)
+{
+    wifi_station_note_request();
+
+    // Control the LED based on the received data, parsed as it arrives
+    led_batch_t batch = {.ops = {{.type = LED_OP_SET, .channel = LED_CHANNEL}}, .count = 0};
+    esp_err_t err = body_parser_recv(req, post_fields, sizeof(post_fields) / sizeof(post_fields[0]), &batch);
+    if (err == ESP_FAIL)
+    {
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK)
+    {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Malformed body");
+    }
+    // The actuator task applies the command; the reply only waits for it to be queued
+    if (batch.count > 0 && led_batch_submit(&batch) != ESP_OK)
+    {
+        return send_busy(req);
+    }
+    if (httpd_socket_send(req->handle, httpd_req_to_sockfd(req), post_response, post_response_len, 0) < 0)
+    {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t feed_batch_chunk(const char *data, size_t len, void *ctx)
+{
+    return led_batch_parser_feed(ctx, data, len);
+}
+
+// Apply a batch of LED operations in one request, text or binary encoded.
+// The body is parsed as it arrives, so only the operation count is limited.
+static esp_err_t led_batch_handler(httpd_req_t *req)
+{
+    char content_type[40] = "";
+    led_batch_parser_t parser;
+    led_batch_t batch;
+
+    wifi_station_note_request();
+
+    httpd_req_get_hdr_value_str(req, "Content-Type", content_type, sizeof(content_type));
+    led_batch_parser_init(&parser, strcmp(content_type, "application/octet-stream") == 0, &batch);
+    esp_err_t err = body_recv_chunks(req, feed_batch_chunk, &parser);
+    if (err == ESP_FAIL)
+    {
+        return ESP_FAIL;
+    }
+    if (err == ESP_OK)
+    {
+        err = led_batch_parser_finish(&parser);
+    }
+    if (err != ESP_OK)
+    {
+        char message[48];
+        snprintf(message, sizeof(message), "Invalid operation %u", (unsigned)parser.bad_op);
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, message);
+    }
+
+    if (led_batch_submit(&batch) != ESP_OK)
+    {
+        return send_busy(req);
+    }
+    char response[32];
+    int len = snprintf(response, sizeof(response), "{\"queued\": %u}", (unsigned)batch.count);
+    return httpd_resp_send(req, response, len);
+}
+
+// Timed routes go through metrics_timed_handler
+static const metrics_route_t route_index = {index_handler, &index_latency};
+static const metrics_route_t route_post = {async_post_handler, &post_latency};
+static const metrics_route_t route_led_batch = {led_batch_handler, &batch_latency};
+
+// Route table. Its perfect hash lives in routes_hash.h, rerun tools/route_hash.py after editing it.
+static const router_route_t routes[] = {
+    {
+        .path = "/",
+        .method = HTTP_GET,
+        .handler = metrics_timed_handler,
+        .user_ctx = (void *)&route_index,
+    },
+    {
+        .path = "/ws",
+        .method = HTTP_POST,
+        .handler = metrics_timed_handler,
+        .user_ctx = (void *)&route_post,
+    },
+    // Batched LED commands
+    {
+        .path = "/led",
+        .method = HTTP_POST,
+        .content_type = "application/json",
+        .handler = metrics_timed_handler,
+        .user_ctx = (void *)&route_led_batch,
+    },
+    // Prometheus metrics
+    {
+        .path = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_handler,
+    },
+    // Static files from the asset bundle
+    {
+        .path = "/*",
+        .method = HTTP_GET,
+        .handler = asset_get_handler,
+        .user_ctx = &assets,
+    },
 };
 
+static const router_t router = ROUTER(routes, routes_slots, ROUTES_SEED);
+
 static void websocket_app_start(void)
 {
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    server_tuning_apply(&config);
+    router_apply(&config);
+    init_post_response();
+#if CONFIG_IDF_TARGET_LINUX
+    config.server_port = SIM_SERVER_PORT;
+#endif
 
     // Start the httpd server
     ESP_LOGI(TAG, "Starting server on port: '%d'", config.server_port);
     if (httpd_start(&server, &config) == ESP_OK)
     {
         // Registering the uri_handler
-        ESP_LOGI(TAG, "Registering URI handler");
-        httpd_register_uri_handler(server, &uri_get);
-        httpd_register_uri_handler(server, &uri_post);
+        ESP_LOGI(TAG, "Registering URI handlers");
+        router_register(server, &router);
     }
 }
 
 void app_main(void)
 {
-    wifi_connection();
+    wifi_station_start();
     init_led();
-    vTaskDelay(1500 / portTICK_PERIOD_MS);
+    asset_bundle_mount(&assets);
+    init_metrics();
+    wifi_station_wait_ready(portMAX_DELAY);
     websocket_app_start();
 }
\ No newline at end of file
@@ -0,0 +1,636 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "led_control.h"
+#include "metrics.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+// Host simulation: there is no GPIO or LEDC peripheral, so log the output changes instead
+typedef int gpio_num_t;
+#define GPIO_NUM_2 2
+#define GPIO_NUM_4 4
+#define GPIO_NUM_5 5
+#define GPIO_MODE_OUTPUT 1
+#define LEDC_LOW_SPEED_MODE 0
+#define LEDC_CHANNEL_0 0
+#define LEDC_CHANNEL_1 1
+#define LEDC_FADE_NO_WAIT 0
+
+static void esp_rom_gpio_pad_select_gpio(gpio_num_t pin) {}
+static void gpio_set_direction(gpio_num_t pin, int mode) {}
+static void gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    ESP_LOGI("GPIO", "pin %d -> %lu", pin, (unsigned long)level);
+}
+static void ledc_set_duty(int mode, int channel, uint32_t duty)
+{
+    ESP_LOGI("LEDC", "channel %d duty -> %lu", channel, (unsigned long)duty);
+}
+static void ledc_update_duty(int mode, int channel) {}
+static void ledc_set_fade_with_time(int mode, int channel, uint32_t duty, int time_ms)
+{
+    ESP_LOGI("LEDC", "channel %d fade -> %lu over %d ms", channel, (unsigned long)duty, time_ms);
+}
+static void ledc_fade_start(int mode, int channel, int wait) {}
+#else
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#endif
+
+#define LED_PWM_MODE LEDC_LOW_SPEED_MODE
+#define LED_PWM_TIMER LEDC_TIMER_0
+#define LED_PWM_FREQ_HZ 5000
+#define LED_PWM_RESOLUTION LEDC_TIMER_13_BIT
+#define LED_DUTY_MAX ((1 << 13) - 1)
+
+// Output channels addressable by the command API, by index
+static const struct led_channel
+{
+    gpio_num_t pin;
+    int ledc_channel; // LEDC channel for PWM outputs, -1 for a plain on/off GPIO
+} led_channels[] = {
+    {GPIO_NUM_2, -1},
+    {GPIO_NUM_4, LEDC_CHANNEL_0},
+    {GPIO_NUM_5, LEDC_CHANNEL_1},
+};
+
+#define LED_CHANNEL_COUNT (sizeof(led_channels) / sizeof(led_channels[0]))
+
+static const char *TAG = "led_control";
+
+// Batches on their way from the HTTP handlers to the actuator task, in a bounded
+// lock-free queue: a slot whose sequence number equals a position is free for the
+// producer claiming that position, and position + 1 once it is filled.
+static struct led_command
+{
+    atomic_uint seq;
+    int64_t queued_us;
+    led_batch_t batch;
+} led_commands[LED_COMMAND_QUEUE_LEN];
+static atomic_uint led_command_tail; // Next position to fill, claimed by producers
+static atomic_uint led_command_head; // Next position to take, written by the actuator task only
+
+// Task notification bits of the actuator task
+#define LED_NOTIFY_COMMAND (1u << 0)
+#define LED_NOTIFY_TIMER (1u << 1)
+
+static TaskHandle_t led_actuator_task_handle;
+
+// Sequence being executed, owned by the actuator task
+static esp_timer_handle_t led_sequence_timer;
+static led_batch_t led_sequence;
+static size_t led_sequence_pos;
+static int64_t led_sequence_due_us; // End of the running delay, 0 when not waiting
+
+// Operations before the first delay of each batch taken in one burst
+static led_batch_t led_burst[LED_COMMAND_QUEUE_LEN];
+
+static metrics_histogram_t command_latency = METRICS_HISTOGRAM("led_command_latency_seconds", NULL);
+static metrics_counter_t ops_coalesced = METRICS_COUNTER("led_ops_coalesced_total", NULL);
+static metrics_counter_t commands_rejected = METRICS_COUNTER("led_commands_rejected_total", NULL);
+
+static uint32_t brightness_to_duty(uint16_t brightness)
+{
+    return (uint32_t)brightness * LED_DUTY_MAX / 255;
+}
+
+static void led_apply_op(const led_op_t *op)
+{
+    const struct led_channel *channel = &led_channels[op->channel];
+
+    switch (op->type)
+    {
+    case LED_OP_SET:
+        if (channel->ledc_channel < 0)
+        {
+            gpio_set_level(channel->pin, op->value);
+        }
+        else
+        {
+            ledc_set_duty(LED_PWM_MODE, channel->ledc_channel, op->value ? LED_DUTY_MAX : 0);
+            ledc_update_duty(LED_PWM_MODE, channel->ledc_channel);
+        }
+        break;
+    case LED_OP_DUTY:
+        ledc_set_duty(LED_PWM_MODE, channel->ledc_channel, brightness_to_duty(op->value));
+        ledc_update_duty(LED_PWM_MODE, channel->ledc_channel);
+        break;
+    case LED_OP_FADE:
+        ledc_set_fade_with_time(LED_PWM_MODE, channel->ledc_channel, brightness_to_duty(op->value), op->time_ms);
+        ledc_fade_start(LED_PWM_MODE, channel->ledc_channel, LEDC_FADE_NO_WAIT);
+        break;
+    default:
+        break;
+    }
+}
+
+// Apply operations up to the next delay, then arm the timer for the remainder
+static void led_sequence_run(void)
+{
+    led_sequence_due_us = 0;
+    while (led_sequence_pos < led_sequence.count)
+    {
+        const led_op_t *op = &led_sequence.ops[led_sequence_pos++];
+        if (op->type == LED_OP_DELAY)
+        {
+            led_sequence_due_us = esp_timer_get_time() + (int64_t)op->time_ms * 1000;
+            esp_timer_start_once(led_sequence_timer, (uint64_t)op->time_ms * 1000);
+            return;
+        }
+        led_apply_op(op);
+    }
+}
+
+static void led_sequence_timer_cb(void *arg)
+{
+    xTaskNotify(led_actuator_task_handle, LED_NOTIFY_TIMER, eSetBits);
+}
+
+static bool led_op_is_write(const led_op_t *op)
+{
+    return op->type == LED_OP_SET || op->type == LED_OP_DUTY;
+}
+
+// Mark in `dropped` the operations of the burst a later batch makes invisible:
+// a whole batch whose every channel is set again by a later batch, and a set or
+// duty write followed on its channel by a write of the same kind from a later
+// batch. Operations within one batch are never dropped.
+static void led_burst_coalesce(size_t taken, uint32_t dropped[])
+{
+    bool written_later[LED_CHANNEL_COUNT] = {false};
+    uint8_t next_type[LED_CHANNEL_COUNT];
+    size_t next_batch[LED_CHANNEL_COUNT];
+
+    memset(next_type, LED_OP_COUNT, sizeof(next_type));
+    for (size_t b = taken; b-- > 0;)
+    {
+        const led_batch_t *batch = &led_burst[b];
+        bool superseded = batch->count > 0;
+
+        dropped[b] = 0;
+        for (size_t i = 0; i < batch->count; i++)
+        {
+            superseded = superseded && written_later[batch->ops[i].channel];
+        }
+        for (size_t i = batch->count; i-- > 0;)
+        {
+            const led_op_t *op = &batch->ops[i];
+            if (superseded ||
+                (led_op_is_write(op) && next_type[op->channel] == op->type && next_batch[op->channel] != b))
+            {
+                dropped[b] |= 1u << i;
+                metrics_inc(&ops_coalesced);
+            }
+            next_type[op->channel] = op->type;
+            next_batch[op->channel] = b;
+        }
+        for (size_t i = 0; i < batch->count; i++)
+        {
+            if (led_op_is_write(&batch->ops[i]))
+            {
+                written_later[batch->ops[i].channel] = true;
+            }
+        }
+    }
+}
+
+// Take every queued batch and apply the burst as one. Each batch replaces the
+// sequence of the one before it, so only the last sequence keeps its delayed
+// operations. The immediate operations of every batch are applied in order,
+// less those led_burst_coalesce finds overridden: on, off, on sent as three
+// requests is a single write, but a duty write before a fade is kept.
+static void led_apply_commands(void)
+{
+    uint32_t dropped[LED_COMMAND_QUEUE_LEN]; // One bit per operation, LED_BATCH_MAX is 32
+    int64_t queued_us[LED_COMMAND_QUEUE_LEN];
+    size_t taken = 0;
+    unsigned head = atomic_load_explicit(&led_command_head, memory_order_relaxed);
+
+    while (taken < LED_COMMAND_QUEUE_LEN)
+    {
+        struct led_command *slot = &led_commands[head % LED_COMMAND_QUEUE_LEN];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != head + 1)
+        {
+            break;
+        }
+        queued_us[taken] = slot->queued_us;
+        led_sequence.count = slot->batch.count;
+        memcpy(led_sequence.ops, slot->batch.ops, slot->batch.count * sizeof(led_op_t));
+        atomic_store_explicit(&slot->seq, head + LED_COMMAND_QUEUE_LEN, memory_order_release);
+        atomic_store_explicit(&led_command_head, ++head, memory_order_relaxed);
+
+        for (led_sequence_pos = 0; led_sequence_pos < led_sequence.count &&
+                                   led_sequence.ops[led_sequence_pos].type != LED_OP_DELAY;
+             led_sequence_pos++)
+        {
+        }
+        led_burst[taken].count = led_sequence_pos;
+        memcpy(led_burst[taken].ops, led_sequence.ops, led_sequence_pos * sizeof(led_op_t));
+        taken++;
+    }
+    if (taken == 0)
+    {
+        return;
+    }
+    if (taken == LED_COMMAND_QUEUE_LEN)
+    {
+        // Come back for anything queued meanwhile
+        xTaskNotify(led_actuator_task_handle, LED_NOTIFY_COMMAND, eSetBits);
+    }
+
+    led_burst_coalesce(taken, dropped);
+    esp_timer_stop(led_sequence_timer);
+    for (size_t b = 0; b < taken; b++)
+    {
+        for (size_t i = 0; i < led_burst[b].count; i++)
+        {
+            if (!(dropped[b] & 1u << i))
+            {
+                led_apply_op(&led_burst[b].ops[i]);
+            }
+        }
+    }
+    for (size_t i = 0; i < taken; i++)
+    {
+        metrics_observe_since(&command_latency, queued_us[i]);
+    }
+    led_sequence_run();
+    ESP_LOGD(TAG, "Applied %u batches", (unsigned)taken);
+}
+
+// The only task touching the outputs. It runs below httpd, so a request is
+// answered before its command is applied and bursts arrive here together.
+static void led_actuator_task(void *pvParameter)
+{
+    while (1)
+    {
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+        if (events & LED_NOTIFY_COMMAND)
+        {
+            led_apply_commands();
+        }
+        // A timer that fired just before its sequence was replaced is ignored
+        if ((events & LED_NOTIFY_TIMER) && led_sequence_due_us != 0 && esp_timer_get_time() >= led_sequence_due_us)
+        {
+            led_sequence_run();
+        }
+    }
+}
+
+void led_control_init(void)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    ledc_timer_config_t timer_config = {
+        .speed_mode = LED_PWM_MODE,
+        .duty_resolution = LED_PWM_RESOLUTION,
+        .timer_num = LED_PWM_TIMER,
+        .freq_hz = LED_PWM_FREQ_HZ,
+        .clk_cfg = LEDC_AUTO_CLK,
+    };
+    ledc_timer_config(&timer_config);
+    ledc_fade_func_install(0);
+#endif
+
+    for (size_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        if (led_channels[i].ledc_channel < 0)
+        {
+            esp_rom_gpio_pad_select_gpio(led_channels[i].pin);
+            gpio_set_direction(led_channels[i].pin, GPIO_MODE_OUTPUT);
+        }
+#if !CONFIG_IDF_TARGET_LINUX
+        else
+        {
+            ledc_channel_config_t channel_config = {
+                .gpio_num = led_channels[i].pin,
+                .speed_mode = LED_PWM_MODE,
+                .channel = led_channels[i].ledc_channel,
+                .timer_sel = LED_PWM_TIMER,
+                .duty = 0,
+            };
+            ledc_channel_config(&channel_config);
+        }
+#endif
+    }
+
+    for (unsigned i = 0; i < LED_COMMAND_QUEUE_LEN; i++)
+    {
+        atomic_init(&led_commands[i].seq, i);
+    }
+    const esp_timer_create_args_t timer_args = {
+        .callback = led_sequence_timer_cb,
+        .name = "led_sequence",
+    };
+    esp_timer_create(&timer_args, &led_sequence_timer);
+    xTaskCreate(led_actuator_task, "led_actuator", LED_ACTUATOR_TASK_STACK, NULL, LED_ACTUATOR_TASK_PRIORITY,
+                &led_actuator_task_handle);
+}
+
+static uint32_t command_queue_depth(void)
+{
+    return atomic_load(&led_command_tail) - atomic_load(&led_command_head);
+}
+
+void led_control_register_metrics(void)
+{
+    metrics_register_histogram(&command_latency, "Delay from queueing a batch to its outputs being written");
+    metrics_register_counter(&ops_coalesced, "Operations overridden by a later one in the same burst");
+    metrics_register_counter(&commands_rejected, "Batches refused while the command queue was full");
+    metrics_register_gauge("led_command_queue_depth", NULL, "Batches waiting for the actuator task", command_queue_depth);
+}
+
+size_t led_control_channel_count(void)
+{
+    return LED_CHANNEL_COUNT;
+}
+
+static bool led_op_valid(const led_op_t *op)
+{
+    if (op->type == LED_OP_DELAY)
+    {
+        return true;
+    }
+    if (op->type >= LED_OP_COUNT || op->channel >= LED_CHANNEL_COUNT)
+    {
+        return false;
+    }
+    bool pwm = led_channels[op->channel].ledc_channel >= 0;
+    switch (op->type)
+    {
+    case LED_OP_SET:
+        return op->value <= 1;
+    case LED_OP_DUTY:
+        return pwm && op->value <= 255;
+    case LED_OP_FADE:
+        return pwm && op->value <= 255 && op->time_ms > 0;
+    default:
+        return false;
+    }
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Parse one "name:field:field" token into an operation
+static bool led_op_parse_token(char *token, led_op_t *op)
+{
+    static const char *names[LED_OP_COUNT] = {"set", "duty", "fade", "delay"};
+    unsigned long fields[3] = {0};
+    size_t field_count = 0;
+    char *cursor = strchr(token, ':');
+
+    if (cursor == NULL)
+    {
+        return false;
+    }
+    *cursor++ = '\0';
+    while (1)
+    {
+        char *end;
+        fields[field_count++] = strtoul(cursor, &end, 10);
+        if (end == cursor || fields[field_count - 1] > UINT16_MAX)
+        {
+            return false;
+        }
+        if (*end == '\0')
+        {
+            break;
+        }
+        // No operation takes more than three fields, so a fourth one is an error
+        if (*end != ':' || field_count == 3)
+        {
+            return false;
+        }
+        cursor = end + 1;
+    }
+
+    memset(op, 0, sizeof(*op));
+    for (op->type = 0; op->type < LED_OP_COUNT && strcmp(token, names[op->type]) != 0; op->type++)
+    {
+    }
+    switch (op->type)
+    {
+    case LED_OP_SET:
+    case LED_OP_DUTY:
+        op->channel = fields[0];
+        op->value = fields[1];
+        return field_count == 2 && fields[0] <= UINT8_MAX;
+    case LED_OP_FADE:
+        op->channel = fields[0];
+        op->value = fields[1];
+        op->time_ms = fields[2];
+        return field_count == 3 && fields[0] <= UINT8_MAX;
+    case LED_OP_DELAY:
+        op->time_ms = fields[0];
+        return field_count == 1;
+    default:
+        return false;
+    }
+}
+
+void led_batch_parser_init(led_batch_parser_t *parser, bool binary, led_batch_t *batch)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->batch = batch;
+    parser->binary = binary;
+    batch->count = 0;
+}
+
+static esp_err_t batch_fail(led_batch_parser_t *parser, esp_err_t err)
+{
+    if (parser->err == ESP_OK)
+    {
+        parser->err = err;
+        parser->bad_op = parser->batch->count;
+    }
+    return parser->err;
+}
+
+// The text token in `pending` is complete
+static void text_token_end(led_batch_parser_t *parser)
+{
+    led_batch_t *batch = parser->batch;
+    char *token = parser->pending;
+
+    if (parser->len == 0)
+    {
+        return;
+    }
+    token[parser->len] = '\0';
+    parser->len = 0;
+    if (batch->count == 0 && strncmp(token, "ops=", 4) == 0)
+    {
+        token += 4;
+    }
+    if (batch->count == LED_BATCH_MAX || !led_op_parse_token(token, &batch->ops[batch->count]) ||
+        !led_op_valid(&batch->ops[batch->count]))
+    {
+        batch_fail(parser, ESP_ERR_INVALID_ARG);
+        return;
+    }
+    batch->count++;
+}
+
+static void text_char(led_batch_parser_t *parser, char c)
+{
+    if (c == ';' || c == ',')
+    {
+        text_token_end(parser);
+    }
+    else if (c != ' ' && c != '+' && c != '\r' && c != '\n')
+    {
+        if (parser->len == sizeof(parser->pending) - 1)
+        {
+            batch_fail(parser, ESP_ERR_INVALID_ARG);
+            return;
+        }
+        parser->pending[parser->len++] = c;
+    }
+}
+
+static void binary_byte(led_batch_parser_t *parser, uint8_t byte)
+{
+    led_batch_t *batch = parser->batch;
+    const uint8_t *record = (const uint8_t *)parser->pending;
+
+    if (batch->count == LED_BATCH_MAX)
+    {
+        batch_fail(parser, ESP_ERR_INVALID_SIZE);
+        return;
+    }
+    parser->pending[parser->len++] = byte;
+    if (parser->len < LED_OP_WIRE_SIZE)
+    {
+        return;
+    }
+    parser->len = 0;
+    led_op_t *op = &batch->ops[batch->count];
+    op->type = record[0];
+    op->channel = record[1];
+    op->value = record[2] | record[3] << 8;
+    op->time_ms = record[4] | record[5] << 8;
+    if (!led_op_valid(op))
+    {
+        batch_fail(parser, ESP_ERR_INVALID_ARG);
+        return;
+    }
+    batch->count++;
+}
+
+esp_err_t led_batch_parser_feed(led_batch_parser_t *parser, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len && parser->err == ESP_OK; i++)
+    {
+        char c = data[i];
+        if (parser->binary)
+        {
+            binary_byte(parser, c);
+        }
+        else if (parser->escape > 0)
+        {
+            int digit = hex_value(c);
+            if (digit < 0)
+            {
+                batch_fail(parser, ESP_ERR_INVALID_ARG);
+            }
+            else if (parser->escape++ == 1)
+            {
+                parser->code = digit;
+            }
+            else
+            {
+                parser->escape = 0;
+                text_char(parser, parser->code << 4 | digit);
+            }
+        }
+        else if (c == '%')
+        {
+            parser->escape = 1;
+        }
+        else
+        {
+            text_char(parser, c);
+        }
+    }
+    return parser->err;
+}
+
+esp_err_t led_batch_parser_finish(led_batch_parser_t *parser)
+{
+    if (parser->err != ESP_OK)
+    {
+        return parser->err;
+    }
+    if (parser->binary)
+    {
+        if (parser->len > 0)
+        {
+            return batch_fail(parser, ESP_ERR_INVALID_SIZE);
+        }
+    }
+    else if (parser->escape > 0)
+    {
+        return batch_fail(parser, ESP_ERR_INVALID_ARG);
+    }
+    else
+    {
+        text_token_end(parser);
+    }
+    if (parser->err == ESP_OK && parser->batch->count == 0)
+    {
+        batch_fail(parser, ESP_ERR_INVALID_SIZE);
+    }
+    return parser->err;
+}
+
+esp_err_t led_batch_submit(const led_batch_t *batch)
+{
+    unsigned pos = atomic_load_explicit(&led_command_tail, memory_order_relaxed);
+    struct led_command *slot;
+
+    while (1)
+    {
+        slot = &led_commands[pos % LED_COMMAND_QUEUE_LEN];
+        int diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&led_command_tail, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The actuator task is still on an older lap of the ring
+            metrics_inc(&commands_rejected);
+            return ESP_ERR_NO_MEM;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&led_command_tail, memory_order_relaxed);
+        }
+    }
+    slot->queued_us = esp_timer_get_time();
+    slot->batch.count = batch->count;
+    memcpy(slot->batch.ops, batch->ops, batch->count * sizeof(led_op_t));
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    xTaskNotify(led_actuator_task_handle, LED_NOTIFY_COMMAND, eSetBits);
+
+    ESP_LOGI(TAG, "Queued batch of %u operations", (unsigned)batch->count);
+    return ESP_OK;
+}
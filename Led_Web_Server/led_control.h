@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Most operations accepted in one request
+#define LED_BATCH_MAX 32
+
+// Batches queued for the actuator task, a power of two
+#define LED_COMMAND_QUEUE_LEN 8
+
+// The actuator task runs below httpd (priority 5), so replies go out first
+#ifndef LED_ACTUATOR_TASK_PRIORITY
+#define LED_ACTUATOR_TASK_PRIORITY 4
+#endif
+#ifndef LED_ACTUATOR_TASK_STACK
+#define LED_ACTUATOR_TASK_STACK 3072
+#endif
+
+// Size of one operation in the binary encoding
+#define LED_OP_WIRE_SIZE 6
+
+typedef enum {
+    LED_OP_SET,   // Channel on/off: value 0 or 1
+    LED_OP_DUTY,  // PWM brightness: value 0-255
+    LED_OP_FADE,  // PWM fade to brightness `value` over `time_ms`
+    LED_OP_DELAY, // Wait `time_ms` before the following operations
+    LED_OP_COUNT,
+} led_op_type_t;
+
+// One operation. The binary encoding is this layout packed little endian:
+// type (1 byte), channel (1), value (2), time_ms (2).
+typedef struct {
+    uint8_t type;
+    uint8_t channel;
+    uint16_t value;
+    uint16_t time_ms;
+} led_op_t;
+
+typedef struct {
+    led_op_t ops[LED_BATCH_MAX];
+    size_t count;
+} led_batch_t;
+
+// Configure every output channel, PWM channels through LEDC, and start the
+// actuator task, the only task that writes to them
+void led_control_init(void);
+
+// Add the command queue metrics to /metrics, before the HTTP server starts
+void led_control_register_metrics(void);
+
+size_t led_control_channel_count(void);
+
+// Text encoding: operations separated by ';' or ',', fields by ':'
+//   set:<ch>:<0|1>  duty:<ch>:<0-255>  fade:<ch>:<0-255>:<ms>  delay:<ms>
+// An optional leading "ops=" and %XX escapes from a form post are accepted.
+// The binary encoding is a sequence of LED_OP_WIRE_SIZE-byte records.
+// Bodies are parsed as they arrive off the socket: memory is one token or one
+// binary record, whatever the body size.
+typedef struct {
+    led_batch_t *batch;
+    bool binary;
+    esp_err_t err;    // Sticky, the first error stops the parse
+    size_t bad_op;    // Index of the rejected operation once err is set
+    uint8_t escape;   // Progress through a %XX escape
+    uint8_t code;     // Escape digits so far
+    uint8_t len;      // Bytes in `pending`
+    char pending[32]; // Text token or binary record so far, chunks split them anywhere
+} led_batch_parser_t;
+
+void led_batch_parser_init(led_batch_parser_t *parser, bool binary, led_batch_t *batch);
+
+// Feed the next chunk; chunks may split operations and escapes anywhere
+esp_err_t led_batch_parser_feed(led_batch_parser_t *parser, const char *data, size_t len);
+
+// End of body: parse the last operation and check the batch is not empty
+esp_err_t led_batch_parser_finish(led_batch_parser_t *parser);
+
+// Queue `batch` for the actuator task and return without waiting for it, lock
+// free and safe from any task. The batch replaces the running sequence: its
+// operations up to the first delay are applied together, the rest follow on a
+// timer, and no other batch interleaves with them. Of a burst of batches, each
+// one's operations are still applied in order; only writes a later batch
+// overrides are skipped. ESP_ERR_NO_MEM while LED_COMMAND_QUEUE_LEN batches are waiting.
+esp_err_t led_batch_submit(const led_batch_t *batch);
@@ -0,0 +1,187 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "metrics.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_heap_caps.h"
+#endif
+
+#define METRICS_LINE_MAX 160
+
+static const char *TAG = "metrics";
+
+static const uint32_t bucket_bounds_us[METRICS_BUCKETS - 1] = METRICS_BUCKET_BOUNDS_US;
+
+typedef enum {
+    METRIC_HISTOGRAM,
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_COUNTER_FN,
+} metric_type_t;
+
+static struct metric_entry {
+    metric_type_t type;
+    const char *name;
+    const char *labels;
+    const char *help;
+    union {
+        metrics_histogram_t *histogram;
+        metrics_counter_t *counter;
+        metrics_gauge_fn_t read;
+    };
+} entries[METRICS_MAX_ENTRIES];
+static size_t entry_count;
+
+static void add_entry(const struct metric_entry *entry) {
+    if (entry_count == METRICS_MAX_ENTRIES) {
+        ESP_LOGE(TAG, "No room for %s", entry->name);
+        return;
+    }
+    entries[entry_count++] = *entry;
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+static uint32_t heap_free(void) {
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+static uint32_t heap_min_free(void) {
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+}
+#endif
+
+void metrics_init(void) {
+#if !CONFIG_IDF_TARGET_LINUX
+    metrics_register_gauge("heap_free_bytes", NULL, "Free 8-bit capable heap", heap_free);
+    metrics_register_gauge("heap_min_free_bytes", NULL, "Lowest free heap since boot", heap_min_free);
+#endif
+}
+
+void metrics_register_histogram(metrics_histogram_t *histogram, const char *help) {
+    add_entry(&(struct metric_entry){METRIC_HISTOGRAM, histogram->name, histogram->labels, help,
+                                     .histogram = histogram});
+}
+
+void metrics_register_counter(metrics_counter_t *counter, const char *help) {
+    add_entry(&(struct metric_entry){METRIC_COUNTER, counter->name, counter->labels, help,
+                                     .counter = counter});
+}
+
+void metrics_register_gauge(const char *name, const char *labels, const char *help, metrics_gauge_fn_t read) {
+    add_entry(&(struct metric_entry){METRIC_GAUGE, name, labels, help, .read = read});
+}
+
+void metrics_register_counter_fn(const char *name, const char *labels, const char *help, metrics_gauge_fn_t read) {
+    add_entry(&(struct metric_entry){METRIC_COUNTER_FN, name, labels, help, .read = read});
+}
+
+void metrics_observe(metrics_histogram_t *histogram, uint32_t duration_us) {
+    size_t bucket = 0;
+    while (bucket < METRICS_BUCKETS - 1 && duration_us > bucket_bounds_us[bucket]) {
+        bucket++;
+    }
+    // Buckets are stored non-cumulative so one observation is one add per field
+    atomic_fetch_add_explicit(&histogram->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum_us, duration_us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+}
+
+esp_err_t metrics_timed_handler(httpd_req_t *req) {
+    const metrics_route_t *route = req->user_ctx;
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = route->handler(req);
+    metrics_observe_since(route->histogram, start_us);
+    return err;
+}
+
+// Response assembled line by line and sent whenever the next line might not fit
+struct metrics_writer {
+    httpd_req_t *req;
+    char chunk[512];
+    int len;
+    esp_err_t err;
+};
+
+static void writer_printf(struct metrics_writer *writer, const char *format, ...) {
+    if (writer->err != ESP_OK) {
+        return;
+    }
+    if (sizeof(writer->chunk) - writer->len < METRICS_LINE_MAX) {
+        writer->err = httpd_resp_send_chunk(writer->req, writer->chunk, writer->len);
+        writer->len = 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(writer->chunk + writer->len, METRICS_LINE_MAX, format, args);
+    va_end(args);
+    writer->len += len < METRICS_LINE_MAX ? len : METRICS_LINE_MAX - 1;
+}
+
+// Series name with its labels plus an optional extra label, e.g. name{route="/",le="250"}
+static void write_series(struct metrics_writer *writer, const char *name, const char *suffix,
+                         const char *labels, const char *extra) {
+    bool braces = labels || extra;
+    writer_printf(writer, "%s%s%s%s%s%s%s ", name, suffix, braces ? "{" : "", labels ? labels : "",
+                  labels && extra ? "," : "", extra ? extra : "", braces ? "}" : "");
+}
+
+static void write_histogram(struct metrics_writer *writer, const struct metric_entry *entry) {
+    const metrics_histogram_t *histogram = entry->histogram;
+    char le[24];
+    uint32_t cumulative = 0;
+
+    for (size_t i = 0; i < METRICS_BUCKETS; i++) {
+        cumulative += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        if (i < METRICS_BUCKETS - 1) {
+            snprintf(le, sizeof(le), "le=\"%lu.%06lu\"", (unsigned long)(bucket_bounds_us[i] / 1000000),
+                     (unsigned long)(bucket_bounds_us[i] % 1000000));
+        } else {
+            snprintf(le, sizeof(le), "le=\"+Inf\"");
+        }
+        write_series(writer, entry->name, "_bucket", entry->labels, le);
+        writer_printf(writer, "%lu\n", (unsigned long)cumulative);
+    }
+    uint32_t sum_us = atomic_load_explicit(&histogram->sum_us, memory_order_relaxed);
+    write_series(writer, entry->name, "_sum", entry->labels, NULL);
+    writer_printf(writer, "%lu.%06lu\n", (unsigned long)(sum_us / 1000000), (unsigned long)(sum_us % 1000000));
+    // Bucket totals are read first, so count may run ahead of +Inf by in-flight observations
+    write_series(writer, entry->name, "_count", entry->labels, NULL);
+    writer_printf(writer, "%lu\n", (unsigned long)atomic_load_explicit(&histogram->count, memory_order_relaxed));
+}
+
+esp_err_t metrics_handler(httpd_req_t *req) {
+    static const char *type_names[] = {"histogram", "counter", "gauge", "counter"};
+    struct metrics_writer writer = {.req = req};
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    for (size_t i = 0; i < entry_count; i++) {
+        const struct metric_entry *entry = &entries[i];
+        if (i == 0 || strcmp(entries[i - 1].name, entry->name) != 0) {
+            writer_printf(&writer, "# HELP %s %s\n# TYPE %s %s\n", entry->name, entry->help,
+                          entry->name, type_names[entry->type]);
+        }
+        switch (entry->type) {
+        case METRIC_HISTOGRAM:
+            write_histogram(&writer, entry);
+            break;
+        case METRIC_COUNTER:
+            write_series(&writer, entry->name, "", entry->labels, NULL);
+            writer_printf(&writer, "%lu\n",
+                          (unsigned long)atomic_load_explicit(&entry->counter->value, memory_order_relaxed));
+            break;
+        case METRIC_GAUGE:
+        case METRIC_COUNTER_FN:
+            write_series(&writer, entry->name, "", entry->labels, NULL);
+            writer_printf(&writer, "%lu\n", (unsigned long)entry->read());
+            break;
+        }
+    }
+    if (writer.err != ESP_OK) {
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, writer.chunk, writer.len);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
@@ -0,0 +1,17 @@
+// Generated by tools/route_hash.py from led.c, do not edit
+// 4 paths in 4 slots
+#ifndef ROUTES_HASH_H
+#define ROUTES_HASH_H
+
+#include <stdint.h>
+
+#define ROUTES_SEED 0x00000002u
+
+static const uint8_t routes_slots[4] = {
+    1, // /
+    4, // /metrics
+    2, // /ws
+    3, // /led
+};
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "esp_err.h"
+
+// Just the calls body_parser.c and asset_bundle.c make and the types metrics.h names; the test provides them
+#define HTTPD_SOCK_ERR_FAIL -1
+#define HTTPD_SOCK_ERR_INVALID -2
+#define HTTPD_SOCK_ERR_TIMEOUT -3
+
+typedef struct httpd_req {
+    size_t content_len;
+    void *user_ctx;
+} httpd_req_t;
+
+int httpd_req_recv(httpd_req_t *req, char *buf, size_t buf_len);
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value);
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status);
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type);
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// Single-threaded host tests: just enough of the FreeRTOS types to compile
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef struct task *TaskHandle_t;
+
+typedef enum {
+    eNoAction,
+    eSetBits,
+} eNotifyAction;
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// No scheduler on the host: the test provides these and runs the task body itself
+BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack, void *arg, int priority,
+                       TaskHandle_t *handle);
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks);
@@ -0,0 +1,4 @@
+#pragma once
+
+// Host test build: select the linux stand-ins of the modules under test
+#define CONFIG_IDF_TARGET_LINUX 1
@@ -0,0 +1,352 @@
+// Host test for body_parser.c: form and JSON bodies split into chunks at every
+// position, escapes, skipped nested values, integer limits, unknown keys,
+// truncated bodies and the receive loop's timeout limit. Build and run from the
+// project directory:
+//
+//   gcc -std=gnu11 -O2 -Itest/host -I. test/test_body_parser.c body_parser.c -o /tmp/test_body_parser && /tmp/test_body_parser
+//
+// Led_Web_Server and Sensor_Web_Server carry the same body_parser.c and this same test.
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "body_parser.h"
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+// What the field callbacks saw
+struct result {
+    char name[128];
+    size_t name_len;
+    unsigned name_fragments;
+    bool name_done;
+    bool has_level;
+    int32_t level;
+    bool has_led;
+    bool led;
+};
+
+static esp_err_t on_name(const char *data, size_t len, bool last, void *ctx) {
+    struct result *result = ctx;
+    CHECK(!result->name_done);
+    CHECK(len <= BODY_TEXT_CHUNK);
+    CHECK(result->name_len + len < sizeof(result->name));
+    memcpy(result->name + result->name_len, data, len);
+    result->name_len += len;
+    result->name_fragments++;
+    result->name_done = last;
+    return ESP_OK;
+}
+
+static esp_err_t on_level(int32_t value, void *ctx) {
+    struct result *result = ctx;
+    result->has_level = true;
+    result->level = value;
+    // Stands in for a handler rejecting a value it cannot use
+    return value == 666 ? ESP_ERR_INVALID_SIZE : ESP_OK;
+}
+
+static esp_err_t on_led(bool value, void *ctx) {
+    struct result *result = ctx;
+    result->has_led = true;
+    result->led = value;
+    return ESP_OK;
+}
+
+static const body_field_t fields[] = {
+    BODY_TEXT("name", on_name),
+    BODY_INT("level", on_level),
+    BODY_BOOL("led", on_led),
+    // Shares a prefix with "led", so matching has to tell them apart
+    BODY_INT("ledger", on_level),
+};
+
+// Feed `body` in chunks of `step` bytes
+static esp_err_t parse_steps(body_format_t format, const char *body, size_t step, struct result *result) {
+    body_parser_t parser;
+    size_t len = strlen(body);
+
+    memset(result, 0, sizeof(*result));
+    body_parser_init(&parser, format, fields, sizeof(fields) / sizeof(fields[0]), result);
+    for (size_t i = 0; i < len; i += step) {
+        body_parser_feed(&parser, body + i, len - i < step ? len - i : step);
+    }
+    return body_parser_finish(&parser);
+}
+
+// Feed `body` in two pieces, cut at `cut`
+static esp_err_t parse_cut(body_format_t format, const char *body, size_t cut, struct result *result) {
+    body_parser_t parser;
+
+    memset(result, 0, sizeof(*result));
+    body_parser_init(&parser, format, fields, sizeof(fields) / sizeof(fields[0]), result);
+    body_parser_feed(&parser, body, cut);
+    body_parser_feed(&parser, body + cut, strlen(body) - cut);
+    return body_parser_finish(&parser);
+}
+
+static esp_err_t parse(body_format_t format, const char *body, struct result *result) {
+    return parse_steps(format, body, strlen(body) + 1, result);
+}
+
+static bool same_result(const struct result *a, const struct result *b) {
+    return a->name_len == b->name_len && memcmp(a->name, b->name, a->name_len) == 0 && a->name_done == b->name_done &&
+           a->has_level == b->has_level && a->level == b->level && a->has_led == b->has_led && a->led == b->led;
+}
+
+// Every way of cutting the body into pieces gives the same fields and the same error
+static void check_splits(body_format_t format, const char *body) {
+    struct result expected, result;
+    esp_err_t err = parse(format, body, &expected);
+    size_t len = strlen(body);
+
+    for (size_t step = 1; step <= len; step++) {
+        CHECK(parse_steps(format, body, step, &result) == err);
+        CHECK(same_result(&result, &expected));
+    }
+    for (size_t cut = 0; cut <= len; cut++) {
+        CHECK(parse_cut(format, body, cut, &result) == err);
+        CHECK(same_result(&result, &expected));
+    }
+}
+
+static void check_name(const struct result *result, const char *name) {
+    CHECK(result->name_done);
+    CHECK(result->name_len == strlen(name));
+    CHECK(memcmp(result->name, name, result->name_len) == 0);
+}
+
+static void test_splits(void) {
+    static const char *form_bodies[] = {
+        "name=desk%20lamp+2&level=-42&led=on",
+        "led&name=%E2%82%AC&ledger=7&unknown=%zz",
+        "level=12&level=2147483648",
+        "name=a%2",
+    };
+    static const char *json_bodies[] = {
+        "{\"name\": \"desk \\\"lamp\\\" \\u00e9\\u20ac\", \"level\": \"5\", \"led\": false}",
+        " { \"skip\": {\"a\": [1, {\"b\": \"}]\\\"\"}]}, \"led\": true, \"level\": -7 } ",
+        "{\"level\": 12, \"ledger\": 3",
+        "{\"name\": \"" "0123456789012345678901234567890123456789012345678901234567890123456789" "\"}",
+    };
+
+    for (size_t i = 0; i < sizeof(form_bodies) / sizeof(form_bodies[0]); i++) {
+        check_splits(BODY_FORMAT_FORM, form_bodies[i]);
+    }
+    for (size_t i = 0; i < sizeof(json_bodies) / sizeof(json_bodies[0]); i++) {
+        check_splits(BODY_FORMAT_JSON, json_bodies[i]);
+    }
+}
+
+static void test_form(void) {
+    struct result result;
+
+    CHECK(parse(BODY_FORMAT_FORM, "name=desk%20lamp+2%2f%2F&level=-42&led=on", &result) == ESP_OK);
+    check_name(&result, "desk lamp 2//");
+    CHECK(result.has_level && result.level == -42);
+    CHECK(result.has_led && result.led);
+
+    // A bare key is a checked box; unknown keys and their values are skipped
+    CHECK(parse(BODY_FORMAT_FORM, "foo=%41%42&led&bar", &result) == ESP_OK);
+    CHECK(result.has_led && result.led && !result.has_level && result.name_len == 0);
+    CHECK(parse(BODY_FORMAT_FORM, "led=off", &result) == ESP_OK && result.has_led && !result.led);
+    CHECK(parse(BODY_FORMAT_FORM, "led=maybe", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_FORM, "level", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_FORM, "", &result) == ESP_OK);
+
+    // Bad and cut-off escapes
+    CHECK(parse(BODY_FORMAT_FORM, "name=%g1", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_FORM, "name=ab%4", &result) == ESP_ERR_INVALID_ARG);
+}
+
+static void test_json(void) {
+    struct result result;
+
+    CHECK(parse(BODY_FORMAT_JSON, "{\"name\": \"a\\u00e9\\u20ac\\ud83d\\n\\\"\\\\\\/\", \"level\": 3}", &result) ==
+          ESP_OK);
+    check_name(&result, "a\xc3\xa9\xe2\x82\xac?\n\"\\/");
+    CHECK(result.level == 3);
+
+    // Strings and bare tokens fill the same field types
+    CHECK(parse(BODY_FORMAT_JSON, "{\"level\": \"17\", \"led\": \"on\"}", &result) == ESP_OK);
+    CHECK(result.level == 17 && result.led);
+    CHECK(parse(BODY_FORMAT_JSON, "{}", &result) == ESP_OK && !result.has_level);
+
+    // Nested values are skipped under unknown keys, brackets in their strings included
+    CHECK(parse(BODY_FORMAT_JSON,
+                "{\"a\": {\"b\": [1, 2, {\"c\": \"]}\\\"{\"}], \"d\": {}}, \"e\": [[[]]], \"f\": null, \"level\": 9}",
+                &result) == ESP_OK);
+    CHECK(result.level == 9 && !result.has_led);
+    // but never stand in for a known field's value
+    CHECK(parse(BODY_FORMAT_JSON, "{\"level\": {\"x\": 1}}", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"name\": [\"x\"]}", &result) == ESP_ERR_INVALID_ARG);
+
+    // Malformed and truncated bodies
+    CHECK(parse(BODY_FORMAT_JSON, "{\"level\": 3", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"level\": 3,", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"name\": \"ab", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"name\": \"\\u12", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"skip\": [1, 2", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"level\" 3}", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"level\": 3}}", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"name\": \"a\\x\"}", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"name\": \"a\nb\"}", &result) == ESP_ERR_INVALID_ARG);
+}
+
+static void test_integers(void) {
+    struct result result;
+
+    CHECK(parse(BODY_FORMAT_FORM, "level=2147483647", &result) == ESP_OK && result.level == INT32_MAX);
+    CHECK(parse(BODY_FORMAT_FORM, "level=-2147483648", &result) == ESP_OK && result.level == INT32_MIN);
+    CHECK(parse(BODY_FORMAT_FORM, "level=2147483648", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_FORM, "level=-2147483649", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"level\": 99999999999999999999}", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_FORM, "level=00012", &result) == ESP_OK && result.level == 12);
+    CHECK(parse(BODY_FORMAT_FORM, "level=-", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_FORM, "level=1-2", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_FORM, "level=--1", &result) == ESP_ERR_INVALID_ARG);
+    CHECK(parse(BODY_FORMAT_JSON, "{\"level\": 1.5}", &result) == ESP_ERR_INVALID_ARG);
+    // A callback error stops the parse and comes back unchanged
+    CHECK(parse(BODY_FORMAT_FORM, "level=666&led=on", &result) == ESP_ERR_INVALID_SIZE && !result.has_led);
+}
+
+static void test_text_fragments(void) {
+    char body[128] = "name=";
+    char name[71] = "";
+    struct result result;
+
+    for (int i = 0; i < 70; i++) {
+        name[i] = 'a' + i % 26;
+    }
+    strcat(body, name);
+    CHECK(parse(BODY_FORMAT_FORM, body, &result) == ESP_OK);
+    check_name(&result, name);
+    CHECK(result.name_fragments == 3);
+
+    // A value exactly one fragment long ends with an empty last fragment
+    CHECK(parse(BODY_FORMAT_FORM, "name=0123456789abcdef0123456789abcdef", &result) == ESP_OK);
+    CHECK(result.name_len == BODY_TEXT_CHUNK && result.name_fragments == 2);
+}
+
+// Scripted socket for body_recv_chunks: each step is a byte count to deliver or a
+// receive error, and once the steps run out the rest of the body arrives
+static struct {
+    const char *body;
+    size_t pos;
+    const int *steps;
+    size_t step_count;
+    size_t step;
+    unsigned calls;
+    const char *content_type;
+} sock;
+
+int httpd_req_recv(httpd_req_t *req, char *buf, size_t buf_len) {
+    size_t rest = strlen(sock.body) - sock.pos;
+    size_t n = rest;
+
+    sock.calls++;
+    if (sock.step < sock.step_count) {
+        int step = sock.steps[sock.step++];
+        if (step <= 0) {
+            return step;
+        }
+        n = (size_t)step;
+    }
+    n = n < buf_len ? n : buf_len;
+    n = n < rest ? n : rest;
+    memcpy(buf, sock.body + sock.pos, n);
+    sock.pos += n;
+    return (int)n;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size) {
+    CHECK(strcmp(field, "Content-Type") == 0);
+    if (sock.content_type == NULL) {
+        return ESP_FAIL;
+    }
+    snprintf(val, val_size, "%s", sock.content_type);
+    return ESP_OK;
+}
+
+static httpd_req_t *open_request(const char *body, const int *steps, size_t step_count, const char *type) {
+    static httpd_req_t req;
+
+    sock.body = body;
+    sock.pos = 0;
+    sock.steps = steps;
+    sock.step_count = step_count;
+    sock.step = 0;
+    sock.calls = 0;
+    sock.content_type = type;
+    req.content_len = strlen(body);
+    return &req;
+}
+
+static esp_err_t count_bytes(const char *data, size_t len, void *ctx) {
+    *(size_t *)ctx += len;
+    return ESP_OK;
+}
+
+static void test_recv(void) {
+    static const int recovers[] = {HTTPD_SOCK_ERR_TIMEOUT, HTTPD_SOCK_ERR_TIMEOUT, 5,
+                                   HTTPD_SOCK_ERR_TIMEOUT, HTTPD_SOCK_ERR_TIMEOUT, 3};
+    static const int stalls[] = {4, HTTPD_SOCK_ERR_TIMEOUT, HTTPD_SOCK_ERR_TIMEOUT, HTTPD_SOCK_ERR_TIMEOUT, 4};
+    static const int closes[] = {2, 0};
+    static const int fails[] = {HTTPD_SOCK_ERR_FAIL};
+    const char *body = "level=12&led=on&name=lamp";
+    struct result result;
+    size_t received;
+
+    // Timeouts below the limit are retried, and data in between resets the count
+    received = 0;
+    httpd_req_t *req = open_request(body, recovers, 6, NULL);
+    CHECK(body_recv_chunks(req, count_bytes, &received) == ESP_OK);
+    CHECK(received == strlen(body));
+
+    // Three in a row give up on the client
+    received = 0;
+    req = open_request(body, stalls, 5, NULL);
+    CHECK(body_recv_chunks(req, count_bytes, &received) == ESP_FAIL);
+    CHECK(received == 4 && sock.calls == 4);
+
+    req = open_request(body, closes, 2, NULL);
+    CHECK(body_recv_chunks(req, count_bytes, &received) == ESP_FAIL);
+    req = open_request(body, fails, 1, NULL);
+    CHECK(body_recv_chunks(req, count_bytes, &received) == ESP_FAIL);
+
+    // The whole path, format picked from the Content-Type
+    memset(&result, 0, sizeof(result));
+    req = open_request(body, recovers, 6, "application/x-www-form-urlencoded");
+    CHECK(body_parser_recv(req, fields, sizeof(fields) / sizeof(fields[0]), &result) == ESP_OK);
+    CHECK(result.level == 12 && result.led);
+    check_name(&result, "lamp");
+
+    memset(&result, 0, sizeof(result));
+    req = open_request("{\"level\": 4}", NULL, 0, "application/json; charset=utf-8");
+    CHECK(body_parser_recv(req, fields, sizeof(fields) / sizeof(fields[0]), &result) == ESP_OK);
+    CHECK(result.level == 4);
+
+    memset(&result, 0, sizeof(result));
+    req = open_request("{\"level\": 4", NULL, 0, "application/json");
+    CHECK(body_parser_recv(req, fields, sizeof(fields) / sizeof(fields[0]), &result) == ESP_ERR_INVALID_ARG);
+    req = open_request(body, stalls, 5, NULL);
+    CHECK(body_parser_recv(req, fields, sizeof(fields) / sizeof(fields[0]), &result) == ESP_FAIL);
+}
+
+int main(void) {
+    test_splits();
+    test_form();
+    test_json();
+    test_integers();
+    test_text_fragments();
+    test_recv();
+    printf("body_parser: all tests passed\n");
+    return 0;
+}
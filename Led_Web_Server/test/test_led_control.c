@@ -0,0 +1,369 @@
+// Host test for led_control.c: the incremental batch parser, text and binary,
+// fed in chunks of every size, and bursts of batches through the command queue
+// to the outputs, with the queue depth, latency and coalescing counters. Build
+// and run from the project directory:
+//
+//   gcc -std=gnu11 -O2 -Itest/host -I. test/test_led_control.c -o /tmp/test_led_control && /tmp/test_led_control
+//
+// The module is included directly so the test can reach its queue and counters.
+// The metrics, timer and task calls it makes are provided below.
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../led_control.c"
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+// Output writes logged by the GPIO and LEDC stand-ins, as "pin 2 -> 1;..."
+static char writes[1024];
+
+void host_log(char level, const char *tag, const char *fmt, ...) {
+    va_list args;
+    size_t len = strlen(writes);
+
+    if (strcmp(tag, "GPIO") != 0 && strcmp(tag, "LEDC") != 0) {
+        return;
+    }
+    va_start(args, fmt);
+    len += vsnprintf(writes + len, sizeof(writes) - len, fmt, args);
+    va_end(args);
+    CHECK(len + 1 < sizeof(writes));
+    strcat(writes, ";");
+}
+
+void metrics_register_histogram(metrics_histogram_t *histogram, const char *help) {
+}
+
+void metrics_register_counter(metrics_counter_t *counter, const char *help) {
+}
+
+void metrics_register_gauge(const char *name, const char *labels, const char *help, metrics_gauge_fn_t read) {
+}
+
+void metrics_observe(metrics_histogram_t *histogram, uint32_t duration_us) {
+    atomic_fetch_add(&histogram->count, 1);
+    atomic_fetch_add(&histogram->sum_us, duration_us);
+}
+
+static int64_t now_us = 1000000;
+static uint64_t timer_armed_us; // Timeout of the last esp_timer_start_once, 0 once stopped
+static unsigned notifies;
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle) {
+    *handle = NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    timer_armed_us = timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    timer_armed_us = 0;
+    return ESP_OK;
+}
+
+BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack, void *arg, int priority,
+                       TaskHandle_t *handle) {
+    *handle = NULL;
+    return pdPASS;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    notifies++;
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks) {
+    return pdTRUE;
+}
+
+// Parse `body` fed in chunks of `step` bytes
+static esp_err_t parse_steps(bool binary, const char *body, size_t len, size_t step, led_batch_t *batch,
+                             size_t *bad_op) {
+    led_batch_parser_t parser;
+
+    led_batch_parser_init(&parser, binary, batch);
+    for (size_t i = 0; i < len; i += step) {
+        led_batch_parser_feed(&parser, body + i, len - i < step ? len - i : step);
+    }
+    esp_err_t err = led_batch_parser_finish(&parser);
+    *bad_op = parser.bad_op;
+    return err;
+}
+
+static esp_err_t parse_text(const char *body, led_batch_t *batch, size_t *bad_op) {
+    return parse_steps(false, body, strlen(body), strlen(body) + 1, batch, bad_op);
+}
+
+// Every chunk size gives the same batch, or the same error at the same operation
+static void check_splits(bool binary, const char *body, size_t len) {
+    led_batch_t expected, batch;
+    size_t expected_bad, bad;
+    esp_err_t err = parse_steps(binary, body, len, len + 1, &expected, &expected_bad);
+
+    for (size_t step = 1; step <= len; step++) {
+        CHECK(parse_steps(binary, body, len, step, &batch, &bad) == err);
+        if (err == ESP_OK) {
+            CHECK(batch.count == expected.count);
+            CHECK(memcmp(batch.ops, expected.ops, batch.count * sizeof(led_op_t)) == 0);
+        } else {
+            CHECK(bad == expected_bad);
+        }
+    }
+}
+
+static bool op_is(const led_op_t *op, led_op_type_t type, uint8_t channel, uint16_t value, uint16_t time_ms) {
+    return op->type == type && op->channel == channel && op->value == value && op->time_ms == time_ms;
+}
+
+static void test_parse_text(void) {
+    static const char *bodies[] = {
+        "ops=set%3A0%3A1;duty:1:128,fade:2:255:500; delay:1000;set:0:0\r\n",
+        "set:0:1;;set+:0:0;%20delay:5",
+        "set:0:1;bogus:1",
+        "set:0:1;fade:1:2:3:4",
+        "set:0:1%3",
+    };
+    led_batch_t batch;
+    size_t bad;
+
+    for (size_t i = 0; i < sizeof(bodies) / sizeof(bodies[0]); i++) {
+        check_splits(false, bodies[i], strlen(bodies[i]));
+    }
+
+    CHECK(parse_text(bodies[0], &batch, &bad) == ESP_OK);
+    CHECK(batch.count == 5);
+    CHECK(op_is(&batch.ops[0], LED_OP_SET, 0, 1, 0));
+    CHECK(op_is(&batch.ops[1], LED_OP_DUTY, 1, 128, 0));
+    CHECK(op_is(&batch.ops[2], LED_OP_FADE, 2, 255, 500));
+    CHECK(op_is(&batch.ops[3], LED_OP_DELAY, 0, 0, 1000));
+    CHECK(op_is(&batch.ops[4], LED_OP_SET, 0, 0, 0));
+
+    // bad_op is the index of the first rejected operation
+    CHECK(parse_text("set:0:1;bogus:1", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 1);
+    CHECK(parse_text("set:0:2", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 0);
+    CHECK(parse_text("set:0:1;set:9:1", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 1);
+    CHECK(parse_text("duty:0:5", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 0); // Channel 0 has no PWM
+    CHECK(parse_text("fade:1:255:0", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 0);
+    CHECK(parse_text("delay:70000", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 0);
+    CHECK(parse_text("set:0:1;set:0", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 1);
+    CHECK(parse_text("set:0:1;set0:1", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 1);
+    CHECK(parse_text("set:0:1;set::1", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 1);
+    CHECK(parse_text("duty:1:128:5", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 0);
+    // No operation takes four fields
+    CHECK(parse_text("set:0:1;fade:1:2:3:4", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 1);
+    CHECK(parse_text("delay:1:2", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 0);
+    // Escapes: bad digits and an escape cut off by the end of the body
+    CHECK(parse_text("set:0:1;set%3g0:1", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 1);
+    CHECK(parse_text("set:0:1%3", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 0);
+    CHECK(parse_text("set:0:00000000000000000000000000001", &batch, &bad) == ESP_ERR_INVALID_ARG && bad == 0);
+    CHECK(parse_text("", &batch, &bad) == ESP_ERR_INVALID_SIZE);
+    CHECK(parse_text(" ;,\r\n", &batch, &bad) == ESP_ERR_INVALID_SIZE);
+    CHECK(parse_text("ops=", &batch, &bad) == ESP_ERR_INVALID_ARG);
+
+    // LED_BATCH_MAX operations fit, one more is rejected at its index
+    char body[(LED_BATCH_MAX + 1) * 8 + 1] = "";
+    for (int i = 0; i < LED_BATCH_MAX; i++) {
+        strcat(body, "set:0:1;");
+    }
+    CHECK(parse_text(body, &batch, &bad) == ESP_OK && batch.count == LED_BATCH_MAX);
+    strcat(body, "set:0:0");
+    CHECK(parse_text(body, &batch, &bad) == ESP_ERR_INVALID_ARG && bad == LED_BATCH_MAX);
+}
+
+static void test_parse_binary(void) {
+    static const uint8_t ops[] = {
+        LED_OP_SET, 0, 1, 0, 0, 0,
+        LED_OP_FADE, 2, 200, 0, 0xf4, 0x01,
+        LED_OP_DELAY, 0, 0, 0, 0xe8, 0x03,
+    };
+    static const uint8_t bad_channel[] = {LED_OP_SET, 0, 1, 0, 0, 0, LED_OP_DUTY, 7, 1, 0, 0, 0};
+    static const uint8_t bad_type[] = {LED_OP_COUNT, 0, 0, 0, 0, 0};
+    uint8_t many[(LED_BATCH_MAX + 1) * LED_OP_WIRE_SIZE] = {0};
+    led_batch_t batch;
+    size_t bad;
+
+    check_splits(true, (const char *)ops, sizeof(ops));
+    CHECK(parse_steps(true, (const char *)ops, sizeof(ops), 4, &batch, &bad) == ESP_OK);
+    CHECK(batch.count == 3);
+    CHECK(op_is(&batch.ops[1], LED_OP_FADE, 2, 200, 500));
+    CHECK(op_is(&batch.ops[2], LED_OP_DELAY, 0, 0, 1000));
+
+    // A cut-off record
+    CHECK(parse_steps(true, (const char *)ops, sizeof(ops) - 1, 5, &batch, &bad) == ESP_ERR_INVALID_SIZE && bad == 2);
+    CHECK(parse_steps(true, (const char *)ops, 0, 1, &batch, &bad) == ESP_ERR_INVALID_SIZE);
+    check_splits(true, (const char *)bad_channel, sizeof(bad_channel));
+    CHECK(parse_steps(true, (const char *)bad_channel, sizeof(bad_channel), 3, &batch, &bad) == ESP_ERR_INVALID_ARG &&
+          bad == 1);
+    CHECK(parse_steps(true, (const char *)bad_type, sizeof(bad_type), 6, &batch, &bad) == ESP_ERR_INVALID_ARG &&
+          bad == 0);
+
+    // LED_BATCH_MAX records of "set:0:0" fit, the first byte of one more does not
+    CHECK(parse_steps(true, (const char *)many, sizeof(many) - LED_OP_WIRE_SIZE, 64, &batch, &bad) == ESP_OK);
+    CHECK(batch.count == LED_BATCH_MAX);
+    CHECK(parse_steps(true, (const char *)many, sizeof(many), 64, &batch, &bad) == ESP_ERR_INVALID_SIZE &&
+          bad == LED_BATCH_MAX);
+}
+
+static esp_err_t submit(const char *text) {
+    led_batch_t batch;
+    size_t bad;
+
+    CHECK(parse_text(text, &batch, &bad) == ESP_OK);
+    return led_batch_submit(&batch);
+}
+
+// Queue each batch of the burst, let the actuator take them all, and check the
+// outputs written, in order, and the number of operations coalesced away
+static void check_burst(const char **batches, size_t count, const char *expected, uint32_t coalesced) {
+    uint32_t coalesced_before = atomic_load(&ops_coalesced.value);
+    uint32_t latency_before = atomic_load(&command_latency.count);
+
+    for (size_t i = 0; i < count; i++) {
+        CHECK(submit(batches[i]) == ESP_OK);
+    }
+    CHECK(command_queue_depth() == count);
+    writes[0] = '\0';
+    led_apply_commands();
+    if (strcmp(writes, expected) != 0) {
+        fprintf(stderr, "wrote   %s\nexpected %s\n", writes, expected);
+    }
+    CHECK(strcmp(writes, expected) == 0);
+    CHECK(command_queue_depth() == 0);
+    CHECK(atomic_load(&ops_coalesced.value) - coalesced_before == coalesced);
+    CHECK(atomic_load(&command_latency.count) - latency_before == count);
+}
+
+// Channel 0 is GPIO 2, channels 1 and 2 are PWM on LEDC channels 0 and 1;
+// duty 128 and 10 of 255 are 4111 and 321 of 8191
+static void test_bursts(void) {
+    static const char *on_off_on[] = {"set:0:1", "set:0:0", "set:0:1"};
+    static const char *one_batch[] = {"set:0:1;set:0:0;set:0:1"};
+    static const char *duty_fade[] = {"duty:1:0;fade:1:255:500"};
+    static const char *duty_then_fade[] = {"duty:1:0", "fade:1:255:500"};
+    static const char *mixed[] = {"set:0:1;duty:1:128", "fade:1:255:500;set:0:0", "duty:2:10;set:0:1"};
+    static const char *superseded[] = {"fade:1:255:500;set:0:1", "duty:1:10;set:0:0"};
+    static const char *set_then_duty[] = {"set:1:1;set:0:1", "duty:1:10"};
+
+    check_burst(on_off_on, 3, "pin 2 -> 1;", 2);
+    check_burst(one_batch, 1, "pin 2 -> 1;pin 2 -> 0;pin 2 -> 1;", 0);
+    check_burst(duty_fade, 1, "channel 0 duty -> 0;channel 0 fade -> 8191 over 500 ms;", 0);
+    check_burst(duty_then_fade, 2, "channel 0 duty -> 0;channel 0 fade -> 8191 over 500 ms;", 0);
+    // Each set on GPIO 2 is overridden by the next batch's; the duty before the fade stays
+    check_burst(mixed, 3,
+                "channel 0 duty -> 4111;channel 0 fade -> 8191 over 500 ms;channel 1 duty -> 321;pin 2 -> 1;", 2);
+    // Every channel of the first batch is written again by the second
+    check_burst(superseded, 2, "channel 0 duty -> 321;pin 2 -> 0;", 2);
+    // A set and a duty write are different kinds, both reach the output
+    check_burst(set_then_duty, 2, "channel 0 duty -> 8191;pin 2 -> 1;channel 0 duty -> 321;", 0);
+}
+
+// The dropped[] masks led_burst_coalesce leaves for each batch
+static void test_dropped_masks(void) {
+    static const char *burst[] = {
+        "set:0:1;duty:1:5;set:0:0;duty:2:3", // The later set and the duty on channel 1 are overridden
+        "fade:2:100:50;duty:1:7",            // duty:1:7 is, the fade after duty:2:3 is not a write
+        "duty:1:9;set:0:1",                  // Last batch: nothing after it
+    };
+    uint32_t dropped[LED_COMMAND_QUEUE_LEN];
+    led_batch_t batch;
+    size_t bad;
+    uint32_t before = atomic_load(&ops_coalesced.value);
+
+    for (size_t b = 0; b < 3; b++) {
+        CHECK(parse_text(burst[b], &led_burst[b], &bad) == ESP_OK);
+    }
+    led_burst_coalesce(3, dropped);
+    CHECK(dropped[0] == (1u << 1 | 1u << 2));
+    CHECK(dropped[1] == 1u << 1);
+    CHECK(dropped[2] == 0);
+    CHECK(atomic_load(&ops_coalesced.value) - before == 3);
+
+    // Once channel 2 is written later too, every channel of batch 0 is and it goes as a whole
+    CHECK(parse_text("duty:2:1", &batch, &bad) == ESP_OK);
+    led_burst[1] = batch;
+    before = atomic_load(&ops_coalesced.value);
+    led_burst_coalesce(3, dropped);
+    CHECK(dropped[0] == 0xf && dropped[1] == 0 && dropped[2] == 0);
+    CHECK(atomic_load(&ops_coalesced.value) - before == 4);
+}
+
+// Sequences: only the last batch of a burst keeps its delayed operations
+static void test_sequence(void) {
+    static const char *burst[] = {"set:0:1;delay:100;set:0:0", "duty:1:5;delay:250;duty:1:0"};
+
+    check_burst(burst, 2, "pin 2 -> 1;channel 0 duty -> 160;", 0);
+    CHECK(timer_armed_us == 250000);
+    CHECK(led_sequence_due_us == now_us + 250000);
+    now_us += 250000;
+    writes[0] = '\0';
+    led_sequence_run();
+    CHECK(strcmp(writes, "channel 0 duty -> 0;") == 0);
+    CHECK(led_sequence_due_us == 0);
+
+    // A new burst stops a pending delay
+    CHECK(submit("set:0:1;delay:1000;set:0:0") == ESP_OK);
+    led_apply_commands();
+    CHECK(timer_armed_us == 1000000);
+    CHECK(submit("set:0:0") == ESP_OK);
+    led_apply_commands();
+    CHECK(timer_armed_us == 0 && led_sequence_due_us == 0);
+}
+
+// A full queue refuses batches until the actuator task takes them, and the
+// task comes back for more when it took a whole queue's worth
+static void test_full_queue(void) {
+    uint32_t rejected = atomic_load(&commands_rejected.value);
+    uint32_t latency_count = atomic_load(&command_latency.count);
+    uint32_t latency_sum = atomic_load(&command_latency.sum_us);
+
+    for (int i = 0; i < LED_COMMAND_QUEUE_LEN; i++) {
+        CHECK(submit(i % 2 ? "set:0:0" : "set:0:1") == ESP_OK);
+        now_us += 100;
+    }
+    CHECK(command_queue_depth() == LED_COMMAND_QUEUE_LEN);
+    CHECK(submit("set:0:1") == ESP_ERR_NO_MEM);
+    CHECK(atomic_load(&commands_rejected.value) - rejected == 1);
+    CHECK(command_queue_depth() == LED_COMMAND_QUEUE_LEN);
+
+    unsigned notifies_before = notifies;
+    writes[0] = '\0';
+    led_apply_commands();
+    CHECK(notifies - notifies_before == 1);
+    CHECK(strcmp(writes, "pin 2 -> 0;") == 0);
+    CHECK(command_queue_depth() == 0);
+    // Queued 800, 700, ... 100 us before being applied
+    CHECK(atomic_load(&command_latency.count) - latency_count == LED_COMMAND_QUEUE_LEN);
+    CHECK(atomic_load(&command_latency.sum_us) - latency_sum == 3600);
+
+    // The ring wraps and takes batches again
+    CHECK(submit("set:0:1") == ESP_OK);
+    notifies_before = notifies;
+    led_apply_commands();
+    CHECK(notifies == notifies_before);
+    CHECK(command_queue_depth() == 0);
+}
+
+int main(void) {
+    led_control_init();
+    test_parse_text();
+    test_parse_binary();
+    test_bursts();
+    test_dropped_masks();
+    test_sequence();
+    test_full_queue();
+    printf("led_control: all tests passed\n");
+    return 0;
+}
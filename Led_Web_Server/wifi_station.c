@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "wifi_station.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_event.h"
+#include "esp_random.h"
+#include "esp_wifi.h"
+#include "nvs.h"
+#include "my_data.h"
+#endif
+
+#define WIFI_READY_BIT (1 << 0)   // Station has an IP address
+#define RECONNECT_BASE_MS 250     // First retry window, doubled per failed attempt
+#define RECONNECT_MAX_MS 30000
+#define AP_CACHE_NAMESPACE "wifi"
+#define AP_CACHE_KEY "ap"
+
+static const char *TAG = "wifi_station";
+
+static EventGroupHandle_t wifi_events;
+static char ip_address[16];
+static atomic_bool first_request_pending;
+
+// Timing for the stats, guarded by stats_lock
+static SemaphoreHandle_t stats_lock;
+static wifi_station_stats_t stats = {-1, -1, -1, 0, false};
+static int64_t link_lost_us = -1; // -1 while the boot connection is still pending
+
+static void stats_lock_take(void) {
+    xSemaphoreTake(stats_lock, portMAX_DELAY);
+}
+
+static void stats_lock_give(void) {
+    xSemaphoreGive(stats_lock);
+}
+
+static void mark_ready(void) {
+    int64_t now_ms = esp_timer_get_time() / 1000;
+    stats_lock_take();
+    if (stats.boot_to_ip_ms < 0) {
+        stats.boot_to_ip_ms = now_ms;
+    } else {
+        stats.reconnects++;
+    }
+    stats_lock_give();
+    atomic_store(&first_request_pending, true);
+    xEventGroupSetBits(wifi_events, WIFI_READY_BIT);
+    ESP_LOGI(TAG, "IP Address: %s after %lld ms", ip_address, (long long)now_ms);
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+// Host simulation: the loopback interface stands in for the station link
+void wifi_station_start(void) {
+    nvs_flash_init();
+    wifi_events = xEventGroupCreate();
+    stats_lock = xSemaphoreCreateMutex();
+    snprintf(ip_address, sizeof(ip_address), "127.0.0.1");
+    mark_ready();
+}
+#else
+// Last AP joined, so a reboot can connect without scanning every channel
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+} ap_cache_t;
+
+static esp_timer_handle_t reconnect_timer;
+static uint32_t reconnect_attempt;
+static ap_cache_t ap_cache;
+static bool ap_cache_valid;
+static bool using_cached_ap;
+
+static bool ap_cache_load(ap_cache_t *cache) {
+    nvs_handle_t handle;
+    size_t size = sizeof(*cache);
+    if (nvs_open(AP_CACHE_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    esp_err_t err = nvs_get_blob(handle, AP_CACHE_KEY, cache, &size);
+    nvs_close(handle);
+    return err == ESP_OK && size == sizeof(*cache);
+}
+
+static void ap_cache_store(const uint8_t *bssid, uint8_t channel) {
+    nvs_handle_t handle;
+    if (ap_cache_valid && ap_cache.channel == channel && memcmp(ap_cache.bssid, bssid, 6) == 0) {
+        return; // Unchanged, spare the flash
+    }
+    memcpy(ap_cache.bssid, bssid, 6);
+    ap_cache.channel = channel;
+    ap_cache_valid = true;
+    if (nvs_open(AP_CACHE_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        nvs_set_blob(handle, AP_CACHE_KEY, &ap_cache, sizeof(ap_cache));
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+}
+
+static void apply_config(bool use_cache) {
+    wifi_config_t wifi_configuration = {
+        .sta = {
+            .ssid = SSID,
+            .password = PASS,
+            .scan_method = WIFI_FAST_SCAN,
+        }
+    };
+    if (use_cache) {
+        memcpy(wifi_configuration.sta.bssid, ap_cache.bssid, 6);
+        wifi_configuration.sta.bssid_set = true;
+        wifi_configuration.sta.channel = ap_cache.channel;
+    }
+    using_cached_ap = use_cache;
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_configuration);
+}
+
+static void reconnect_cb(void *arg) {
+    esp_wifi_connect();
+}
+
+// Full jitter: a random delay up to a window that doubles per attempt, so
+// nodes that lost the same AP do not all retry in lockstep
+static void schedule_reconnect(void) {
+    uint32_t window_ms = RECONNECT_MAX_MS;
+    if (reconnect_attempt < 16 && (RECONNECT_BASE_MS << reconnect_attempt) < RECONNECT_MAX_MS) {
+        window_ms = RECONNECT_BASE_MS << reconnect_attempt;
+    }
+    uint32_t delay_ms = window_ms / 2 + esp_random() % (window_ms / 2 + 1);
+    reconnect_attempt++;
+    ESP_LOGI(TAG, "Reconnect attempt %lu in %lu ms", (unsigned long)reconnect_attempt, (unsigned long)delay_ms);
+    esp_timer_start_once(reconnect_timer, (uint64_t)delay_ms * 1000);
+}
+
+static void wifi_event_handler(void *event_handler_arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        printf("WiFi connecting ... \n");
+        esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *)event_data;
+        printf("WiFi connected ... \n");
+        ap_cache_store(event->bssid, event->channel);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        printf("WiFi lost connection ... \n");
+        if (xEventGroupGetBits(wifi_events) & WIFI_READY_BIT) {
+            stats_lock_take();
+            link_lost_us = esp_timer_get_time();
+            stats_lock_give();
+        }
+        xEventGroupClearBits(wifi_events, WIFI_READY_BIT);
+        ip_address[0] = '\0';
+        if (using_cached_ap) {
+            // The AP may have moved, fall back to a normal scan right away
+            apply_config(false);
+            esp_wifi_connect();
+            return;
+        }
+        schedule_reconnect();
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
+        snprintf(ip_address, sizeof(ip_address), IPSTR, IP2STR(&event->ip_info.ip));
+        reconnect_attempt = 0;
+        mark_ready();
+    }
+}
+
+void wifi_station_start(void) {
+    nvs_flash_init();
+    wifi_events = xEventGroupCreate();
+    stats_lock = xSemaphoreCreateMutex();
+    const esp_timer_create_args_t timer_args = {
+        .callback = reconnect_cb,
+        .name = "wifi_reconnect",
+    };
+    esp_timer_create(&timer_args, &reconnect_timer);
+
+    esp_netif_init();
+    esp_event_loop_create_default();
+    esp_netif_create_default_wifi_sta();
+    wifi_init_config_t wifi_initiation = WIFI_INIT_CONFIG_DEFAULT();
+    esp_wifi_init(&wifi_initiation);
+    esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event_handler, NULL);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL);
+
+    ap_cache_valid = ap_cache_load(&ap_cache);
+    stats.cached_ap = ap_cache_valid;
+    apply_config(ap_cache_valid);
+    esp_wifi_start();
+}
+#endif
+
+bool wifi_station_wait_ready(TickType_t timeout) {
+    return xEventGroupWaitBits(wifi_events, WIFI_READY_BIT, pdFALSE, pdTRUE, timeout) & WIFI_READY_BIT;
+}
+
+const char *wifi_station_ip(void) {
+    return ip_address;
+}
+
+void wifi_station_note_request(void) {
+    if (!atomic_load_explicit(&first_request_pending, memory_order_relaxed) ||
+        !atomic_exchange(&first_request_pending, false)) {
+        return;
+    }
+    int64_t now_us = esp_timer_get_time();
+    stats_lock_take();
+    if (stats.boot_to_first_request_ms < 0) {
+        stats.boot_to_first_request_ms = now_us / 1000;
+        ESP_LOGI(TAG, "First request served %lld ms after boot", (long long)stats.boot_to_first_request_ms);
+    } else if (link_lost_us >= 0) {
+        stats.reconnect_ms = (now_us - link_lost_us) / 1000;
+        ESP_LOGI(TAG, "First request served %lld ms after link loss", (long long)stats.reconnect_ms);
+    }
+    stats_lock_give();
+}
+
+void wifi_station_get_stats(wifi_station_stats_t *out) {
+    stats_lock_take();
+    *out = stats;
+    stats_lock_give();
+}
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "asset_bundle.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include "esp_partition.h"
+#endif
+
+_Static_assert(sizeof(asset_bundle_header_t) == 20, "bundle header layout");
+_Static_assert(sizeof(asset_entry_t) == 28, "bundle index layout");
+
+static const char *TAG = "asset_bundle";
+
+uint32_t asset_hash(const char *path, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)path[i]) * 16777619u;
+    }
+    return h;
+}
+
+// zlib's CRC-32, a nibble at a time from a 64-byte table
+static uint32_t crc32(const uint8_t *data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+    uint32_t crc = 0xffffffff;
+
+    while (len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+    }
+    return ~crc;
+}
+
+static bool range_ok(uint32_t offset, uint32_t length, uint32_t total) {
+    return (uint64_t)offset + length <= total;
+}
+
+esp_err_t asset_bundle_open(asset_bundle_t *bundle, const void *image, size_t size) {
+    const uint8_t *base = image;
+    asset_bundle_header_t header;
+
+    if (size < sizeof(header)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != ASSET_MAGIC || header.version != ASSET_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    uint64_t strings_start = sizeof(header) + (uint64_t)header.count * sizeof(asset_entry_t);
+    if (header.total_size > size || strings_start + header.strings_size > header.total_size ||
+        header.strings_size == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (crc32(base + sizeof(header), header.total_size - sizeof(header)) != header.crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    const asset_entry_t *index = (const asset_entry_t *)(base + sizeof(header));
+    const char *strings = (const char *)base + strings_start;
+    if (strings[header.strings_size - 1] != '\0') {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (uint16_t i = 0; i < header.count; i++) {
+        const asset_entry_t *entry = &index[i];
+        if ((i > 0 && entry->hash <= index[i - 1].hash) || entry->path >= header.strings_size ||
+            entry->mime >= header.strings_size || entry->etag >= header.strings_size ||
+            entry->gz_etag >= header.strings_size ||
+            !range_ok(entry->offset, entry->length, header.total_size) ||
+            !range_ok(entry->gz_offset, entry->gz_length, header.total_size)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    bundle->base = base;
+    bundle->index = index;
+    bundle->strings = strings;
+    bundle->count = header.count;
+    bundle->strings_size = header.strings_size;
+    return ESP_OK;
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+// Host stand-in: the image file mapped read-only, as the partition would be
+static esp_err_t map_image(const void **image, size_t *size) {
+    struct stat st;
+    int fd = open(ASSET_HOST_PATH, O_RDONLY);
+
+    if (fd < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return ESP_FAIL;
+    }
+    *image = mapped;
+    *size = st.st_size;
+    return ESP_OK;
+}
+#else
+// Map only as much of the partition as the bundle uses, MMU pages are scarce
+static esp_err_t map_image(const void **image, size_t *size) {
+    const esp_partition_t *partition;
+    esp_partition_mmap_handle_t handle;
+    asset_bundle_header_t header;
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, ASSET_PARTITION_LABEL);
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = esp_partition_read(partition, 0, &header, sizeof(header));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (header.magic != ASSET_MAGIC) {
+        // Erased or never flashed
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header.total_size < sizeof(header) || header.total_size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    err = esp_partition_mmap(partition, 0, header.total_size, ESP_PARTITION_MMAP_DATA, image, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    *size = header.total_size;
+    return ESP_OK;
+}
+#endif
+
+esp_err_t asset_bundle_mount(asset_bundle_t *bundle) {
+    const void *image;
+    size_t size;
+
+    esp_err_t err = map_image(&image, &size);
+    if (err == ESP_OK) {
+        err = asset_bundle_open(bundle, image, size);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No asset bundle in '%s': %s", ASSET_PARTITION_LABEL, esp_err_to_name(err));
+        memset(bundle, 0, sizeof(*bundle));
+        return err;
+    }
+    ESP_LOGI(TAG, "%u assets mapped", bundle->count);
+    return ESP_OK;
+}
+
+bool asset_bundle_find(const asset_bundle_t *bundle, const char *path, size_t len, asset_t *asset) {
+    uint32_t hash = asset_hash(path, len);
+    size_t lo = 0;
+    size_t hi = bundle->count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (bundle->index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == bundle->count || bundle->index[lo].hash != hash) {
+        return false;
+    }
+
+    const asset_entry_t *entry = &bundle->index[lo];
+    const char *name = bundle->strings + entry->path;
+    if (strncmp(name, path, len) != 0 || name[len] != '\0') {
+        return false;
+    }
+    asset->path = name;
+    asset->mime = bundle->strings + entry->mime;
+    asset->etag = bundle->strings + entry->etag;
+    asset->gz_etag = bundle->strings + entry->gz_etag;
+    asset->data = bundle->base + entry->offset;
+    asset->length = entry->length;
+    asset->gz_data = bundle->base + entry->gz_offset;
+    asset->gz_length = entry->gz_length;
+    return true;
+}
+
+// The body goes from the mapping to the socket; httpd and lwIP split it into segments
+esp_err_t asset_send(httpd_req_t *req, const asset_t *asset) {
+    char header[64];
+    bool gzip = asset->gz_length > 0 &&
+                httpd_req_get_hdr_value_str(req, "Accept-Encoding", header, sizeof(header)) == ESP_OK &&
+                strstr(header, "gzip") != NULL;
+    const char *etag = gzip ? asset->gz_etag : asset->etag;
+
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (asset->gz_length > 0) {
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    }
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", header, sizeof(header)) == ESP_OK &&
+        strstr(header, etag) != NULL) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, asset->mime);
+    if (gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        return httpd_resp_send(req, (const char *)asset->gz_data, asset->gz_length);
+    }
+    return httpd_resp_send(req, (const char *)asset->data, asset->length);
+}
@@ -0,0 +1,477 @@
+#include <string.h>
+#include <sys/param.h>
+#include "body_parser.h"
+
+#define BODY_RECV_CHUNK 64   // Bytes taken off the socket at a time
+#define BODY_RECV_TIMEOUTS 3 // Receive timeouts in a row before a stalled client is dropped
+
+enum {
+    FORM_KEY,
+    FORM_VALUE,
+    JSON_START,     // Before '{'
+    JSON_FIRST_KEY, // After '{', a key or '}'
+    JSON_NEXT_KEY,  // After ',', a key
+    JSON_KEY,
+    JSON_COLON,
+    JSON_VALUE,
+    JSON_STRING,
+    JSON_BARE,        // Number, true, false or null
+    JSON_SKIP,        // Inside a nested object or array
+    JSON_SKIP_STRING, // Inside a string of a nested value
+    JSON_AFTER_VALUE, // ',' or '}'
+    JSON_DONE,
+};
+
+static void fail(body_parser_t *parser, esp_err_t err) {
+    if (parser->err == ESP_OK) {
+        parser->err = err;
+    }
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void key_begin(body_parser_t *parser) {
+    parser->candidates = parser->field_count == BODY_FIELDS_MAX ? UINT32_MAX : (1u << parser->field_count) - 1;
+    parser->key_len = 0;
+}
+
+// Drop every field whose key differs at this position, no key is buffered
+static void key_char(body_parser_t *parser, char c) {
+    if (c == '\0' || parser->key_len == UINT8_MAX) {
+        parser->candidates = 0;
+        return;
+    }
+    for (uint32_t bits = parser->candidates; bits != 0; bits &= bits - 1) {
+        int i = __builtin_ctz(bits);
+        if (parser->fields[i].key[parser->key_len] != c) {
+            parser->candidates &= ~(1u << i);
+        }
+    }
+    parser->key_len++;
+}
+
+static void key_end(body_parser_t *parser) {
+    parser->field = NULL;
+    for (uint32_t bits = parser->candidates; bits != 0; bits &= bits - 1) {
+        int i = __builtin_ctz(bits);
+        if (parser->fields[i].key[parser->key_len] == '\0') {
+            parser->field = &parser->fields[i];
+            return;
+        }
+    }
+}
+
+static void value_begin(body_parser_t *parser) {
+    parser->negative = false;
+    parser->has_digits = false;
+    parser->number = 0;
+    parser->text_len = 0;
+}
+
+static void flush_text(body_parser_t *parser, bool last) {
+    esp_err_t err = parser->field->on_text(parser->text, parser->text_len, last, parser->ctx);
+    if (err != ESP_OK) {
+        fail(parser, err);
+    }
+    parser->text_len = 0;
+}
+
+static void value_char(body_parser_t *parser, char c) {
+    if (parser->field == NULL) {
+        return;
+    }
+    switch (parser->field->type) {
+    case BODY_FIELD_TEXT:
+        parser->text[parser->text_len++] = c;
+        if (parser->text_len == sizeof(parser->text)) {
+            flush_text(parser, false);
+        }
+        break;
+    case BODY_FIELD_INT:
+        // Accumulated negated, so INT32_MIN fits as well
+        if (c == '-' && !parser->negative && !parser->has_digits) {
+            parser->negative = true;
+        } else if (c >= '0' && c <= '9' && parser->number >= (INT32_MIN + (c - '0')) / 10) {
+            parser->number = parser->number * 10 - (c - '0');
+            parser->has_digits = true;
+        } else {
+            fail(parser, ESP_ERR_INVALID_ARG);
+        }
+        break;
+    case BODY_FIELD_BOOL:
+        // Longest accepted word is "false"
+        if (parser->text_len == 5) {
+            fail(parser, ESP_ERR_INVALID_ARG);
+        } else {
+            parser->text[parser->text_len++] = c;
+        }
+        break;
+    }
+}
+
+static bool text_is(const body_parser_t *parser, const char *word) {
+    return parser->text_len == strlen(word) && memcmp(parser->text, word, parser->text_len) == 0;
+}
+
+static void value_end(body_parser_t *parser) {
+    esp_err_t err = ESP_OK;
+
+    if (parser->field == NULL) {
+        return;
+    }
+    switch (parser->field->type) {
+    case BODY_FIELD_TEXT:
+        flush_text(parser, true);
+        return;
+    case BODY_FIELD_INT:
+        if (!parser->has_digits || (!parser->negative && parser->number == INT32_MIN)) {
+            err = ESP_ERR_INVALID_ARG;
+        } else {
+            err = parser->field->on_int(parser->negative ? parser->number : -parser->number, parser->ctx);
+        }
+        break;
+    case BODY_FIELD_BOOL:
+        if (text_is(parser, "true") || text_is(parser, "on") || text_is(parser, "1")) {
+            err = parser->field->on_bool(true, parser->ctx);
+        } else if (text_is(parser, "false") || text_is(parser, "off") || text_is(parser, "0")) {
+            err = parser->field->on_bool(false, parser->ctx);
+        } else {
+            err = ESP_ERR_INVALID_ARG;
+        }
+        break;
+    }
+    if (err != ESP_OK) {
+        fail(parser, err);
+    }
+}
+
+// A decoded character goes to the key or the value being read
+static void put_char(body_parser_t *parser, char c) {
+    if (parser->state == FORM_KEY || parser->state == JSON_KEY) {
+        key_char(parser, c);
+    } else {
+        value_char(parser, c);
+    }
+}
+
+static void form_pair_end(body_parser_t *parser) {
+    if (parser->state == FORM_VALUE) {
+        value_end(parser);
+    } else if (parser->key_len > 0) {
+        // Bare key, as a checkbox posts it
+        key_end(parser);
+        if (parser->field != NULL && parser->field->type == BODY_FIELD_BOOL) {
+            esp_err_t err = parser->field->on_bool(true, parser->ctx);
+            if (err != ESP_OK) {
+                fail(parser, err);
+            }
+        } else if (parser->field != NULL) {
+            fail(parser, ESP_ERR_INVALID_ARG);
+        }
+    }
+    parser->state = FORM_KEY;
+    key_begin(parser);
+}
+
+static void form_step(body_parser_t *parser, char c) {
+    if (parser->escape > 0) {
+        int digit = hex_digit(c);
+        if (digit < 0) {
+            fail(parser, ESP_ERR_INVALID_ARG);
+            return;
+        }
+        parser->code = parser->code << 4 | digit;
+        if (++parser->escape == 3) {
+            parser->escape = 0;
+            put_char(parser, parser->code);
+        }
+        return;
+    }
+    switch (c) {
+    case '%':
+        parser->escape = 1;
+        parser->code = 0;
+        return;
+    case '+':
+        put_char(parser, ' ');
+        return;
+    case '&':
+        form_pair_end(parser);
+        return;
+    case '=':
+        if (parser->state == FORM_KEY) {
+            key_end(parser);
+            value_begin(parser);
+            parser->state = FORM_VALUE;
+            return;
+        }
+        break;
+    }
+    put_char(parser, c);
+}
+
+// UTF-8 for a \uXXXX escape. Surrogates, halves of a character outside the
+// basic plane, come through as '?'.
+static void put_code_point(body_parser_t *parser, uint16_t code) {
+    if (code < 0x80) {
+        put_char(parser, code);
+    } else if (code < 0x800) {
+        put_char(parser, 0xc0 | code >> 6);
+        put_char(parser, 0x80 | (code & 0x3f));
+    } else if (code >= 0xd800 && code <= 0xdfff) {
+        put_char(parser, '?');
+    } else {
+        put_char(parser, 0xe0 | code >> 12);
+        put_char(parser, 0x80 | (code >> 6 & 0x3f));
+        put_char(parser, 0x80 | (code & 0x3f));
+    }
+}
+
+// One character inside a key or string value, true at the closing quote
+static bool json_string_char(body_parser_t *parser, char c) {
+    static const char escapes[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+
+    if (parser->escape == 1) {
+        parser->escape = 0;
+        if (c == 'u') {
+            parser->escape = 2;
+            parser->code = 0;
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(escapes) - 1; i += 2) {
+            if (escapes[i] == c) {
+                put_char(parser, escapes[i + 1]);
+                return false;
+            }
+        }
+        fail(parser, ESP_ERR_INVALID_ARG);
+    } else if (parser->escape > 1) {
+        int digit = hex_digit(c);
+        if (digit < 0) {
+            fail(parser, ESP_ERR_INVALID_ARG);
+            return false;
+        }
+        parser->code = parser->code << 4 | digit;
+        if (++parser->escape == 6) {
+            parser->escape = 0;
+            put_code_point(parser, parser->code);
+        }
+    } else if (c == '"') {
+        return true;
+    } else if (c == '\\') {
+        parser->escape = 1;
+    } else if ((uint8_t)c < 0x20) {
+        fail(parser, ESP_ERR_INVALID_ARG);
+    } else {
+        put_char(parser, c);
+    }
+    return false;
+}
+
+static bool is_bare_char(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' ||
+           c == '.';
+}
+
+static void json_step(body_parser_t *parser, char c) {
+    switch (parser->state) {
+    case JSON_START:
+        if (c == '{') {
+            parser->state = JSON_FIRST_KEY;
+            return;
+        }
+        break;
+    case JSON_FIRST_KEY:
+    case JSON_NEXT_KEY:
+        if (c == '"') {
+            key_begin(parser);
+            parser->state = JSON_KEY;
+            return;
+        }
+        if (c == '}' && parser->state == JSON_FIRST_KEY) {
+            parser->state = JSON_DONE;
+            return;
+        }
+        break;
+    case JSON_KEY:
+        if (json_string_char(parser, c)) {
+            key_end(parser);
+            parser->state = JSON_COLON;
+        }
+        return;
+    case JSON_COLON:
+        if (c == ':') {
+            parser->state = JSON_VALUE;
+            return;
+        }
+        break;
+    case JSON_VALUE:
+        if (c == '"') {
+            value_begin(parser);
+            parser->state = JSON_STRING;
+            return;
+        }
+        if ((c == '{' || c == '[') && parser->field == NULL) {
+            parser->depth = 1;
+            parser->state = JSON_SKIP;
+            return;
+        }
+        if (is_bare_char(c)) {
+            value_begin(parser);
+            value_char(parser, c);
+            parser->state = JSON_BARE;
+            return;
+        }
+        break;
+    case JSON_STRING:
+        if (json_string_char(parser, c)) {
+            value_end(parser);
+            parser->state = JSON_AFTER_VALUE;
+        }
+        return;
+    case JSON_BARE:
+        if (is_bare_char(c)) {
+            value_char(parser, c);
+            return;
+        }
+        value_end(parser);
+        parser->state = JSON_AFTER_VALUE;
+        json_step(parser, c);
+        return;
+    case JSON_SKIP:
+        if (c == '"') {
+            parser->state = JSON_SKIP_STRING;
+        } else if (c == '{' || c == '[') {
+            if (parser->depth == UINT8_MAX) {
+                break;
+            }
+            parser->depth++;
+        } else if ((c == '}' || c == ']') && --parser->depth == 0) {
+            parser->state = JSON_AFTER_VALUE;
+        }
+        return;
+    case JSON_SKIP_STRING:
+        if (parser->escape) {
+            parser->escape = 0;
+        } else if (c == '\\') {
+            parser->escape = 1;
+        } else if (c == '"') {
+            parser->state = JSON_SKIP;
+        }
+        return;
+    case JSON_AFTER_VALUE:
+        if (c == ',') {
+            parser->state = JSON_NEXT_KEY;
+            return;
+        }
+        if (c == '}') {
+            parser->state = JSON_DONE;
+            return;
+        }
+        break;
+    }
+    if (!is_space(c)) {
+        fail(parser, ESP_ERR_INVALID_ARG);
+    }
+}
+
+void body_parser_init(body_parser_t *parser, body_format_t format, const body_field_t *fields, size_t field_count,
+                      void *ctx) {
+    memset(parser, 0, sizeof(*parser));
+    parser->fields = fields;
+    parser->field_count = MIN(field_count, BODY_FIELDS_MAX);
+    parser->ctx = ctx;
+    parser->format = format;
+    if (format == BODY_FORMAT_JSON) {
+        parser->state = JSON_START;
+    } else {
+        parser->state = FORM_KEY;
+        key_begin(parser);
+    }
+}
+
+esp_err_t body_parser_feed(body_parser_t *parser, const char *data, size_t len) {
+    for (size_t i = 0; i < len && parser->err == ESP_OK; i++) {
+        if (parser->format == BODY_FORMAT_JSON) {
+            json_step(parser, data[i]);
+        } else {
+            form_step(parser, data[i]);
+        }
+    }
+    return parser->err;
+}
+
+esp_err_t body_parser_finish(body_parser_t *parser) {
+    if (parser->err != ESP_OK) {
+        return parser->err;
+    }
+    if (parser->format == BODY_FORMAT_JSON) {
+        if (parser->state != JSON_DONE) {
+            fail(parser, ESP_ERR_INVALID_ARG);
+        }
+    } else if (parser->escape > 0) {
+        fail(parser, ESP_ERR_INVALID_ARG);
+    } else {
+        form_pair_end(parser);
+    }
+    return parser->err;
+}
+
+esp_err_t body_recv_chunks(httpd_req_t *req, esp_err_t (*chunk)(const char *data, size_t len, void *ctx), void *ctx) {
+    char buf[BODY_RECV_CHUNK];
+    size_t remaining = req->content_len;
+    int timeouts = 0;
+
+    while (remaining > 0) {
+        int ret = httpd_req_recv(req, buf, MIN(remaining, sizeof(buf)));
+        if (ret <= 0) {
+            // A client that stops sending would otherwise hold the httpd task forever
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < BODY_RECV_TIMEOUTS) {
+                continue;
+            }
+            return ESP_FAIL;
+        }
+        timeouts = 0;
+        remaining -= ret;
+        esp_err_t err = chunk(buf, ret, ctx);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t feed_chunk(const char *data, size_t len, void *ctx) {
+    return body_parser_feed(ctx, data, len);
+}
+
+esp_err_t body_parser_recv(httpd_req_t *req, const body_field_t *fields, size_t field_count, void *ctx) {
+    static const char json_type[] = "application/json";
+    char content_type[40] = "";
+    body_parser_t parser;
+
+    httpd_req_get_hdr_value_str(req, "Content-Type", content_type, sizeof(content_type));
+    body_parser_init(&parser, strncmp(content_type, json_type, sizeof(json_type) - 1) == 0 ? BODY_FORMAT_JSON
+                                                                                            : BODY_FORMAT_FORM,
+                     fields, field_count, ctx);
+    esp_err_t err = body_recv_chunks(req, feed_chunk, &parser);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return body_parser_finish(&parser);
+}
@@ -0,0 +1,89 @@
+#include <string.h>
+#include "cbor_writer.h"
+
+// Major types, in the top three bits of the initial byte
+#define CBOR_UINT 0
+#define CBOR_NEGINT 1
+#define CBOR_BYTES 2
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_INDEFINITE 31
+
+static bool reserve(cbor_writer_t *writer, size_t len) {
+    if (writer->overflow || writer->size - writer->len < len) {
+        writer->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+// Initial byte plus the shortest big-endian argument that holds `value`
+static void put_head(cbor_writer_t *writer, uint8_t major, uint64_t value) {
+    uint8_t head[9];
+    size_t len;
+
+    if (value < 24) {
+        head[0] = major << 5 | value;
+        len = 1;
+    } else {
+        size_t bytes = value <= UINT8_MAX ? 1 : value <= UINT16_MAX ? 2 : value <= UINT32_MAX ? 4 : 8;
+        head[0] = major << 5 | (bytes == 1 ? 24 : bytes == 2 ? 25 : bytes == 4 ? 26 : 27);
+        for (size_t i = 0; i < bytes; i++) {
+            head[bytes - i] = value >> (8 * i);
+        }
+        len = 1 + bytes;
+    }
+    if (reserve(writer, len)) {
+        memcpy(writer->buf + writer->len, head, len);
+        writer->len += len;
+    }
+}
+
+void cbor_put_uint(cbor_writer_t *writer, uint64_t value) {
+    put_head(writer, CBOR_UINT, value);
+}
+
+void cbor_put_int(cbor_writer_t *writer, int64_t value) {
+    if (value < 0) {
+        put_head(writer, CBOR_NEGINT, (uint64_t)(-(value + 1)));
+    } else {
+        put_head(writer, CBOR_UINT, value);
+    }
+}
+
+static void put_string(cbor_writer_t *writer, uint8_t major, const void *data, size_t len) {
+    put_head(writer, major, len);
+    if (reserve(writer, len)) {
+        memcpy(writer->buf + writer->len, data, len);
+        writer->len += len;
+    }
+}
+
+void cbor_put_text(cbor_writer_t *writer, const char *text, size_t len) {
+    put_string(writer, CBOR_TEXT, text, len);
+}
+
+void cbor_put_bytes(cbor_writer_t *writer, const uint8_t *data, size_t len) {
+    put_string(writer, CBOR_BYTES, data, len);
+}
+
+void cbor_put_array(cbor_writer_t *writer, size_t count) {
+    put_head(writer, CBOR_ARRAY, count);
+}
+
+void cbor_put_map(cbor_writer_t *writer, size_t count) {
+    put_head(writer, CBOR_MAP, count);
+}
+
+void cbor_put_array_start(cbor_writer_t *writer) {
+    if (reserve(writer, 1)) {
+        writer->buf[writer->len++] = CBOR_ARRAY << 5 | CBOR_INDEFINITE;
+    }
+}
+
+void cbor_put_break(cbor_writer_t *writer) {
+    if (reserve(writer, 1)) {
+        writer->buf[writer->len++] = CBOR_BREAK;
+    }
+}
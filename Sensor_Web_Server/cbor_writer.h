@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Minimal CBOR (RFC 8949) encoder writing straight into a caller buffer, no
+// allocation. Every call is a no-op once the buffer is full, so a sequence of
+// writes needs a single cbor_writer_ok() check at the end.
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+} cbor_writer_t;
+
+#define CBOR_BREAK 0xff
+
+static inline void cbor_writer_init(cbor_writer_t *writer, uint8_t *buf, size_t size) {
+    writer->buf = buf;
+    writer->size = size;
+    writer->len = 0;
+    writer->overflow = false;
+}
+
+static inline bool cbor_writer_ok(const cbor_writer_t *writer) {
+    return !writer->overflow;
+}
+
+void cbor_put_uint(cbor_writer_t *writer, uint64_t value);
+void cbor_put_int(cbor_writer_t *writer, int64_t value);
+void cbor_put_text(cbor_writer_t *writer, const char *text, size_t len);
+void cbor_put_bytes(cbor_writer_t *writer, const uint8_t *data, size_t len);
+void cbor_put_array(cbor_writer_t *writer, size_t count);
+void cbor_put_map(cbor_writer_t *writer, size_t count);
+
+// Indefinite-length array, closed by cbor_put_break(), for streamed lists
+void cbor_put_array_start(cbor_writer_t *writer);
+void cbor_put_break(cbor_writer_t *writer);
@@ -0,0 +1,73 @@
+#include <stdbool.h>
+#include "dht11_decode.h"
+
+// Timing from the DHT11 datasheet, with margin for edge jitter and capture resolution
+#define RESPONSE_MIN_US 60  // Response low and high are 80 us each
+#define RESPONSE_MAX_US 100
+#define BIT_LOW_MIN_US 30   // Every bit starts with 50 us low
+#define BIT_LOW_MAX_US 80
+#define BIT_HIGH_MAX_US 90  // Then 26-28 us high for a 0, 70 us for a 1
+#define BIT_ONE_MIN_US 48
+
+static bool in_range(const dht11_pulse_t *pulse, uint8_t level, uint16_t min_us, uint16_t max_us) {
+    return pulse->level == level && pulse->duration_us >= min_us && pulse->duration_us <= max_us;
+}
+
+esp_err_t dht11_decode(const dht11_pulse_t *pulses, size_t count, dht11_reading_t *reading) {
+    size_t i = 0;
+
+    // Skip the tail of the start signal up to the 80 us low / 80 us high response
+    while (i + 1 < count && !(in_range(&pulses[i], 0, RESPONSE_MIN_US, RESPONSE_MAX_US) &&
+                              in_range(&pulses[i + 1], 1, RESPONSE_MIN_US, RESPONSE_MAX_US))) {
+        i++;
+    }
+    if (i + 1 >= count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    i += 2;
+    if (count - i < 2 * 40) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t data[5] = {0};
+    for (int bit = 0; bit < 40; bit++, i += 2) {
+        if (!in_range(&pulses[i], 0, BIT_LOW_MIN_US, BIT_LOW_MAX_US) ||
+            !in_range(&pulses[i + 1], 1, 1, BIT_HIGH_MAX_US)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        data[bit / 8] = data[bit / 8] << 1 | (pulses[i + 1].duration_us >= BIT_ONE_MIN_US);
+    }
+    if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4]) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    reading->humidity = data[0] + data[1] * 0.1f;
+    reading->temperature = data[2] + (data[3] & 0x7F) * 0.1f;
+    if (data[3] & 0x80) {
+        reading->temperature = -reading->temperature;
+    }
+    return ESP_OK;
+}
+
+size_t dht11_encode(const dht11_reading_t *reading, dht11_pulse_t *pulses) {
+    float temperature = reading->temperature < 0 ? -reading->temperature : reading->temperature;
+    int humidity_tenths = (int)(reading->humidity * 10.0f + 0.5f);
+    int temperature_tenths = (int)(temperature * 10.0f + 0.5f);
+    uint8_t data[5] = {
+        humidity_tenths / 10,
+        humidity_tenths % 10,
+        temperature_tenths / 10,
+        (temperature_tenths % 10) | (reading->temperature < 0 ? 0x80 : 0),
+    };
+    data[4] = data[0] + data[1] + data[2] + data[3];
+
+    size_t n = 0;
+    pulses[n++] = (dht11_pulse_t){0, 80};
+    pulses[n++] = (dht11_pulse_t){1, 80};
+    for (int bit = 0; bit < 40; bit++) {
+        bool one = data[bit / 8] & (0x80 >> (bit % 8));
+        pulses[n++] = (dht11_pulse_t){0, 50};
+        pulses[n++] = (dht11_pulse_t){1, one ? 70 : 27};
+    }
+    return n;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// One captured level of the data line and how long it lasted
+typedef struct {
+    uint8_t level;
+    uint16_t duration_us;
+} dht11_pulse_t;
+
+typedef struct {
+    float temperature;
+    float humidity;
+} dht11_reading_t;
+
+// Pulses in a complete frame: response low/high plus a low/high pair per bit
+#define DHT11_FRAME_PULSES (2 + 2 * 40)
+
+// Decode a captured waveform. Pulses before the sensor response are skipped.
+// Returns ESP_ERR_NOT_FOUND without a response, ESP_ERR_INVALID_SIZE for a
+// truncated frame, ESP_ERR_INVALID_RESPONSE for out-of-spec timing and
+// ESP_ERR_INVALID_CRC for a checksum mismatch. Pure function, no hardware access.
+esp_err_t dht11_decode(const dht11_pulse_t *pulses, size_t count, dht11_reading_t *reading);
+
+// Build the waveform a sensor would send for `reading`, used by the host
+// simulation and for exercising the decoder. `pulses` needs DHT11_FRAME_PULSES entries.
+size_t dht11_encode(const dht11_reading_t *reading, dht11_pulse_t *pulses);
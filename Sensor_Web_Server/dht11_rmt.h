@@ -0,0 +1,43 @@
+#pragma once
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "dht11_decode.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_timer.h"
+#include "driver/rmt_rx.h"
+#endif
+
+// One RMT memory block; a frame needs about 43 symbols of two pulses each
+#define DHT11_RMT_SYMBOLS 64
+
+// Non-blocking DHT11 driver: the start signal is timed by esp_timer and the
+// reply is captured by the RMT peripheral, so no CPU time is spent on edges.
+// On the linux target a synthetic waveform goes through the same decoder.
+typedef struct {
+    int pin;
+    QueueHandle_t done; // Number of captured symbols, posted from the RMT ISR
+    dht11_pulse_t pulses[2 * DHT11_RMT_SYMBOLS];
+#if !CONFIG_IDF_TARGET_LINUX
+    rmt_channel_handle_t channel; // NULL after a failed reattach, recreated on the next select
+    int rx_signal;                // GPIO matrix input of the channel, -1 if unknown
+    esp_timer_handle_t start_timer;
+    rmt_symbol_word_t symbols[DHT11_RMT_SYMBOLS];
+#endif
+} dht11_rmt_t;
+
+esp_err_t dht11_rmt_init(dht11_rmt_t *sensor, int pin);
+
+// Move the capture channel to another sensor's data pin, so one channel can serve
+// several sensors read one after the other. The channel stays allocated and its
+// input is switched in the GPIO matrix. No-op if `pin` is already selected.
+esp_err_t dht11_rmt_select_pin(dht11_rmt_t *sensor, int pin);
+
+// Pull the line low for the start signal and return at once; a timer releases
+// it and arms the receiver 20 ms later
+esp_err_t dht11_rmt_start(dht11_rmt_t *sensor);
+
+// Sleep until the capture completes or `timeout` passes, then decode it.
+// Returns ESP_ERR_TIMEOUT or any dht11_decode error.
+esp_err_t dht11_rmt_wait(dht11_rmt_t *sensor, dht11_reading_t *reading, TickType_t timeout);
@@ -0,0 +1,155 @@
+#include <limits.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "history.h"
+
+// Fixed-size ring of time-ordered points
+struct history_ring {
+    history_point_t *points;
+    size_t capacity;
+    size_t head;  // Index of the oldest point
+    size_t count;
+};
+
+// Running min/max/sum of the bucket being filled for an aggregated tier
+struct history_bucket {
+    uint32_t start_s;
+    uint32_t samples;
+    int32_t temp_sum, hum_sum;
+    int16_t temp_min, temp_max;
+    int16_t hum_min, hum_max;
+};
+
+static history_point_t raw_points[HISTORY_RAW_LEN];
+static history_point_t minute_points[HISTORY_MINUTE_LEN];
+static history_point_t hour_points[HISTORY_HOUR_LEN];
+
+static struct history_ring rings[HISTORY_RES_COUNT] = {
+    [HISTORY_RES_RAW] = {raw_points, HISTORY_RAW_LEN},
+    [HISTORY_RES_MINUTE] = {minute_points, HISTORY_MINUTE_LEN},
+    [HISTORY_RES_HOUR] = {hour_points, HISTORY_HOUR_LEN},
+};
+
+// Bucket width in seconds per aggregated tier
+static const uint32_t bucket_width_s[HISTORY_RES_COUNT] = {
+    [HISTORY_RES_MINUTE] = 60,
+    [HISTORY_RES_HOUR] = 3600,
+};
+
+static struct history_bucket buckets[HISTORY_RES_COUNT];
+
+static SemaphoreHandle_t history_lock;
+
+static int16_t to_centi(float value) {
+    float scaled = value * 100.0f + (value < 0 ? -0.5f : 0.5f);
+    if (scaled > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (scaled < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)scaled;
+}
+
+static const history_point_t *ring_at(const struct history_ring *ring, size_t i) {
+    return &ring->points[(ring->head + i) % ring->capacity];
+}
+
+static void ring_push(struct history_ring *ring, const history_point_t *point) {
+    if (ring->count < ring->capacity) {
+        ring->points[(ring->head + ring->count) % ring->capacity] = *point;
+        ring->count++;
+    } else {
+        ring->points[ring->head] = *point;
+        ring->head = (ring->head + 1) % ring->capacity;
+    }
+}
+
+// Logical index of the first point with time_s >= from_s
+static size_t ring_lower_bound(const struct history_ring *ring, uint32_t from_s) {
+    size_t lo = 0, hi = ring->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ring_at(ring, mid)->time_s < from_s) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void bucket_flush(history_res_t res) {
+    struct history_bucket *bucket = &buckets[res];
+    if (bucket->samples == 0) {
+        return;
+    }
+    history_point_t point = {
+        .time_s = bucket->start_s,
+        .temp_min = bucket->temp_min,
+        .temp_max = bucket->temp_max,
+        .temp_mean = (int16_t)(bucket->temp_sum / (int32_t)bucket->samples),
+        .hum_min = bucket->hum_min,
+        .hum_max = bucket->hum_max,
+        .hum_mean = (int16_t)(bucket->hum_sum / (int32_t)bucket->samples),
+    };
+    ring_push(&rings[res], &point);
+    bucket->samples = 0;
+}
+
+static void bucket_add(history_res_t res, uint32_t time_s, int16_t temp, int16_t hum) {
+    struct history_bucket *bucket = &buckets[res];
+    uint32_t start_s = time_s - time_s % bucket_width_s[res];
+
+    if (bucket->samples && bucket->start_s != start_s) {
+        bucket_flush(res);
+    }
+    if (bucket->samples == 0) {
+        bucket->start_s = start_s;
+        bucket->temp_sum = bucket->hum_sum = 0;
+        bucket->temp_min = bucket->temp_max = temp;
+        bucket->hum_min = bucket->hum_max = hum;
+    }
+    bucket->samples++;
+    bucket->temp_sum += temp;
+    bucket->hum_sum += hum;
+    bucket->temp_min = temp < bucket->temp_min ? temp : bucket->temp_min;
+    bucket->temp_max = temp > bucket->temp_max ? temp : bucket->temp_max;
+    bucket->hum_min = hum < bucket->hum_min ? hum : bucket->hum_min;
+    bucket->hum_max = hum > bucket->hum_max ? hum : bucket->hum_max;
+}
+
+void history_init(void) {
+    history_lock = xSemaphoreCreateMutex();
+}
+
+void history_add(uint32_t time_s, float temperature, float humidity) {
+    int16_t temp = to_centi(temperature);
+    int16_t hum = to_centi(humidity);
+    history_point_t point = {time_s, temp, temp, temp, hum, hum, hum};
+
+    xSemaphoreTake(history_lock, portMAX_DELAY);
+    ring_push(&rings[HISTORY_RES_RAW], &point);
+    bucket_add(HISTORY_RES_MINUTE, time_s, temp, hum);
+    bucket_add(HISTORY_RES_HOUR, time_s, temp, hum);
+    xSemaphoreGive(history_lock);
+}
+
+size_t history_query(history_res_t res, uint32_t from_s, uint32_t to_s, history_point_t *out, size_t max) {
+    size_t copied = 0;
+    if (res >= HISTORY_RES_COUNT || from_s > to_s) {
+        return 0;
+    }
+
+    xSemaphoreTake(history_lock, portMAX_DELAY);
+    const struct history_ring *ring = &rings[res];
+    for (size_t i = ring_lower_bound(ring, from_s); i < ring->count && copied < max; i++) {
+        const history_point_t *point = ring_at(ring, i);
+        if (point->time_s > to_s) {
+            break;
+        }
+        out[copied++] = *point;
+    }
+    xSemaphoreGive(history_lock);
+    return copied;
+}
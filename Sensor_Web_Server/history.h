@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Capacity of each resolution tier, all storage is allocated statically
+#define HISTORY_RAW_LEN 600    // Every sample, 20 minutes at one sample per 2 s
+#define HISTORY_MINUTE_LEN 720 // 1-minute buckets, 12 hours
+#define HISTORY_HOUR_LEN 336   // 1-hour buckets, 14 days
+
+typedef enum {
+    HISTORY_RES_RAW,
+    HISTORY_RES_MINUTE,
+    HISTORY_RES_HOUR,
+    HISTORY_RES_COUNT,
+} history_res_t;
+
+// One stored point. Values are hundredths of a degree / percent; raw points
+// carry the sample in all three of min, max and mean.
+typedef struct {
+    uint32_t time_s; // Seconds since boot, start of the bucket for aggregated tiers
+    int16_t temp_min, temp_max, temp_mean;
+    int16_t hum_min, hum_max, hum_mean;
+} history_point_t;
+
+void history_init(void);
+
+// Record a sample, called by the acquisition task only
+void history_add(uint32_t time_s, float temperature, float humidity);
+
+// Copy up to `max` points of tier `res` with from_s <= time_s <= to_s, oldest first.
+// Returns the number copied; continue a long range with from_s = last time_s + 1.
+// Cost is O(log n) to locate the start plus O(points returned).
+size_t history_query(history_res_t res, uint32_t from_s, uint32_t to_s, history_point_t *out, size_t max);
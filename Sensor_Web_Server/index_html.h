@@ -0,0 +1,167 @@
+// Generated by tools/gzip_asset.py from index.html, do not edit
+// 2640 bytes plain, 1011 bytes gzip
+#ifndef INDEX_HTML_H
+#define INDEX_HTML_H
+
+#include <stdint.h>
+
+#define INDEX_HTML_ETAG "\"65baa6c3a2961af0\""
+#define INDEX_HTML_ETAG_GZ "\"65baa6c3a2961af0-gz\""
+
+static const char index_html[] =
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "    <meta charset=\"UTF-8\">\n"
+    "    <meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
+    "    <title>ESP32 Sensor Data</title>\n"
+    "    <style>\n"
+    "        body {\n"
+    "            font-family: Arial, sans-serif;\n"
+    "            background-color: #282c34;\n"
+    "            color: #ffffff;\n"
+    "            margin: 0;\n"
+    "            padding: 20px;\n"
+    "            display: flex;\n"
+    "            justify-content: center;\n"
+    "            align-items: center;\n"
+    "            height: 100vh;\n"
+    "        }\n"
+    "        .container {\n"
+    "            background-color: #3b3f46;\n"
+    "            border-radius: 8px;\n"
+    "            padding: 20px;\n"
+    "            box-shadow: 0 4px 8px rgba(0, 0, 0, 0.1);\n"
+    "            width: 100%;\n"
+    "            max-width: 600px;\n"
+    "            text-align: center;\n"
+    "        }\n"
+    "        h1 {\n"
+    "            color: #61dafb;\n"
+    "        }\n"
+    "        .data {\n"
+    "            font-size: 24px;\n"
+    "            margin: 20px 0;\n"
+    "        }\n"
+    "        .data span {\n"
+    "            display: block;\n"
+    "            font-size: 18px;\n"
+    "            color: #61dafb;\n"
+    "        }\n"
+    "        .footer {\n"
+    "            margin-top: 20px;\n"
+    "            font-size: 14px;\n"
+    "            color: #888888;\n"
+    "        }\n"
+    "        @media (max-width: 600px) {\n"
+    "            body {\n"
+    "                padding: 10px;\n"
+    "            }\n"
+    "            .container {\n"
+    "                padding: 10px;\n"
+    "            }\n"
+    "        }\n"
+    "    </style>\n"
+    "    <script>\n"
+    "        function showData(data) {\n"
+    "            document.getElementById('temperature').innerText = `Temperature: ${data.temperature} \302\260C`;\n"
+    "            document.getElementById('humidity').innerText = `Humidity: ${data.humidity} %`;\n"
+    "        }\n"
+    "        async function fetchData() {\n"
+    "            try {\n"
+    "                let response = await fetch('/data');\n"
+    "                showData(await response.json());\n"
+    "            } catch (error) {\n"
+    "                console.error('Error fetching data:', error);\n"
+    "            }\n"
+    "        }\n"
+    "        // Readings are pushed over the WebSocket as soon as they are sampled\n"
+    "        function subscribe() {\n"
+    "            let socket = new WebSocket(`ws://${location.host}/ws`);\n"
+    "            socket.onmessage = (event) => showData(JSON.parse(event.data));\n"
+    "            socket.onclose = () => setTimeout(subscribe, 2000); // Retry after a drop\n"
+    "        }\n"
+    "        window.onload = () => {\n"
+    "            fetchData(); // Initial value until the first push\n"
+    "            subscribe();\n"
+    "        };\n"
+    "    </script>\n"
+    "</head>\n"
+    "<body>\n"
+    "    <div class=\"container\">\n"
+    "        <h1>ESP32 Sensor Data</h1>\n"
+    "        <div id=\"temperature\" class=\"data\">Temperature: -- \302\260C</div>\n"
+    "        <div id=\"humidity\" class=\"data\">Humidity: -- %</div>\n"
+    "        <div class=\"footer\">Real-time sensor data from ESP32</div>\n"
+    "    </div>\n"
+    "</body>\n"
+    "</html>\n";
+
+static const uint8_t index_html_gz[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x56, 0xdd, 0x8e, 0x9b, 0x46,
+    0x14, 0xbe, 0xcf, 0x53, 0x9c, 0xba, 0x59, 0x19, 0x4b, 0x06, 0xec, 0x5d, 0x6b, 0xb5, 0xb2, 0xb1,
+    0xd5, 0x36, 0xd9, 0xa8, 0xe9, 0x45, 0x12, 0x75, 0x5d, 0x55, 0xbd, 0xf3, 0x98, 0x39, 0x98, 0x49,
+    0x60, 0x06, 0xcd, 0x0c, 0xfe, 0xe9, 0xca, 0xef, 0xd4, 0x67, 0xc8, 0x93, 0x75, 0x06, 0x8c, 0x31,
+    0x98, 0x8d, 0x76, 0x64, 0x99, 0x81, 0xf3, 0xff, 0x9d, 0x6f, 0x0e, 0x04, 0x3f, 0xbd, 0xff, 0xfc,
+    0x6e, 0xf9, 0xcf, 0x97, 0x47, 0x88, 0x75, 0x9a, 0x2c, 0xde, 0x04, 0xd5, 0x05, 0x09, 0x5d, 0xbc,
+    0x01, 0xb3, 0x82, 0x14, 0x35, 0x81, 0x30, 0x26, 0x52, 0xa1, 0x9e, 0xf7, 0xfe, 0x5a, 0x7e, 0x70,
+    0x1f, 0x7a, 0x97, 0x22, 0x4e, 0x52, 0x9c, 0xf7, 0xb6, 0x0c, 0x77, 0x99, 0x90, 0xba, 0x07, 0xa1,
+    0xe0, 0x1a, 0xb9, 0x51, 0xdd, 0x31, 0xaa, 0xe3, 0x39, 0xc5, 0x2d, 0x0b, 0xd1, 0x2d, 0x6e, 0x86,
+    0xc0, 0x38, 0xd3, 0x8c, 0x24, 0xae, 0x0a, 0x49, 0x82, 0xf3, 0xb1, 0x37, 0xaa, 0x5c, 0x69, 0xa6,
+    0x13, 0x5c, 0x3c, 0x3e, 0x7d, 0xb9, 0xbb, 0x85, 0x27, 0xe4, 0x4a, 0x48, 0x78, 0x4f, 0x34, 0x09,
+    0xfc, 0x52, 0x50, 0x2a, 0x29, 0x7d, 0xa8, 0xf6, 0x76, 0xad, 0x05, 0x3d, 0xc0, 0xf3, 0xf9, 0xd6,
+    0xae, 0xc8, 0x04, 0x77, 0x23, 0x92, 0xb2, 0xe4, 0x30, 0x85, 0x5f, 0xa5, 0x09, 0x35, 0x04, 0x45,
+    0xb8, 0x72, 0x15, 0x4a, 0x16, 0xcd, 0x1a, 0xba, 0x6b, 0x12, 0x7e, 0xdb, 0x48, 0x91, 0x73, 0xea,
+    0x86, 0x22, 0x11, 0x72, 0x0a, 0x3f, 0xdf, 0x3e, 0xdc, 0x86, 0x77, 0x93, 0xa6, 0x5a, 0x25, 0x8b,
+    0x8a, 0xd5, 0x94, 0xa5, 0x44, 0x6e, 0x18, 0x9f, 0xc2, 0xa8, 0xf9, 0x38, 0x23, 0x94, 0x32, 0xbe,
+    0x99, 0xc2, 0xed, 0x28, 0xdb, 0x37, 0x45, 0x94, 0xa9, 0x2c, 0x21, 0x26, 0xb9, 0x28, 0xc1, 0x96,
+    0xe8, 0x6b, 0xae, 0x34, 0x8b, 0x0e, 0xee, 0x09, 0xc0, 0x29, 0x84, 0xe6, 0x1f, 0x65, 0x53, 0x89,
+    0x24, 0x6c, 0xc3, 0x5d, 0xa6, 0x31, 0x55, 0xdd, 0x0a, 0x31, 0xb2, 0x4d, 0x6c, 0x8c, 0xc7, 0xa3,
+    0xd1, 0x36, 0xae, 0x45, 0xc7, 0xf3, 0xce, 0xb3, 0xfe, 0x09, 0xe3, 0x28, 0x5b, 0xd8, 0x75, 0xe0,
+    0x71, 0xb7, 0xbe, 0x8b, 0x26, 0xf7, 0x2d, 0xd8, 0x84, 0xa4, 0x28, 0x5d, 0x49, 0x28, 0xcb, 0x4d,
+    0x0e, 0x0f, 0xed, 0x0a, 0x7f, 0x50, 0xfc, 0x5a, 0xec, 0x5d, 0x15, 0x13, 0x2a, 0x76, 0x06, 0x32,
+    0x98, 0x64, 0x7b, 0x6b, 0x0d, 0x72, 0xb3, 0x26, 0xce, 0x68, 0x08, 0xa7, 0x9f, 0x37, 0x1e, 0x34,
+    0xad, 0x0a, 0xea, 0x14, 0x05, 0xdd, 0xb4, 0xd1, 0xdf, 0xbb, 0x27, 0xe1, 0xfd, 0xe8, 0x2a, 0x98,
+    0xc6, 0xbd, 0x76, 0x0b, 0xb8, 0xae, 0x81, 0xaa, 0xd1, 0x88, 0xc7, 0x2d, 0x14, 0xaa, 0xd2, 0xef,
+    0xc7, 0x94, 0x44, 0xeb, 0x4e, 0x00, 0xa9, 0x21, 0x66, 0x17, 0xef, 0x14, 0xfb, 0x17, 0x4d, 0xd9,
+    0x93, 0x76, 0x26, 0x15, 0x4b, 0x2c, 0x20, 0x97, 0x54, 0x69, 0xbb, 0x54, 0x19, 0xe1, 0x2d, 0xbf,
+    0x67, 0xba, 0xac, 0x13, 0x11, 0x7e, 0x9b, 0xbd, 0x14, 0x73, 0x7c, 0xd5, 0x85, 0x57, 0x94, 0x11,
+    0x09, 0xa1, 0xaf, 0x48, 0x50, 0xe6, 0xea, 0x6a, 0x91, 0x75, 0x35, 0xf0, 0x32, 0xe4, 0xe4, 0xa5,
+    0x90, 0x0f, 0xc5, 0xea, 0x0a, 0xf9, 0x4b, 0x8a, 0x94, 0x11, 0x70, 0xda, 0x8d, 0x1b, 0xb4, 0x99,
+    0x78, 0x7d, 0xb0, 0x1b, 0xcc, 0x1a, 0x5f, 0x25, 0x76, 0x6c, 0xdc, 0xbd, 0x48, 0xf1, 0x57, 0x7b,
+    0x29, 0x77, 0x81, 0x7f, 0x31, 0x71, 0x02, 0x15, 0x4a, 0x96, 0xe9, 0x7a, 0xfc, 0x44, 0x39, 0x0f,
+    0x35, 0x13, 0x1c, 0x54, 0x2c, 0x76, 0x76, 0x58, 0x39, 0xb6, 0x8b, 0xed, 0x5a, 0xa8, 0x08, 0xf3,
+    0xd4, 0xd0, 0xcf, 0xdb, 0xa0, 0x7e, 0x4c, 0xd0, 0x6e, 0x7f, 0x3b, 0x7c, 0xa4, 0x4e, 0xdf, 0x1c,
+    0xe1, 0x0c, 0x25, 0xd1, 0xb9, 0xc4, 0xfe, 0xc0, 0x63, 0xdc, 0x64, 0xbb, 0x34, 0x94, 0x85, 0x39,
+    0xac, 0x96, 0xb5, 0x68, 0x0a, 0x6f, 0x9f, 0xad, 0x5b, 0xef, 0x42, 0xfd, 0x08, 0xdf, 0xff, 0x7b,
+    0xb7, 0x9a, 0xbd, 0x2e, 0x4c, 0x9c, 0xa7, 0x8c, 0x32, 0x7d, 0x68, 0xc7, 0xf8, 0xfd, 0xf4, 0xfc,
+    0x1c, 0xa0, 0x52, 0x3c, 0xc2, 0xcd, 0xaa, 0xab, 0x79, 0x44, 0x1d, 0x78, 0x58, 0x17, 0x1d, 0xa1,
+    0x0e, 0xe3, 0xa2, 0xea, 0x76, 0xc5, 0x5a, 0x76, 0x35, 0x2f, 0x41, 0x0d, 0x12, 0x55, 0x26, 0xb8,
+    0x42, 0x13, 0x9f, 0xec, 0x08, 0xd3, 0xa5, 0x13, 0xa7, 0xef, 0xdb, 0x04, 0xfa, 0xad, 0x63, 0x6f,
+    0xd7, 0x19, 0xd9, 0x52, 0xbd, 0xb2, 0xf7, 0xbe, 0x2a, 0xc1, 0x9d, 0x41, 0xcb, 0xe0, 0x08, 0x21,
+    0x31, 0xee, 0xc0, 0x41, 0x29, 0x85, 0x1c, 0x74, 0xe4, 0x60, 0x68, 0xa1, 0x44, 0x82, 0x5e, 0xa1,
+    0xe0, 0xf4, 0x1f, 0xed, 0xa5, 0xcc, 0xc1, 0x10, 0x02, 0x6c, 0x12, 0xd3, 0xfe, 0x10, 0x4a, 0xf3,
+    0x1f, 0x33, 0xc3, 0x2e, 0xdf, 0x87, 0x3f, 0xcd, 0x6b, 0xd2, 0x98, 0x2a, 0x20, 0x12, 0x21, 0xcb,
+    0x55, 0x8c, 0x14, 0xc4, 0xd6, 0xd0, 0x4e, 0xc7, 0x08, 0x7f, 0xe3, 0xfa, 0xc9, 0x1c, 0x5a, 0x53,
+    0x37, 0x51, 0xa0, 0x84, 0xc1, 0xcc, 0x5c, 0x8d, 0xe0, 0x50, 0x68, 0x2b, 0x92, 0x66, 0x09, 0xd2,
+    0x0e, 0x36, 0xe5, 0x6b, 0xcb, 0xb4, 0x35, 0x5e, 0x01, 0x6b, 0x21, 0x54, 0xa5, 0xc7, 0x39, 0x70,
+    0xdc, 0xd5, 0x11, 0x9c, 0xd5, 0x4e, 0x4d, 0x7d, 0xff, 0xed, 0xb3, 0x99, 0x12, 0xc4, 0x7a, 0xf1,
+    0x62, 0xa1, 0xf4, 0xd1, 0xdf, 0xa9, 0x55, 0xab, 0x90, 0xd2, 0xde, 0x13, 0x3c, 0x45, 0xa5, 0xc8,
+    0xc6, 0xb6, 0xc2, 0xc1, 0xad, 0x61, 0xcb, 0x00, 0xe6, 0x8b, 0x1a, 0xef, 0x3f, 0x9e, 0x3e, 0x7f,
+    0xf2, 0x32, 0xfb, 0xce, 0x2f, 0xa5, 0xc5, 0x80, 0x1a, 0xbc, 0xe4, 0x2b, 0x4c, 0x44, 0xd1, 0x54,
+    0xa7, 0x74, 0x82, 0x7a, 0xc9, 0x52, 0x14, 0xb9, 0x76, 0xce, 0xb5, 0x0c, 0xcd, 0x30, 0x19, 0x8d,
+    0x06, 0xb3, 0x12, 0x34, 0xcb, 0x10, 0x12, 0xd9, 0xe1, 0x43, 0x80, 0x4a, 0x91, 0x75, 0x80, 0xbb,
+    0x63, 0xdc, 0xbc, 0x26, 0x8c, 0xef, 0x44, 0x10, 0x7a, 0x76, 0xdd, 0x1a, 0xba, 0x35, 0x05, 0x0b,
+    0xc7, 0x1f, 0xcb, 0x8f, 0x0b, 0xd8, 0x92, 0x24, 0x47, 0xc8, 0xb9, 0x66, 0x49, 0xd1, 0x88, 0x88,
+    0x49, 0xa5, 0x8b, 0xf6, 0x34, 0xd3, 0xaf, 0x81, 0xbe, 0xe0, 0xfb, 0xac, 0x3a, 0xf9, 0xa7, 0xd3,
+    0x1e, 0xf8, 0xe5, 0xb7, 0x50, 0x60, 0x87, 0xd2, 0x69, 0x12, 0x50, 0xb6, 0x85, 0x30, 0x21, 0x4a,
+    0xcd, 0x7b, 0xe7, 0x49, 0xd3, 0xab, 0x07, 0x43, 0x10, 0x8f, 0xbb, 0xbe, 0x64, 0xcc, 0xd3, 0x5a,
+    0xc5, 0xba, 0x60, 0x74, 0xde, 0xbb, 0x38, 0xd6, 0xbd, 0xca, 0xa7, 0xc5, 0xba, 0xb7, 0x68, 0x0c,
+    0x01, 0xd7, 0xb5, 0x67, 0x3e, 0xf0, 0x8d, 0x59, 0x87, 0x93, 0xea, 0xe8, 0xb6, 0x3c, 0xd4, 0x47,
+    0xdc, 0x98, 0xdf, 0x74, 0x19, 0x9f, 0xd4, 0xcb, 0x37, 0x41, 0x6f, 0x61, 0xe8, 0x9c, 0xb8, 0xda,
+    0xf4, 0xce, 0xf4, 0xb0, 0x48, 0xbc, 0x78, 0x2d, 0x45, 0x52, 0xa4, 0x50, 0xd4, 0x73, 0xe1, 0xe2,
+    0xb4, 0x0d, 0xfc, 0x12, 0x16, 0x53, 0x5d, 0xf1, 0xe1, 0xf8, 0x3f, 0xd9, 0x79, 0x99, 0x5c, 0x50,
+    0x0a, 0x00, 0x00,
+};
+
+#endif
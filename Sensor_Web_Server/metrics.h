@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+#include "esp_timer.h"
+
+// Upper bounds of the latency buckets in microseconds, +Inf is implied
+#define METRICS_BUCKET_BOUNDS_US {250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000}
+#define METRICS_BUCKETS 10
+#define METRICS_MAX_ENTRIES 32 // Histograms, counters and gauges together
+
+// Hot-path updates are relaxed 32-bit atomic adds, lock-free on both the
+// Xtensa and RISC-V targets. Sums are in microseconds and wrap after about
+// 71 minutes of accumulated latency, which Prometheus reads as a counter reset.
+typedef struct {
+    const char *name;
+    const char *labels; // e.g. "route=\"/data\"", NULL for none
+    atomic_uint buckets[METRICS_BUCKETS];
+    atomic_uint count;
+    atomic_uint sum_us;
+} metrics_histogram_t;
+
+typedef struct {
+    const char *name;
+    const char *labels;
+    atomic_uint value;
+} metrics_counter_t;
+
+// Gauges, and counters kept elsewhere, are sampled when /metrics is scraped
+typedef uint32_t (*metrics_gauge_fn_t)(void);
+
+#define METRICS_HISTOGRAM(_name, _labels) {.name = (_name), .labels = (_labels)}
+#define METRICS_COUNTER(_name, _labels) {.name = (_name), .labels = (_labels)}
+
+// Registration is not thread safe: register everything before the server starts.
+// Entries sharing a name form one metric family and should be registered together.
+// metrics_init() adds the heap gauges on targets that have them.
+void metrics_init(void);
+void metrics_register_histogram(metrics_histogram_t *histogram, const char *help);
+void metrics_register_counter(metrics_counter_t *counter, const char *help);
+void metrics_register_gauge(const char *name, const char *labels, const char *help, metrics_gauge_fn_t read);
+void metrics_register_counter_fn(const char *name, const char *labels, const char *help, metrics_gauge_fn_t read);
+
+void metrics_observe(metrics_histogram_t *histogram, uint32_t duration_us);
+
+static inline void metrics_inc(metrics_counter_t *counter) {
+    atomic_fetch_add_explicit(&counter->value, 1, memory_order_relaxed);
+}
+
+// Observe the time elapsed since `start_us`, an esp_timer_get_time() value
+static inline void metrics_observe_since(metrics_histogram_t *histogram, int64_t start_us) {
+    metrics_observe(histogram, (uint32_t)(esp_timer_get_time() - start_us));
+}
+
+// Timed route: register metrics_timed_handler with a metrics_route_t as user_ctx
+// and every request through it is observed in `histogram`
+typedef struct {
+    esp_err_t (*handler)(httpd_req_t *req);
+    metrics_histogram_t *histogram;
+} metrics_route_t;
+
+esp_err_t metrics_timed_handler(httpd_req_t *req);
+
+// GET /metrics in the Prometheus text format, streamed in chunks
+esp_err_t metrics_handler(httpd_req_t *req);
@@ -0,0 +1,272 @@
+#include "sdkconfig.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "my_data.h"
+#endif
+#include "mqtt_publisher.h"
+
+#if MQTT_PUBLISHER_ENABLE
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "mqtt_client.h"
+#include "cbor_writer.h"
+#include "metrics.h"
+#include "task_topology.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_mac.h"
+#endif
+
+#define POLL_MS 1000 // Batch age and ack timeout are checked at least this often
+
+static const char *TAG = "mqtt_publisher";
+
+// Ring of records, indexed by absolute counters so the batch in flight stays
+// valid while newer records are added or the oldest are dropped
+static struct {
+    int64_t queued_us;
+    uint8_t len;
+    uint8_t data[MQTT_RECORD_MAX];
+} queue[MQTT_QUEUE_LEN];
+static uint32_t queue_head; // Oldest record not yet acknowledged
+static uint32_t queue_tail; // Next record to write
+static mqtt_publisher_stats_t stats;
+static SemaphoreHandle_t lock;
+
+// The MQTT event handler only sets these and wakes the task, it never takes
+// `lock`, since the task calls into the client while the client may be
+// dispatching an event
+static atomic_bool connected;
+static atomic_int acked_msg_id = -1;
+
+static esp_mqtt_client_handle_t client;
+static TaskHandle_t publisher_task_handle;
+static char topic[32];
+static uint8_t batch[3 + MQTT_BATCH_MAX_RECORDS * MQTT_RECORD_MAX];
+
+static metrics_histogram_t ack_latency = METRICS_HISTOGRAM("mqtt_publish_ack_seconds", NULL);
+
+static void mqtt_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data) {
+    esp_mqtt_event_handle_t event = event_data;
+
+    switch (event_id) {
+    case MQTT_EVENT_CONNECTED:
+        ESP_LOGI(TAG, "Connected to %s", MQTT_BROKER_URI);
+        atomic_store(&connected, true);
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        // The client reconnects by itself; records stay queued until acknowledged
+        ESP_LOGW(TAG, "Disconnected, queueing");
+        atomic_store(&connected, false);
+        break;
+    case MQTT_EVENT_PUBLISHED:
+        atomic_store(&acked_msg_id, event->msg_id);
+        break;
+    default:
+        return;
+    }
+    xTaskNotifyGive(publisher_task_handle);
+}
+
+// Copy up to MQTT_BATCH_MAX_RECORDS records from the head into `batch` once the
+// size or age threshold is reached. Returns the payload length, 0 if not due.
+static size_t take_batch(uint32_t *end) {
+    size_t len = 0;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t pending = queue_tail - queue_head;
+    bool due = pending >= MQTT_BATCH_MAX_RECORDS ||
+               (pending > 0 && esp_timer_get_time() - queue[queue_head % MQTT_QUEUE_LEN].queued_us >=
+                                   MQTT_BATCH_MAX_MS * 1000LL);
+    if (due) {
+        uint32_t count = pending < MQTT_BATCH_MAX_RECORDS ? pending : MQTT_BATCH_MAX_RECORDS;
+        cbor_writer_t writer;
+        cbor_writer_init(&writer, batch, sizeof(batch));
+        cbor_put_array(&writer, count);
+        for (uint32_t i = queue_head; i < queue_head + count; i++) {
+            memcpy(batch + writer.len, queue[i % MQTT_QUEUE_LEN].data, queue[i % MQTT_QUEUE_LEN].len);
+            writer.len += queue[i % MQTT_QUEUE_LEN].len;
+        }
+        *end = queue_head + count;
+        len = writer.len;
+    }
+    xSemaphoreGive(lock);
+    return len;
+}
+
+// One QoS 1 batch in flight at a time; its records leave the queue on PUBACK
+static void publisher_task(void *pvParameter) {
+    int msg_id = -1;
+    uint32_t batch_end = 0;
+    int64_t sent_us = 0;
+
+    while (1) {
+        bool drain = false;
+
+        if (msg_id >= 0 && atomic_load(&acked_msg_id) == msg_id) {
+            metrics_observe_since(&ack_latency, sent_us);
+            xSemaphoreTake(lock, portMAX_DELAY);
+            // Records of this batch dropped meanwhile have already moved the head past them
+            if ((int32_t)(batch_end - queue_head) > 0) {
+                stats.published += batch_end - queue_head;
+                queue_head = batch_end;
+            }
+            stats.batches++;
+            xSemaphoreGive(lock);
+            msg_id = -1;
+            drain = true;
+        } else if (msg_id >= 0 && esp_timer_get_time() - sent_us >= MQTT_ACK_TIMEOUT_MS * 1000LL) {
+            ESP_LOGW(TAG, "No PUBACK for message %d, sending the batch again", msg_id);
+            xSemaphoreTake(lock, portMAX_DELAY);
+            stats.resent++;
+            xSemaphoreGive(lock);
+            msg_id = -1;
+        }
+
+        if (msg_id < 0 && atomic_load(&connected)) {
+            size_t len = take_batch(&batch_end);
+            if (len > 0) {
+                msg_id = esp_mqtt_client_enqueue(client, topic, (const char *)batch, len, 1, 0, true);
+                sent_us = esp_timer_get_time();
+                if (msg_id < 0) {
+                    ESP_LOGW(TAG, "Outbox full, retrying");
+                }
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, drain ? 0 : pdMS_TO_TICKS(POLL_MS));
+    }
+}
+
+static void make_topic(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "sim");
+#else
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "%02x%02x%02x%02x%02x%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+#endif
+}
+
+esp_err_t mqtt_publisher_start(void) {
+    const esp_mqtt_client_config_t config = {
+        .broker.address.uri = MQTT_BROKER_URI,
+    };
+
+    lock = xSemaphoreCreateMutex();
+    make_topic();
+    client = esp_mqtt_client_init(&config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Client init failed");
+        return ESP_FAIL;
+    }
+    xTaskCreatePinnedToCore(publisher_task, "mqtt_publisher", PUBLISHER_TASK_STACK, NULL, PUBLISHER_TASK_PRIORITY,
+                            &publisher_task_handle, PUBLISHER_TASK_CORE);
+    esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, mqtt_event_handler, NULL);
+    ESP_LOGI(TAG, "Publishing to %s on %s", topic, MQTT_BROKER_URI);
+    return esp_mqtt_client_start(client);
+}
+
+void mqtt_publisher_add(const uint8_t *record, size_t len) {
+    bool full_batch;
+
+    if (lock == NULL || len == 0 || len > MQTT_RECORD_MAX) {
+        return;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (queue_tail - queue_head == MQTT_QUEUE_LEN) {
+        queue_head++;
+        stats.dropped++;
+    }
+    queue[queue_tail % MQTT_QUEUE_LEN].queued_us = esp_timer_get_time();
+    queue[queue_tail % MQTT_QUEUE_LEN].len = len;
+    memcpy(queue[queue_tail % MQTT_QUEUE_LEN].data, record, len);
+    queue_tail++;
+    stats.queued++;
+    full_batch = queue_tail - queue_head >= MQTT_BATCH_MAX_RECORDS;
+    xSemaphoreGive(lock);
+
+    if (full_batch) {
+        xTaskNotifyGive(publisher_task_handle);
+    }
+}
+
+void mqtt_publisher_get_stats(mqtt_publisher_stats_t *out) {
+    if (lock == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    *out = stats;
+    out->queue_depth = queue_tail - queue_head;
+    xSemaphoreGive(lock);
+    out->connected = atomic_load(&connected);
+}
+
+static uint32_t queue_depth(void) {
+    mqtt_publisher_stats_t current;
+    mqtt_publisher_get_stats(&current);
+    return current.queue_depth;
+}
+
+static uint32_t records_dropped(void) {
+    mqtt_publisher_stats_t current;
+    mqtt_publisher_get_stats(&current);
+    return current.dropped;
+}
+
+static uint32_t records_published(void) {
+    mqtt_publisher_stats_t current;
+    mqtt_publisher_get_stats(&current);
+    return current.published;
+}
+
+static uint32_t batches_published(void) {
+    mqtt_publisher_stats_t current;
+    mqtt_publisher_get_stats(&current);
+    return current.batches;
+}
+
+static uint32_t batches_resent(void) {
+    mqtt_publisher_stats_t current;
+    mqtt_publisher_get_stats(&current);
+    return current.resent;
+}
+
+static uint32_t broker_connected(void) {
+    return atomic_load(&connected);
+}
+
+void mqtt_publisher_register_metrics(void) {
+    metrics_register_histogram(&ack_latency, "Delay from queueing a batch to its PUBACK");
+    metrics_register_gauge("mqtt_queue_depth", NULL, "Records waiting for a PUBACK", queue_depth);
+    metrics_register_counter_fn("mqtt_records_dropped_total", NULL, "Records overwritten while the queue was full", records_dropped);
+    metrics_register_counter_fn("mqtt_records_published_total", NULL, "Records acknowledged by the broker", records_published);
+    metrics_register_counter_fn("mqtt_batches_total", NULL, "Batches acknowledged by the broker", batches_published);
+    metrics_register_counter_fn("mqtt_batches_resent_total", NULL, "Batches sent again after an ack timeout", batches_resent);
+    metrics_register_gauge("mqtt_connected", NULL, "1 while connected to the broker", broker_connected);
+}
+
+#else
+
+esp_err_t mqtt_publisher_start(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void mqtt_publisher_add(const uint8_t *record, size_t len) {
+}
+
+void mqtt_publisher_get_stats(mqtt_publisher_stats_t *stats) {
+    *stats = (mqtt_publisher_stats_t){0};
+}
+
+void mqtt_publisher_register_metrics(void) {
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Push readings to an MQTT broker instead of (or as well as) being polled.
+// Off by default, enable with -DMQTT_PUBLISHER_ENABLE=1 and add esp-mqtt to the build.
+#ifndef MQTT_PUBLISHER_ENABLE
+#define MQTT_PUBLISHER_ENABLE 0
+#endif
+
+// Board builds take the broker from my_data.h, next to SSID and PASS
+#ifndef MQTT_BROKER_URI
+#define MQTT_BROKER_URI "mqtt://127.0.0.1:1883" // Local mosquitto for the Linux build
+#endif
+
+#define MQTT_TOPIC_PREFIX "sensors/"    // Followed by the station MAC, e.g. sensors/246f28a1b2c3
+#define MQTT_RECORD_MAX 80              // Largest record, one sample's CBOR encoding
+#define MQTT_QUEUE_LEN 128              // Records held while the broker is away, ~4 min at 2 s
+#define MQTT_BATCH_MAX_RECORDS 16       // A batch goes out when it has this many records...
+#define MQTT_BATCH_MAX_MS 10000         // ...or its oldest record is this old
+#define MQTT_ACK_TIMEOUT_MS 30000       // Batch sent again if its PUBACK has not come by then
+
+typedef struct {
+    uint32_t queued;     // Records accepted by mqtt_publisher_add()
+    uint32_t dropped;    // Oldest records overwritten while the queue was full
+    uint32_t published;  // Records acknowledged by the broker
+    uint32_t batches;    // Batches acknowledged by the broker
+    uint32_t resent;     // Batches sent again after MQTT_ACK_TIMEOUT_MS
+    uint32_t queue_depth;
+    bool connected;
+} mqtt_publisher_stats_t;
+
+// Connect to MQTT_BROKER_URI and keep reconnecting in the background
+esp_err_t mqtt_publisher_start(void);
+
+// Queue one record; never blocks on the network. Batches are published with
+// QoS 1 as a CBOR array of records, and records leave the queue only once the
+// broker acknowledged them, so delivery is at least once: after a lost PUBACK
+// a batch can arrive twice, consumers dedupe on (sensor, seq).
+void mqtt_publisher_add(const uint8_t *record, size_t len);
+
+void mqtt_publisher_get_stats(mqtt_publisher_stats_t *stats);
+
+// Add the publisher's metrics to /metrics, before the HTTP server starts
+void mqtt_publisher_register_metrics(void);
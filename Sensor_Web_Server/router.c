@@ -0,0 +1,138 @@
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "router.h"
+
+static const char *TAG = "router";
+
+uint32_t router_hash(const char *path, size_t len, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)path[i]) * 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+static bool is_prefix_route(const router_route_t *route) {
+    size_t len = strlen(route->path);
+    return len > 0 && route->path[len - 1] == '*';
+}
+
+// True if `query` (the part after '?') has `key`, with or without a value
+static bool query_has_key(const char *query, const char *key) {
+    size_t key_len = strlen(key);
+    while (*query) {
+        size_t len = strcspn(query, "&");
+        size_t name_len = strcspn(query, "=&");
+        if (name_len == key_len && strncmp(query, key, key_len) == 0) {
+            return true;
+        }
+        query += len + (query[len] == '&');
+    }
+    return false;
+}
+
+static const router_route_t *find_path(const router_t *router, const char *path, size_t path_len) {
+    uint8_t slot = router->slots[router_hash(path, path_len, router->seed) & (router->slot_count - 1)];
+    if (slot) {
+        const router_route_t *route = &router->routes[slot - 1];
+        if (strncmp(route->path, path, path_len) == 0 && route->path[path_len] == '\0') {
+            return route;
+        }
+    }
+    for (size_t i = 0; i < router->route_count; i++) {
+        const router_route_t *route = &router->routes[i];
+        if (is_prefix_route(route) && strncmp(route->path, path, strlen(route->path) - 1) == 0) {
+            return route;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t router_dispatch(httpd_req_t *req) {
+    const router_t *router = req->user_ctx;
+    const router_route_t *end = router->routes + router->route_count;
+    size_t path_len = strcspn(req->uri, "?");
+    const char *query = req->uri[path_len] ? req->uri + path_len + 1 : "";
+    bool method_allowed = false;
+
+    const router_route_t *first = find_path(router, req->uri, path_len);
+    if (first == NULL) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, NULL);
+    }
+    for (const router_route_t *route = first; route < end && strcmp(route->path, first->path) == 0; route++) {
+        if (route->websocket || route->method != req->method) {
+            continue;
+        }
+        method_allowed = true;
+        if (route->query && !query_has_key(query, route->query)) {
+            continue;
+        }
+        if (route->content_type) {
+            httpd_resp_set_type(req, route->content_type);
+        }
+        req->user_ctx = route->user_ctx;
+        return route->handler(req);
+    }
+    if (method_allowed) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing query parameter");
+    }
+    return httpd_resp_send_err(req, HTTPD_405_METHOD_NOT_ALLOWED, NULL);
+}
+
+void router_apply(httpd_config_t *config) {
+    config->uri_match_fn = httpd_uri_match_wildcard;
+}
+
+esp_err_t router_register(httpd_handle_t server, const router_t *router) {
+    const router_route_t *routes = router->routes;
+
+    // Each exact path must hash to its first route, as tools/route_hash.py laid it out
+    for (size_t i = 0; i < router->route_count; i++) {
+        if (is_prefix_route(&routes[i]) || (i > 0 && strcmp(routes[i].path, routes[i - 1].path) == 0)) {
+            continue;
+        }
+        uint32_t hash = router_hash(routes[i].path, strlen(routes[i].path), router->seed);
+        if (router->slots[hash & (router->slot_count - 1)] != i + 1) {
+            ESP_LOGE(TAG, "Route %s is not in the hash, rerun tools/route_hash.py", routes[i].path);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    for (size_t i = 0; i < router->route_count; i++) {
+        if (routes[i].websocket) {
+#if CONFIG_HTTPD_WS_SUPPORT
+            const httpd_uri_t uri = {
+                .uri = routes[i].path,
+                .method = HTTP_GET,
+                .handler = routes[i].handler,
+                .user_ctx = routes[i].user_ctx,
+                .is_websocket = true,
+            };
+            httpd_register_uri_handler(server, &uri);
+#else
+            ESP_LOGE(TAG, "Route %s needs CONFIG_HTTPD_WS_SUPPORT=y", routes[i].path);
+#endif
+        }
+    }
+
+    for (size_t i = 0; i < router->route_count; i++) {
+        bool registered = routes[i].websocket;
+        for (size_t j = 0; j < i && !registered; j++) {
+            registered = !routes[j].websocket && routes[j].method == routes[i].method;
+        }
+        if (!registered) {
+            const httpd_uri_t uri = {
+                .uri = "/*",
+                .method = routes[i].method,
+                .handler = router_dispatch,
+                .user_ctx = (void *)router,
+            };
+            esp_err_t err = httpd_register_uri_handler(server, &uri);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+// One entry of a route table. `path` is an exact path, or a prefix ending in
+// '*'. Routes sharing a path must be adjacent, the first one whose method and
+// query match wins.
+typedef struct {
+    const char *path;
+    httpd_method_t method;
+    const char *query;        // Query key the request must carry, NULL for any
+    const char *content_type; // Response type set before the handler runs, NULL to leave it
+    esp_err_t (*handler)(httpd_req_t *req);
+    void *user_ctx;           // Passed to the handler as req->user_ctx
+    bool websocket;           // Registered with httpd itself, which handles the handshake
+} router_route_t;
+
+// Route table plus its perfect hash, generated from the table by tools/route_hash.py:
+// every exact path lands in its own slot, which holds the index of its first
+// route plus one. A request costs one hash and one string compare however many
+// routes there are; only a miss goes on to the '*' routes.
+typedef struct {
+    const router_route_t *routes;
+    size_t route_count;
+    const uint8_t *slots;
+    size_t slot_count; // Power of two
+    uint32_t seed;
+} router_t;
+
+#define ROUTER(_routes, _slots, _seed) \
+    {(_routes), sizeof(_routes) / sizeof((_routes)[0]), (_slots), sizeof(_slots), (_seed)}
+
+// Path hash shared with tools/route_hash.py: seeded FNV-1a, high bits folded in
+uint32_t router_hash(const char *path, size_t len, uint32_t seed);
+
+// Match every URI against the handlers router_register() installs
+void router_apply(httpd_config_t *config);
+
+// Register one catch-all handler per method in the table, after the WebSocket
+// routes so httpd still sees their handshakes. Fails with ESP_ERR_INVALID_STATE,
+// registering nothing, if the table changed since the hash was generated.
+esp_err_t router_register(httpd_handle_t server, const router_t *router);
@@ -0,0 +1,21 @@
+// Generated by tools/route_hash.py from sensor_dht11.c, do not edit
+// 7 paths in 8 slots
+#ifndef ROUTES_HASH_H
+#define ROUTES_HASH_H
+
+#include <stdint.h>
+
+#define ROUTES_SEED 0x00000012u
+
+static const uint8_t routes_slots[8] = {
+    2, // /data
+    5, // /log
+    0,
+    6, // /ws
+    1, // /
+    4, // /history
+    8, // /metrics
+    3, // /sensors
+};
+
+#endif
@@ -1,263 +1,1122 @@
 #include <stdio.h>
+#include <math.h>
+#include <stdatomic.h>
 #include <sys/param.h>
-#include "esp_wifi.h"
+#include "sdkconfig.h"
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "freertos/event_groups.h"
 #include <esp_http_server.h>
-#include "esp32-dht11.h"
-#include "my_data.h"
+#include "index_html.h"
+#include "history.h"
+#include "sensor_log.h"
+#include "dht11_rmt.h"
+#include "wifi_station.h"
+#include "server_tuning.h"
+#include "metrics.h"
+#include "resp_template.h"
+#include "router.h"
+#include "routes_hash.h"
+#include "task_topology.h"
+#include "sensor_filter.h"
+#include "cbor_writer.h"
+#include "mqtt_publisher.h"
+#include "body_parser.h"
+#include "asset_bundle.h"
 
-#define CONFIG_DHT11_PIN GPIO_NUM_4
-#define CONFIG_CONNECTION_TIMEOUT 5
+// Unprivileged port for the host simulation build
+#define SIM_SERVER_PORT 8080
 
-static char ip_address[16] = {0};  // Buffer to hold the IP address as a string
+// Data pins of the attached DHT11 sensors, read in turn by dht11_task.
+// Sensor 0 also feeds the history, the flash log and the WebSocket push.
+static const uint8_t dht11_pins[] = {4};
+
+#define DHT11_SENSOR_COUNT (sizeof(dht11_pins) / sizeof(dht11_pins[0]))
+#define CONFIG_READ_TIMEOUT_MS 100
+#define CONFIG_SAMPLE_PERIOD_MS 2000 // Each sensor is read once per period
+#define DHT11_MIN_INTERVAL_MS 1000   // Datasheet minimum between reads of one sensor
+#define DHT11_SLOT_MIN_MS 30         // Start signal plus frame, reads never overlap
+
+#if !CONFIG_HTTPD_WS_SUPPORT
+#error "Live sensor push needs CONFIG_HTTPD_WS_SUPPORT=y in sdkconfig"
+#endif
 
 static const char *TAG = "Webserver";
 
-// Global variables to store temperature and humidity
-static float temperature = 0.0;
-static float humidity = 0.0;
-
-// HTML content to serve
-const char *index_html = 
-"<!DOCTYPE html>"
-"<html>"
-"<head>"
-    "<meta charset=\"UTF-8\">"
-    "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">"
-    "<title>ESP32 Sensor Data</title>"
-    "<style>"
-        "body {"
-            "font-family: Arial, sans-serif;"
-            "background-color: #282c34;"
-            "color: #ffffff;"
-            "margin: 0;"
-            "padding: 20px;"
-            "display: flex;"
-            "justify-content: center;"
-            "align-items: center;"
-            "height: 100vh;"
-        "}"
-        ".container {"
-            "background-color: #3b3f46;"
-            "border-radius: 8px;"
-            "padding: 20px;"
-            "box-shadow: 0 4px 8px rgba(0, 0, 0, 0.1);"
-            "width: 100%;"
-            "max-width: 600px;"
-            "text-align: center;"
-        "}"
-        "h1 {"
-            "color: #61dafb;"
-        "}"
-        ".data {"
-            "font-size: 24px;"
-            "margin: 20px 0;"
-        "}"
-        ".data span {"
-            "display: block;"
-            "font-size: 18px;"
-            "color: #61dafb;"
-        "}"
-        ".footer {"
-            "margin-top: 20px;"
-            "font-size: 14px;"
-            "color: #888888;"
-        "}"
-        "@media (max-width: 600px) {"
-            "body {"
-                "padding: 10px;"
-            "}"
-            ".container {"
-                "padding: 10px;"
-            "}"
-        "}"
-    "</style>"
-    "<script>"
-        "async function fetchData() {"
-            "try {"
-                "let response = await fetch('/data');"
-                "let data = await response.json();"
-                "document.getElementById('temperature').innerText = `Temperature: ${data.temperature} °C`;"
-                "document.getElementById('humidity').innerText = `Humidity: ${data.humidity} %`;"
-            "} catch (error) {"
-                "console.error('Error fetching data:', error);"
-            "}"
-        "}"
-        "setInterval(fetchData, 2000); // Refresh every 2 seconds"
-        "window.onload = fetchData; // Initial fetch"
-    "</script>"
-"</head>"
-"<body>"
-    "<div class=\"container\">"
-        "<h1>ESP32 Sensor Data</h1>"
-        "<div id=\"temperature\" class=\"data\">Temperature: -- °C</div>"
-        "<div id=\"humidity\" class=\"data\">Humidity: -- %</div>"
-        "<div class=\"footer\">Real-time sensor data from ESP32</div>"
-    "</div>"
-"</body>"
-"</html>";
-
-// Wi-Fi event handler
-static void wifi_event_handler(void *event_handler_arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
-{
-    switch (event_id)
-    {
-    case WIFI_EVENT_STA_START:
-        printf("WiFi connecting ... \n");
-        break;
-    case WIFI_EVENT_STA_CONNECTED:
-        printf("WiFi connected ... \n");
-        break;
-    case WIFI_EVENT_STA_DISCONNECTED:
-        printf("WiFi lost connection ... \n");
-        break;
-    case IP_EVENT_STA_GOT_IP:
-        printf("WiFi got IP ... \n\n");
-        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        snprintf(ip_address, sizeof(ip_address), IPSTR, IP2STR(&event->ip_info.ip));
-        printf("IP Address: %s\n", ip_address);  // Print IP address to the serial monitor
-        break;
-    default:
-        break;
-    }
-}
-
-// Wi-Fi initialization
-void wifi_connection() {
-    nvs_flash_init();
-    esp_netif_init();
-    esp_event_loop_create_default();
-    esp_netif_create_default_wifi_sta();
-    wifi_init_config_t wifi_initiation = WIFI_INIT_CONFIG_DEFAULT();
-    esp_wifi_init(&wifi_initiation);
-    esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event_handler, NULL);
-    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL);
-    wifi_config_t wifi_configuration = {
-        .sta = {
-            .ssid = SSID,
-            .password = PASS
+static httpd_handle_t server = NULL;
+
+// Longest sample JSON, with every field at its widest
+#define SAMPLE_JSON_MAX 448
+#define SAMPLE_CBOR_MAX 80
+
+// Latest reading of one sensor, kept by dht11_task between reads. Values are
+// filtered by sensor_filter.c; window statistics are in hundredths.
+struct sensor_sample {
+    float temperature;
+    float humidity;
+    float dew_point;
+    float heat_index;
+    uint16_t window_samples;
+    sensor_window_stats_t temp_stats;
+    sensor_window_stats_t hum_stats;
+    uint32_t rejected;    // Readings dropped as outliers since boot
+    int64_t timestamp_us; // esp_timer time of the last good read, 0 before the first one
+    uint32_t seq;         // Number of good reads so far
+    int status;           // Result of the most recent read, ESP_OK on success
+};
+
+// What readers get of a sample: its JSON and CBOR encodings, so they send it
+// without formatting anything, the sequence number for `since` and the read
+// time for the age header
+struct sensor_encoded {
+    int64_t timestamp_us;
+    uint32_t seq;
+    uint16_t json_len;
+    uint8_t cbor_len;
+    char json[SAMPLE_JSON_MAX];
+    uint8_t cbor[SAMPLE_CBOR_MAX];
+};
+
+// Filter stage between acquisition and publication, one per sensor, used by dht11_task only
+static sensor_filter_t sensor_filters[DHT11_SENSOR_COUNT];
+
+// Single writer / multi reader snapshot. The writer fills the slot readers are not
+// using and then bumps `published`, so readers never wait on the writer; they only
+// retry if a publish lands while they are copying.
+// One snapshot per sensor, indexed like dht11_pins.
+static struct {
+    atomic_uint published;
+    struct sensor_encoded slots[2];
+} sensor_states[DHT11_SENSOR_COUNT];
+
+static void encode_sample(size_t sensor, const struct sensor_sample *sample, struct sensor_encoded *encoded);
+
+// Encode `sample` straight into the free slot and publish it. The slot stays
+// untouched until the publish after next, so the writer may keep using it.
+static const struct sensor_encoded *sensor_state_publish(size_t sensor, const struct sensor_sample *sample) {
+    unsigned next = atomic_load_explicit(&sensor_states[sensor].published, memory_order_relaxed) + 1;
+    struct sensor_encoded *slot = &sensor_states[sensor].slots[next & 1];
+    // Pairs with the readers' acquire fence: a reader that sees any of the stores
+    // below also sees its retry check fail
+    atomic_thread_fence(memory_order_release);
+    encode_sample(sensor, sample, slot);
+    atomic_store_explicit(&sensor_states[sensor].published, next, memory_order_release);
+    return slot;
+}
+
+// Copy the JSON (or CBOR) encoding of the latest sample into `buf` and return its
+// length. Only the encoded bytes are copied, not the whole slot. `seq` and
+// `timestamp_us` may be NULL.
+static size_t sensor_state_read(size_t sensor, bool cbor, char *buf, size_t size, uint32_t *seq,
+                                int64_t *timestamp_us) {
+    unsigned before, after;
+    size_t len;
+    do {
+        before = atomic_load_explicit(&sensor_states[sensor].published, memory_order_acquire);
+        const struct sensor_encoded *slot = &sensor_states[sensor].slots[before & 1];
+        len = cbor ? slot->cbor_len : slot->json_len;
+        // A length torn by a concurrent publish is retried below, only keep the copy in bounds
+        if (len > size) {
+            len = size;
+        }
+        memcpy(buf, cbor ? (const char *)slot->cbor : slot->json, len);
+        if (seq != NULL) {
+            *seq = slot->seq;
         }
+        if (timestamp_us != NULL) {
+            *timestamp_us = slot->timestamp_us;
+        }
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&sensor_states[sensor].published, memory_order_relaxed);
+    } while (after != before);
+    return len;
+}
+
+// JSON body shared by /data, /sensors and the WebSocket push, encoded once per
+// published sample. The keys are constant, only the values are rendered, in
+// fixed point rather than with %f. The sample time is absolute (ms since boot)
+// so the cached body stays valid until the next sample.
+enum {
+    SAMPLE_SLOT_SENSOR,
+    SAMPLE_SLOT_SEQ,
+    SAMPLE_SLOT_TEMPERATURE,
+    SAMPLE_SLOT_HUMIDITY,
+    SAMPLE_SLOT_DEW_POINT,
+    SAMPLE_SLOT_HEAT_INDEX,
+    SAMPLE_SLOT_WINDOW_SAMPLES,
+    SAMPLE_SLOT_TEMP_MIN,
+    SAMPLE_SLOT_TEMP_MAX,
+    SAMPLE_SLOT_TEMP_MEAN,
+    SAMPLE_SLOT_TEMP_STDDEV,
+    SAMPLE_SLOT_HUM_MIN,
+    SAMPLE_SLOT_HUM_MAX,
+    SAMPLE_SLOT_HUM_MEAN,
+    SAMPLE_SLOT_HUM_STDDEV,
+    SAMPLE_SLOT_REJECTED,
+    SAMPLE_SLOT_TIME,
+    SAMPLE_SLOT_STATUS,
+};
+
+static const resp_template_piece_t sample_json[] = {
+    RESP_PIECE("{\"sensor\": ", SAMPLE_SLOT_SENSOR),
+    RESP_PIECE(", \"seq\": ", SAMPLE_SLOT_SEQ),
+    RESP_PIECE(", \"temperature\": ", SAMPLE_SLOT_TEMPERATURE),
+    RESP_PIECE(", \"humidity\": ", SAMPLE_SLOT_HUMIDITY),
+    RESP_PIECE(", \"dew_point\": ", SAMPLE_SLOT_DEW_POINT),
+    RESP_PIECE(", \"heat_index\": ", SAMPLE_SLOT_HEAT_INDEX),
+    RESP_PIECE(", \"window\": {\"samples\": ", SAMPLE_SLOT_WINDOW_SAMPLES),
+    RESP_PIECE(", \"temperature\": {\"min\": ", SAMPLE_SLOT_TEMP_MIN),
+    RESP_PIECE(", \"max\": ", SAMPLE_SLOT_TEMP_MAX),
+    RESP_PIECE(", \"mean\": ", SAMPLE_SLOT_TEMP_MEAN),
+    RESP_PIECE(", \"stddev\": ", SAMPLE_SLOT_TEMP_STDDEV),
+    RESP_PIECE("}, \"humidity\": {\"min\": ", SAMPLE_SLOT_HUM_MIN),
+    RESP_PIECE(", \"max\": ", SAMPLE_SLOT_HUM_MAX),
+    RESP_PIECE(", \"mean\": ", SAMPLE_SLOT_HUM_MEAN),
+    RESP_PIECE(", \"stddev\": ", SAMPLE_SLOT_HUM_STDDEV),
+    RESP_PIECE("}}, \"rejected\": ", SAMPLE_SLOT_REJECTED),
+    RESP_PIECE(", \"time_ms\": ", SAMPLE_SLOT_TIME),
+    RESP_PIECE(", \"status\": \"", SAMPLE_SLOT_STATUS),
+    RESP_PIECE("\"}", RESP_TEMPLATE_NO_SLOT),
+    RESP_TEMPLATE_END,
+};
+
+struct sample_json_ctx {
+    size_t sensor;
+    const struct sensor_sample *sample;
+};
+
+static size_t render_sample_slot(int slot, char *buf, const void *arg) {
+    const struct sample_json_ctx *ctx = arg;
+    switch (slot) {
+    case SAMPLE_SLOT_SENSOR:
+        return resp_template_uint(buf, ctx->sensor);
+    case SAMPLE_SLOT_SEQ:
+        return resp_template_uint(buf, ctx->sample->seq);
+    case SAMPLE_SLOT_TEMPERATURE:
+        return resp_template_fixed(buf, lroundf(ctx->sample->temperature * 100), 2);
+    case SAMPLE_SLOT_HUMIDITY:
+        return resp_template_fixed(buf, lroundf(ctx->sample->humidity * 100), 2);
+    case SAMPLE_SLOT_DEW_POINT:
+        return resp_template_fixed(buf, lroundf(ctx->sample->dew_point * 100), 2);
+    case SAMPLE_SLOT_HEAT_INDEX:
+        return resp_template_fixed(buf, lroundf(ctx->sample->heat_index * 100), 2);
+    case SAMPLE_SLOT_WINDOW_SAMPLES:
+        return resp_template_uint(buf, ctx->sample->window_samples);
+    case SAMPLE_SLOT_TEMP_MIN:
+        return resp_template_fixed(buf, ctx->sample->temp_stats.min, 2);
+    case SAMPLE_SLOT_TEMP_MAX:
+        return resp_template_fixed(buf, ctx->sample->temp_stats.max, 2);
+    case SAMPLE_SLOT_TEMP_MEAN:
+        return resp_template_fixed(buf, ctx->sample->temp_stats.mean, 2);
+    case SAMPLE_SLOT_TEMP_STDDEV:
+        return resp_template_fixed(buf, ctx->sample->temp_stats.stddev, 2);
+    case SAMPLE_SLOT_HUM_MIN:
+        return resp_template_fixed(buf, ctx->sample->hum_stats.min, 2);
+    case SAMPLE_SLOT_HUM_MAX:
+        return resp_template_fixed(buf, ctx->sample->hum_stats.max, 2);
+    case SAMPLE_SLOT_HUM_MEAN:
+        return resp_template_fixed(buf, ctx->sample->hum_stats.mean, 2);
+    case SAMPLE_SLOT_HUM_STDDEV:
+        return resp_template_fixed(buf, ctx->sample->hum_stats.stddev, 2);
+    case SAMPLE_SLOT_REJECTED:
+        return resp_template_uint(buf, ctx->sample->rejected);
+    case SAMPLE_SLOT_TIME:
+        return resp_template_uint(buf, ctx->sample->timestamp_us / 1000);
+    default: {
+        const char *status = ctx->sample->status == 0 ? "ok" : "error";
+        size_t len = strlen(status);
+        memcpy(buf, status, len);
+        return len;
+    }
+    }
+}
+
+static void encode_sample_json(size_t sensor, const struct sensor_sample *sample, struct sensor_encoded *encoded) {
+    const struct sample_json_ctx ctx = {sensor, sample};
+    encoded->json_len = resp_template_render(sample_json, render_sample_slot, &ctx,
+                                             encoded->json, sizeof(encoded->json));
+}
+
+static void put_window_stats_cbor(cbor_writer_t *writer, const sensor_window_stats_t *stats) {
+    cbor_put_array(writer, 4);
+    cbor_put_int(writer, stats->min);
+    cbor_put_int(writer, stats->max);
+    cbor_put_int(writer, stats->mean);
+    cbor_put_uint(writer, stats->stddev);
+}
+
+// CBOR record for machine clients: one array with a fixed field order and no keys,
+// values in hundredths as integers. The layout is documented in the README.
+static void encode_sample_cbor(size_t sensor, const struct sensor_sample *sample, struct sensor_encoded *encoded) {
+    cbor_writer_t writer;
+    cbor_writer_init(&writer, encoded->cbor, sizeof(encoded->cbor));
+    cbor_put_array(&writer, 12);
+    cbor_put_uint(&writer, sensor);
+    cbor_put_uint(&writer, sample->seq);
+    cbor_put_uint(&writer, sample->timestamp_us / 1000);
+    cbor_put_int(&writer, sample->status);
+    cbor_put_int(&writer, lroundf(sample->temperature * 100));
+    cbor_put_int(&writer, lroundf(sample->humidity * 100));
+    cbor_put_int(&writer, lroundf(sample->dew_point * 100));
+    cbor_put_int(&writer, lroundf(sample->heat_index * 100));
+    cbor_put_uint(&writer, sample->rejected);
+    cbor_put_uint(&writer, sample->window_samples);
+    put_window_stats_cbor(&writer, &sample->temp_stats);
+    put_window_stats_cbor(&writer, &sample->hum_stats);
+    encoded->cbor_len = cbor_writer_ok(&writer) ? writer.len : 0;
+}
+
+static void encode_sample(size_t sensor, const struct sensor_sample *sample, struct sensor_encoded *encoded) {
+    encoded->timestamp_us = sample->timestamp_us;
+    encoded->seq = sample->seq;
+    encode_sample_json(sensor, sample, encoded);
+    encode_sample_cbor(sensor, sample, encoded);
+}
+
+// Set to 1 to log, at boot, the size and encode time of a sample as JSON and
+// as CBOR, against the %f snprintf path the template replaced, and the cost of
+// reading the cached encodings as /data does. Build
+// for the Linux target to run it on the host. Handler latency shows in the
+// /data histogram of /metrics.
+#define SAMPLE_ENCODER_BENCH 0
+
+#if SAMPLE_ENCODER_BENCH
+static void sample_encoder_bench(void) {
+    const int rounds = 1000;
+    struct sensor_sample sample = {
+        .temperature = 23.4f, .humidity = 56.7f, .dew_point = 14.31f, .heat_index = 23.32f,
+        .window_samples = 30, .temp_stats = {2310, 2360, 2338, 14}, .hum_stats = {5500, 5800, 5671, 92},
+        .timestamp_us = 123456789, .seq = 42,
     };
-    esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_configuration);
-    esp_wifi_start();
-    esp_wifi_connect();
+    struct sensor_encoded encoded;
+    char body[SAMPLE_JSON_MAX];
+    volatile int sink = 0;
+
+    // Same body as sample_json, formatted the way /data did before the template
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < rounds; i++) {
+        sink += snprintf(body, sizeof(body),
+                         "{\"sensor\": %u, \"seq\": %lu, \"temperature\": %.2f, \"humidity\": %.2f, "
+                         "\"dew_point\": %.2f, \"heat_index\": %.2f, \"window\": {\"samples\": %u, "
+                         "\"temperature\": {\"min\": %.2f, \"max\": %.2f, \"mean\": %.2f, \"stddev\": %.2f}, "
+                         "\"humidity\": {\"min\": %.2f, \"max\": %.2f, \"mean\": %.2f, \"stddev\": %.2f}}, "
+                         "\"rejected\": %lu, \"time_ms\": %llu, \"status\": \"%s\"}",
+                         0u, (unsigned long)sample.seq, sample.temperature, sample.humidity,
+                         sample.dew_point, sample.heat_index, (unsigned)sample.window_samples,
+                         sample.temp_stats.min / 100.0, sample.temp_stats.max / 100.0,
+                         sample.temp_stats.mean / 100.0, sample.temp_stats.stddev / 100.0,
+                         sample.hum_stats.min / 100.0, sample.hum_stats.max / 100.0,
+                         sample.hum_stats.mean / 100.0, sample.hum_stats.stddev / 100.0,
+                         (unsigned long)sample.rejected, (unsigned long long)(sample.timestamp_us / 1000), "ok");
+    }
+    int64_t printf_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < rounds; i++) {
+        encode_sample_json(0, &sample, &encoded);
+        sink += encoded.json_len;
+    }
+    int64_t json_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < rounds; i++) {
+        encode_sample_cbor(0, &sample, &encoded);
+        sink += encoded.cbor_len;
+    }
+    int64_t cbor_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < rounds; i++) {
+        sink += sensor_state_read(0, false, body, sizeof(body), NULL, NULL);
+    }
+    int64_t cached_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "Sample JSON: %u bytes, snprintf %lld ns, template %lld ns; CBOR: %u bytes, %lld ns; "
+             "cached read %lld ns",
+             (unsigned)encoded.json_len, (long long)(printf_us * 1000 / rounds), (long long)(json_us * 1000 / rounds),
+             (unsigned)encoded.cbor_len, (long long)(cbor_us * 1000 / rounds),
+             (long long)(cached_us * 1000 / rounds));
+}
+#endif
+
+static void sensor_state_init(void) {
+    const sensor_filter_config_t filter_config = SENSOR_FILTER_DEFAULT_CONFIG();
+    for (size_t i = 0; i < DHT11_SENSOR_COUNT; i++) {
+        struct sensor_sample sample = {0};
+        sensor_filter_init(&sensor_filters[i], &filter_config);
+        sensor_state_publish(i, &sample);
+    }
+}
+
+// Instrumentation exported at /metrics
+static metrics_histogram_t index_latency = METRICS_HISTOGRAM("http_request_duration_seconds", "route=\"/\"");
+static metrics_histogram_t data_latency = METRICS_HISTOGRAM("http_request_duration_seconds", "route=\"/data\"");
+static metrics_histogram_t post_latency = METRICS_HISTOGRAM("http_request_duration_seconds", "route=\"POST /ws\"");
+static metrics_histogram_t post_queue_latency = METRICS_HISTOGRAM("httpd_queue_work_wait_seconds", "work=\"post_reply\"");
+static metrics_histogram_t ws_queue_latency = METRICS_HISTOGRAM("httpd_queue_work_wait_seconds", "work=\"ws_broadcast\"");
+static metrics_counter_t dht11_reads_ok = METRICS_COUNTER("dht11_reads_total", "result=\"ok\"");
+static metrics_counter_t dht11_reads_timeout = METRICS_COUNTER("dht11_reads_total", "result=\"timeout\"");
+static metrics_counter_t dht11_reads_error = METRICS_COUNTER("dht11_reads_total", "result=\"error\"");
+static metrics_counter_t dht11_reads_rejected = METRICS_COUNTER("dht11_reads_total", "result=\"rejected\"");
+
+static TaskHandle_t dht11_task_handle;
+static TaskHandle_t storage_task_handle;
+static metrics_counter_t storage_dropped = METRICS_COUNTER("storage_dropped_total", NULL);
+static atomic_uint ws_broadcast_queued_us; // Low 32 bits of esp_timer time, differences stay valid
+
+static uint32_t dht11_task_stack_free(void) {
+    return dht11_task_handle ? uxTaskGetStackHighWaterMark(dht11_task_handle) : 0;
+}
+
+static uint32_t storage_task_stack_free(void) {
+    return storage_task_handle ? uxTaskGetStackHighWaterMark(storage_task_handle) : 0;
+}
+
+// /metrics runs on the httpd task, so the current task is the one to measure
+static uint32_t httpd_task_stack_free(void) {
+    return uxTaskGetStackHighWaterMark(NULL);
+}
+
+static uint32_t http_open_sessions(void) {
+    server_tuning_stats_t stats;
+    server_tuning_get_stats(&stats);
+    return stats.open_sessions;
+}
+
+static uint32_t http_rejected_sessions(void) {
+    server_tuning_stats_t stats;
+    server_tuning_get_stats(&stats);
+    return stats.rejected;
+}
+
+static uint32_t wifi_first_request_ms(void) {
+    wifi_station_stats_t stats;
+    wifi_station_get_stats(&stats);
+    return stats.boot_to_first_request_ms < 0 ? 0 : stats.boot_to_first_request_ms;
+}
+
+static void init_metrics(void) {
+    metrics_init();
+    metrics_register_histogram(&index_latency, "Time spent in the request handler");
+    metrics_register_histogram(&data_latency, "Time spent in the request handler");
+    metrics_register_histogram(&post_latency, "Time spent in the request handler");
+    metrics_register_histogram(&post_queue_latency, "Delay from httpd_queue_work to the work running");
+    metrics_register_histogram(&ws_queue_latency, "Delay from httpd_queue_work to the work running");
+    metrics_register_counter(&dht11_reads_ok, "DHT11 reads by outcome");
+    metrics_register_counter(&dht11_reads_timeout, "DHT11 reads by outcome");
+    metrics_register_counter(&dht11_reads_error, "DHT11 reads by outcome");
+    metrics_register_counter(&dht11_reads_rejected, "DHT11 reads by outcome");
+    metrics_register_gauge("task_stack_free_min_bytes", "task=\"dht11_task\"", "Stack high-water mark", dht11_task_stack_free);
+    metrics_register_gauge("task_stack_free_min_bytes", "task=\"httpd\"", "Stack high-water mark", httpd_task_stack_free);
+    metrics_register_gauge("task_stack_free_min_bytes", "task=\"storage_task\"", "Stack high-water mark", storage_task_stack_free);
+    metrics_register_counter(&storage_dropped, "Readings not stored because the storage queue was full");
+    metrics_register_gauge("http_open_sessions", NULL, "Open client connections", http_open_sessions);
+    metrics_register_counter_fn("http_rejected_sessions_total", NULL, "Connections refused with 503", http_rejected_sessions);
+    mqtt_publisher_register_metrics();
+    metrics_register_gauge("wifi_first_request_ms", NULL, "Boot to first served request, 0 until then", wifi_first_request_ms);
 }
 
 // Asynchronous response data structures and handlers
 struct async_resp_arg {
     httpd_handle_t hd;
     int fd;
+    int64_t queued_us;
 };
 
-static void generate_async_resp_post(void *arg) {
-    char http_string[250];
-    char *data_string = "POST response from ESP32 websocket server...";
-    snprintf(http_string, sizeof(http_string), "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", strlen(data_string));
+// Preallocated response contexts, so a burst of POSTs never touches the heap.
+// A set bit in async_resp_free marks a free slot.
+#define ASYNC_RESP_POOL_SIZE 8
+
+static struct async_resp_arg async_resp_pool[ASYNC_RESP_POOL_SIZE];
+static atomic_uint async_resp_free = (1u << ASYNC_RESP_POOL_SIZE) - 1;
 
+static struct async_resp_arg *async_resp_alloc(void) {
+    unsigned free_mask = atomic_load(&async_resp_free);
+    while (free_mask) {
+        unsigned slot = __builtin_ctz(free_mask);
+        if (atomic_compare_exchange_weak(&async_resp_free, &free_mask, free_mask & ~(1u << slot))) {
+            return &async_resp_pool[slot];
+        }
+    }
+    return NULL;
+}
+
+static void async_resp_release(struct async_resp_arg *resp_arg) {
+    atomic_fetch_or(&async_resp_free, 1u << (resp_arg - async_resp_pool));
+}
+
+// The POST reply never changes, so header and body are built once and sent in one call
+#define POST_RESP_BODY "POST response from ESP32 websocket server..."
+
+static char post_response[128];
+static size_t post_response_len;
+
+static void init_post_response(void) {
+    post_response_len = snprintf(post_response, sizeof(post_response),
+                                 "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n\r\n%s",
+                                 (unsigned)strlen(POST_RESP_BODY), POST_RESP_BODY);
+}
+
+static void generate_async_resp_post(void *arg) {
     struct async_resp_arg *resp_arg = (struct async_resp_arg *)arg;
     httpd_handle_t hd = resp_arg->hd;
     int fd = resp_arg->fd;
+    metrics_observe_since(&post_queue_latency, resp_arg->queued_us);
+    async_resp_release(resp_arg);
 
     ESP_LOGI(TAG, "Executing queued work POST fd : %d", fd);
-    httpd_socket_send(hd, fd, http_string, strlen(http_string), 0);
-    httpd_socket_send(hd, fd, data_string, strlen(data_string), 0);
-
-    free(arg);
-}
-
-static esp_err_t async_get_handler(httpd_req_t *req) {
-    if (strcmp(req->uri, "/") == 0) {
-        // Serve HTML page
-        httpd_resp_set_type(req, "text/html");
-        httpd_resp_send(req, index_html, strlen(index_html));
-    } else if (strcmp(req->uri, "/data") == 0) {
-        // Serve JSON data
-        char data_string[100];
-        snprintf(data_string, sizeof(data_string), "{\"temperature\": %.2f, \"humidity\": %.2f}", temperature, humidity);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, data_string, strlen(data_string));
-    } else {
-        httpd_resp_send_404(req);
+    httpd_socket_send(hd, fd, post_response, post_response_len, 0);
+}
+
+// Serve a precompressed page with a strong ETag per encoding, a matching If-None-Match gets a bodyless 304
+static esp_err_t send_page(httpd_req_t *req, const char *type, const char *etag, const char *etag_gz,
+                           const char *page, size_t page_len, const uint8_t *page_gz, size_t page_gz_len) {
+    char header[64];
+    bool gzip = httpd_req_get_hdr_value_str(req, "Accept-Encoding", header, sizeof(header)) == ESP_OK &&
+                strstr(header, "gzip") != NULL;
+
+    // Each coding is its own representation, so it gets its own strong ETag
+    if (gzip) {
+        etag = etag_gz;
+    }
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", header, sizeof(header)) == ESP_OK &&
+        strstr(header, etag) != NULL) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, type);
+    if (gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        return httpd_resp_send(req, (const char *)page_gz, page_gz_len);
+    }
+    return httpd_resp_send(req, page, page_len);
+}
+
+// Web assets flashed separately from the firmware, empty if none are
+static asset_bundle_t assets;
+
+// Serve the HTML page: /index.html from the asset bundle if it has one, else the
+// copy built into the firmware (generated from index.html by tools/gzip_asset.py)
+static esp_err_t index_get_handler(httpd_req_t *req) {
+    asset_t asset;
+
+    wifi_station_note_request();
+    if (asset_bundle_find(&assets, "/index.html", strlen("/index.html"), &asset)) {
+        return asset_send(req, &asset);
+    }
+    return send_page(req, "text/html", INDEX_HTML_ETAG, INDEX_HTML_ETAG_GZ,
+                     index_html, sizeof(index_html) - 1, index_html_gz, sizeof(index_html_gz));
+}
+
+// Any other GET is looked up in the asset bundle
+static esp_err_t asset_get_handler(httpd_req_t *req) {
+    asset_t asset;
+
+    wifi_station_note_request();
+    if (!asset_bundle_find(req->user_ctx, req->uri, strcspn(req->uri, "?"), &asset)) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, NULL);
+    }
+    return asset_send(req, &asset);
+}
+
+// Content negotiation for /data, /sensors and /history: machine clients sending
+// Accept: application/cbor get the CBOR encoding, everyone else JSON
+static bool accepts_cbor(httpd_req_t *req) {
+    char accept[96];
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept));
+
+    httpd_resp_set_hdr(req, "Vary", "Accept");
+    if ((err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC) && strstr(accept, "application/cbor") != NULL) {
+        httpd_resp_set_type(req, "application/cbor");
+        return true;
+    }
+    return false;
+}
+
+// Serve sensor `sensor` (default 0), or 204 when the client already has sample `since`.
+// The cached body carries the absolute read time; its age goes in a header
+// computed at send time, -1 before the first good read.
+static esp_err_t data_get_handler(httpd_req_t *req) {
+    char body[SAMPLE_JSON_MAX];
+    char age[24];
+    uint32_t seq;
+    int64_t timestamp_us;
+    char query[48];
+    char value[12];
+    unsigned long sensor = 0;
+
+    wifi_station_note_request();
+    bool has_query = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK;
+    if (has_query && httpd_query_key_value(query, "sensor", value, sizeof(value)) == ESP_OK) {
+        char *end;
+        sensor = strtoul(value, &end, 10);
+        if (end == value || *end != '\0' || sensor >= DHT11_SENSOR_COUNT) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No such sensor");
+        }
     }
+    size_t len = sensor_state_read(sensor, accepts_cbor(req), body, sizeof(body), &seq, &timestamp_us);
+    long long age_ms = timestamp_us ? (esp_timer_get_time() - timestamp_us) / 1000 : -1;
+    snprintf(age, sizeof(age), "%lld", age_ms);
+    httpd_resp_set_hdr(req, "X-Sample-Age-Ms", age);
+    if (has_query && httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK &&
+        strtoul(value, NULL, 10) >= seq) {
+        httpd_resp_set_status(req, HTTPD_204);
+        return httpd_resp_send(req, NULL, 0);
+    }
+    return httpd_resp_send(req, body, len);
+}
+
+// WebSocket endpoint: the handshake subscribes the socket to pushed readings
+static esp_err_t ws_handler(httpd_req_t *req) {
+    if (req->method == HTTP_GET) {
+        ESP_LOGI(TAG, "WebSocket client subscribed fd : %d", httpd_req_to_sockfd(req));
+        return ESP_OK;
+    }
+
+    // Clients only listen, drain whatever they send
+    uint8_t payload[32];
+    httpd_ws_frame_t frame = {0};
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (frame.len > sizeof(payload)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    frame.payload = payload;
+    return httpd_ws_recv_frame(req, &frame, frame.len);
+}
+
+// Queued on the httpd task for every new reading: send the encoded sample to all subscribers
+static void ws_broadcast_reading(void *arg) {
+    char json[SAMPLE_JSON_MAX];
+    int fds[SERVER_MAX_SOCKETS];
+    size_t client_count = sizeof(fds) / sizeof(fds[0]);
+
+    metrics_observe(&ws_queue_latency, (uint32_t)esp_timer_get_time() - atomic_load(&ws_broadcast_queued_us));
+    size_t len = sensor_state_read(0, false, json, sizeof(json), NULL, NULL);
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)json,
+        .len = len,
+    };
+
+    if (httpd_get_client_list(server, &client_count, fds) != ESP_OK) {
+        return;
+    }
+    for (size_t i = 0; i < client_count; i++) {
+        if (httpd_ws_get_fd_info(server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+            httpd_ws_send_frame_async(server, fds[i], &frame);
+        }
+    }
+}
+
+static esp_err_t print_body_chunk(const char *data, size_t len, void *ctx) {
+    printf("%.*s", (int)len, data);
     return ESP_OK;
 }
 
 static esp_err_t async_post_handler(httpd_req_t *req) {
-    char content[100];
-    size_t recv_size = MIN(req->content_len, sizeof(content));
-    httpd_req_recv(req, content, recv_size);
-    printf("Data sent by the client: %.*s\n", recv_size, content);
+    wifi_station_note_request();
+    // Echo the body to the console as it arrives, whatever its size
+    printf("Data sent by the client: ");
+    esp_err_t err = body_recv_chunks(req, print_body_chunk, NULL);
+    printf("\n");
+    if (err != ESP_OK) {
+        return ESP_FAIL;
+    }
 
-    struct async_resp_arg *resp_arg = malloc(sizeof(struct async_resp_arg));
+    // Shed load once every response context is in flight
+    struct async_resp_arg *resp_arg = async_resp_alloc();
+    if (resp_arg == NULL) {
+        ESP_LOGW(TAG, "Response pool exhausted, rejecting POST");
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        return httpd_resp_send(req, NULL, 0);
+    }
     resp_arg->hd = req->handle;
     resp_arg->fd = httpd_req_to_sockfd(req);
+    resp_arg->queued_us = esp_timer_get_time();
     ESP_LOGI(TAG, "Queuing work POST fd : %d", resp_arg->fd);
-    httpd_queue_work(req->handle, generate_async_resp_post, resp_arg);
+    if (httpd_queue_work(req->handle, generate_async_resp_post, resp_arg) != ESP_OK) {
+        async_resp_release(resp_arg);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, NULL, 0);
+    }
     return ESP_OK;
 }
 
-// URI handler structures
-static const httpd_uri_t uri_get = {
-    .uri = "/",
-    .method = HTTP_GET,
-    .handler = async_get_handler,
-    .user_ctx = NULL,
-};
+// Print hundredths as a fixed-point decimal, 0 if it does not fit
+static size_t format_centi(char *buf, size_t size, int16_t centi) {
+    int value = centi < 0 ? -centi : centi;
+    int len = snprintf(buf, size, "%s%d.%02d", centi < 0 ? "-" : "", value / 100, value % 100);
+    if (len < 0 || (size_t)len >= size) {
+        return 0;
+    }
+    return len;
+}
 
-static const httpd_uri_t uri_data_get = {
-    .uri = "/data",
-    .method = HTTP_GET,
-    .handler = async_get_handler,
-    .user_ctx = NULL,
-};
+// JSON array of one point, 0 if it does not fit
+static size_t format_history_point(char *buf, size_t size, const history_point_t *point, history_res_t res) {
+    const int16_t raw_fields[] = {point->temp_mean, point->hum_mean};
+    const int16_t aggregate_fields[] = {point->temp_min, point->temp_max, point->temp_mean,
+                                        point->hum_min, point->hum_max, point->hum_mean};
+    const int16_t *fields = res == HISTORY_RES_RAW ? raw_fields : aggregate_fields;
+    size_t field_count = res == HISTORY_RES_RAW ? 2 : 6;
+
+    int first = snprintf(buf, size, "[%lu", (unsigned long)point->time_s);
+    if (first < 0 || (size_t)first >= size) {
+        return 0;
+    }
+    size_t len = first;
+    for (size_t i = 0; i < field_count; i++) {
+        if (size - len < 3) {
+            return 0;
+        }
+        buf[len++] = ',';
+        buf[len++] = ' ';
+        size_t field_len = format_centi(buf + len, size - len, fields[i]);
+        if (field_len == 0) {
+            return 0;
+        }
+        len += field_len;
+    }
+    if (size - len < 2) {
+        return 0;
+    }
+    buf[len++] = ']';
+    buf[len] = '\0';
+    return len;
+}
+
+// Same point as a CBOR array of integers: [time_s, temp_mean, hum_mean] for raw points,
+// [time_s, temp_min, temp_max, temp_mean, hum_min, hum_max, hum_mean] otherwise
+static void put_history_point_cbor(cbor_writer_t *writer, const history_point_t *point, history_res_t res) {
+    if (res == HISTORY_RES_RAW) {
+        cbor_put_array(writer, 3);
+        cbor_put_uint(writer, point->time_s);
+        cbor_put_int(writer, point->temp_mean);
+        cbor_put_int(writer, point->hum_mean);
+        return;
+    }
+    cbor_put_array(writer, 7);
+    cbor_put_uint(writer, point->time_s);
+    cbor_put_int(writer, point->temp_min);
+    cbor_put_int(writer, point->temp_max);
+    cbor_put_int(writer, point->temp_mean);
+    cbor_put_int(writer, point->hum_min);
+    cbor_put_int(writer, point->hum_max);
+    cbor_put_int(writer, point->hum_mean);
+}
+
+// GET /history?from=&to=&res=raw|min|hour, times in seconds since boot.
+// With Accept: application/cbor the reply is [now, res, [_ points...]].
+// Points are streamed in chunks so any range fits in a small stack buffer.
+static esp_err_t history_get_handler(httpd_req_t *req) {
+    static const char *res_names[HISTORY_RES_COUNT] = {"raw", "min", "hour"};
+    char query[64];
+    char param[12];
+    uint32_t now_s = esp_timer_get_time() / 1000000;
+    uint32_t from_s = 0;
+    uint32_t to_s = now_s;
+    history_res_t res = HISTORY_RES_RAW;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "from", param, sizeof(param)) == ESP_OK) {
+            from_s = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(query, "to", param, sizeof(param)) == ESP_OK) {
+            to_s = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(query, "res", param, sizeof(param)) == ESP_OK) {
+            for (res = 0; res < HISTORY_RES_COUNT && strcmp(param, res_names[res]) != 0; res++) {
+            }
+            if (res == HISTORY_RES_COUNT) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "res must be raw, min or hour");
+                return ESP_OK;
+            }
+        }
+    }
+
+    // Leave room in the chunk for one more point plus the closing brackets
+    char chunk[512];
+    const size_t point_max = 96;
+    history_point_t points[16];
+    size_t count;
+    bool first = true;
+    bool cbor = accepts_cbor(req);
+    cbor_writer_t writer;
+    size_t len;
+
+    // The CBOR writer works in place on `chunk`, its length tracks `len`
+    cbor_writer_init(&writer, (uint8_t *)chunk, sizeof(chunk));
+    if (cbor) {
+        cbor_put_array(&writer, 3);
+        cbor_put_uint(&writer, now_s);
+        cbor_put_text(&writer, res_names[res], strlen(res_names[res]));
+        cbor_put_array_start(&writer);
+        len = writer.len;
+    } else {
+        int head = snprintf(chunk, sizeof(chunk), "{\"now\": %lu, \"res\": \"%s\", \"points\": [",
+                            (unsigned long)now_s, res_names[res]);
+        if (head < 0 || (size_t)head >= sizeof(chunk)) {
+            return ESP_FAIL;
+        }
+        len = head;
+    }
+
+    do {
+        count = history_query(res, from_s, to_s, points, sizeof(points) / sizeof(points[0]));
+        for (size_t i = 0; i < count; i++) {
+            if (len > sizeof(chunk) - point_max) {
+                if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK) {
+                    return ESP_FAIL;
+                }
+                len = 0;
+            }
+            if (cbor) {
+                writer.len = len;
+                put_history_point_cbor(&writer, &points[i], res);
+                len = writer.len;
+            } else {
+                if (!first) {
+                    chunk[len++] = ',';
+                }
+                size_t point_len = format_history_point(chunk + len, sizeof(chunk) - len, &points[i], res);
+                if (point_len == 0) {
+                    // point_max is too small for this point; end the reply rather than send it cut
+                    return ESP_FAIL;
+                }
+                len += point_len;
+            }
+            first = false;
+        }
+        if (count > 0) {
+            from_s = points[count - 1].time_s + 1;
+        }
+    } while (count == sizeof(points) / sizeof(points[0]));
+
+    if (cbor) {
+        writer.len = len;
+        cbor_put_break(&writer);
+        len = writer.len;
+    } else {
+        chunk[len++] = ']';
+        chunk[len++] = '}';
+    }
+    httpd_resp_send_chunk(req, chunk, len);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
 
-static const httpd_uri_t uri_post = {
-    .uri = "/ws",
-    .method = HTTP_POST,
-    .handler = async_post_handler,
-    .user_ctx = NULL,
+// GET /log: export the flash log as CSV, oldest first, one chunk at a time
+static esp_err_t log_get_handler(httpd_req_t *req) {
+    sensor_log_reader_t reader;
+    sensor_log_record_t record;
+    char chunk[512];
+    const size_t line_max = 60;
+    static const char header[] = "boot,time_s,temperature,humidity\n";
+    size_t len = sizeof(header) - 1;
+
+    memcpy(chunk, header, len);
+    sensor_log_reader_init(&reader);
+    while (sensor_log_read_next(&reader, &record)) {
+        if (len > sizeof(chunk) - line_max) {
+            if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            len = 0;
+        }
+        // line_max leaves room for the widest line, so these only fail if it is set too small
+        int ids = snprintf(chunk + len, sizeof(chunk) - len, "%lu,%lu,",
+                           (unsigned long)record.boot, (unsigned long)record.time_s);
+        if (ids < 0 || (size_t)ids >= sizeof(chunk) - len) {
+            return ESP_FAIL;
+        }
+        len += ids;
+        size_t temperature_len = format_centi(chunk + len, sizeof(chunk) - len - 1, record.temperature);
+        if (temperature_len == 0) {
+            return ESP_FAIL;
+        }
+        len += temperature_len;
+        chunk[len++] = ',';
+        size_t humidity_len = format_centi(chunk + len, sizeof(chunk) - len - 1, record.humidity);
+        if (humidity_len == 0) {
+            return ESP_FAIL;
+        }
+        len += humidity_len;
+        chunk[len++] = '\n';
+    }
+    httpd_resp_send_chunk(req, chunk, len);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// GET /sensors: latest reading of every sensor as a JSON or CBOR array, one chunk
+// per few sensors so the reply size does not depend on the sensor count
+static esp_err_t sensors_get_handler(httpd_req_t *req) {
+    char chunk[512];
+    size_t len = 0;
+    bool cbor = accepts_cbor(req);
+
+    if (cbor) {
+        cbor_writer_t writer;
+        cbor_writer_init(&writer, (uint8_t *)chunk, sizeof(chunk));
+        cbor_put_array(&writer, DHT11_SENSOR_COUNT);
+        len = writer.len;
+    } else {
+        chunk[len++] = '[';
+    }
+
+    // Each sample is read straight into the chunk, with room for its widest encoding
+    size_t body_max = cbor ? SAMPLE_CBOR_MAX : SAMPLE_JSON_MAX;
+    for (size_t i = 0; i < DHT11_SENSOR_COUNT; i++) {
+        if (sizeof(chunk) - len < body_max + 2) {
+            if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            len = 0;
+        }
+        if (i > 0 && !cbor) {
+            chunk[len++] = ',';
+        }
+        len += sensor_state_read(i, cbor, chunk + len, body_max, NULL, NULL);
+    }
+    if (!cbor) {
+        chunk[len++] = ']';
+    }
+    httpd_resp_send_chunk(req, chunk, len);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Timed routes go through metrics_timed_handler
+static const metrics_route_t route_index = {index_get_handler, &index_latency};
+static const metrics_route_t route_data = {data_get_handler, &data_latency};
+static const metrics_route_t route_post = {async_post_handler, &post_latency};
+
+// Route table. Its perfect hash lives in routes_hash.h, rerun tools/route_hash.py after editing it.
+static const router_route_t routes[] = {
+    {
+        .path = "/",
+        .method = HTTP_GET,
+        .handler = metrics_timed_handler,
+        .user_ctx = (void *)&route_index,
+    },
+    {
+        .path = "/data",
+        .method = HTTP_GET,
+        .content_type = "application/json",
+        .handler = metrics_timed_handler,
+        .user_ctx = (void *)&route_data,
+    },
+    {
+        .path = "/sensors",
+        .method = HTTP_GET,
+        .content_type = "application/json",
+        .handler = sensors_get_handler,
+    },
+    {
+        .path = "/history",
+        .method = HTTP_GET,
+        .content_type = "application/json",
+        .handler = history_get_handler,
+    },
+    {
+        .path = "/log",
+        .method = HTTP_GET,
+        .content_type = "text/csv",
+        .handler = log_get_handler,
+    },
+    {
+        .path = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .websocket = true,
+    },
+    {
+        .path = "/ws",
+        .method = HTTP_POST,
+        .handler = metrics_timed_handler,
+        .user_ctx = (void *)&route_post,
+    },
+    {
+        .path = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_handler,
+    },
+    // Static files from the asset bundle
+    {
+        .path = "/*",
+        .method = HTTP_GET,
+        .handler = asset_get_handler,
+        .user_ctx = &assets,
+    },
 };
 
+static const router_t router = ROUTER(routes, routes_slots, ROUTES_SEED);
+
 static void websocket_app_start(void) {
-    httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    server_tuning_apply(&config);
+    router_apply(&config);
+    config.core_id = HTTPD_TASK_CORE;
+    config.task_priority = HTTPD_TASK_PRIORITY;
+    config.stack_size = HTTPD_TASK_STACK;
+    init_post_response();
+#if CONFIG_IDF_TARGET_LINUX
+    config.server_port = SIM_SERVER_PORT;
+#endif
 
     ESP_LOGI(TAG, "Starting server on port: '%d'", config.server_port);
     if (httpd_start(&server, &config) == ESP_OK) {
         ESP_LOGI(TAG, "Registering URI handlers");
-        httpd_register_uri_handler(server, &uri_get);
-        httpd_register_uri_handler(server, &uri_data_get);
-        httpd_register_uri_handler(server, &uri_post);
+        router_register(server, &router);
     } else {
         ESP_LOGE(TAG, "Failed to start server!");
     }
 }
 
-// DHT11 sensor task
+// Readings of sensor 0 on their way to the history and the flash log. Both can
+// block, on the history lock while /history streams and on flash writes, so
+// they run in storage_task rather than between sensor reads.
+#define STORAGE_QUEUE_LEN 8
+
+struct storage_item {
+    uint32_t time_s; // Seconds since boot
+    float temperature;
+    float humidity;
+};
+
+static QueueHandle_t storage_queue;
+
+static void storage_task(void *pvParameter) {
+    struct storage_item item;
+    while (1) {
+        if (xQueueReceive(storage_queue, &item, portMAX_DELAY) == pdTRUE) {
+            history_add(item.time_s, item.temperature, item.humidity);
+            sensor_log_append(item.time_s, item.temperature, item.humidity);
+        }
+    }
+}
+
+// Filter and publish one reading; sensor 0 also feeds the history, the flash log and the WebSocket push
+static void dht11_record(size_t sensor, struct sensor_sample *sample, const dht11_reading_t *reading) {
+    int64_t now_us = esp_timer_get_time();
+    sensor_filter_output_t filtered;
+
+    if (!sample->status) {
+        sample->status = sensor_filter_update(&sensor_filters[sensor], now_us,
+                                              reading->temperature, reading->humidity, &filtered);
+        metrics_inc(sample->status == ESP_OK ? &dht11_reads_ok : &dht11_reads_rejected);
+    } else {
+        metrics_inc(sample->status == ESP_ERR_TIMEOUT ? &dht11_reads_timeout : &dht11_reads_error);
+    }
+    sample->rejected = sensor_filters[sensor].rejected;
+    if (!sample->status) {
+        sample->temperature = filtered.temperature;
+        sample->humidity = filtered.humidity;
+        sample->dew_point = filtered.dew_point;
+        sample->heat_index = filtered.heat_index;
+        sample->window_samples = filtered.window_samples;
+        sample->temp_stats = filtered.temp_stats;
+        sample->hum_stats = filtered.hum_stats;
+        sample->timestamp_us = now_us;
+        sample->seq++;
+        if (sensor == 0) {
+            struct storage_item item = {
+                .time_s = sample->timestamp_us / 1000000,
+                .temperature = sample->temperature,
+                .humidity = sample->humidity,
+            };
+            if (xQueueSend(storage_queue, &item, 0) != pdTRUE) {
+                metrics_inc(&storage_dropped);
+            }
+        }
+        ESP_LOGI(TAG, "Sensor %u: Temperature: %.2f, Humidity: %.2f, Dew point: %.2f",
+                 (unsigned)sensor, sample->temperature, sample->humidity, sample->dew_point);
+    }
+    const struct sensor_encoded *encoded = sensor_state_publish(sensor, sample);
+    if (!sample->status) {
+        mqtt_publisher_add(encoded->cbor, encoded->cbor_len);
+    }
+    if (sensor == 0 && !sample->status && server) {
+        atomic_store(&ws_broadcast_queued_us, (uint32_t)esp_timer_get_time());
+        httpd_queue_work(server, ws_broadcast_reading, NULL);
+    }
+}
+
+// DHT11 scheduler task: one RMT channel and one task read every sensor in turn.
+// Reads are spread evenly over the period, each in its own slot, so captures never
+// overlap and no sensor is polled faster than the datasheet allows.
 void dht11_task(void *pvParameter) {
-    dht11_t dht11_sensor;
-    dht11_sensor.dht11_pin = CONFIG_DHT11_PIN;
+    static dht11_rmt_t dht11_sensor;
+    static struct sensor_sample samples[DHT11_SENSOR_COUNT];
+    dht11_reading_t reading;
+
+#if TASK_TOPOLOGY_BENCH
+    uint32_t slot_ms = DHT11_SLOT_MIN_MS;
+#else
+    uint32_t slot_ms = CONFIG_SAMPLE_PERIOD_MS / DHT11_SENSOR_COUNT;
+    if (slot_ms < DHT11_SLOT_MIN_MS) {
+        slot_ms = DHT11_SLOT_MIN_MS;
+    }
+    if (slot_ms * DHT11_SENSOR_COUNT < DHT11_MIN_INTERVAL_MS) {
+        slot_ms = (DHT11_MIN_INTERVAL_MS + DHT11_SENSOR_COUNT - 1) / DHT11_SENSOR_COUNT;
+    }
+#endif
+
+    if (dht11_rmt_init(&dht11_sensor, dht11_pins[0]) != ESP_OK) {
+        vTaskDelete(NULL);
+    }
 
+    TickType_t wake = xTaskGetTickCount();
     while (1) {
-        if (!dht11_read(&dht11_sensor, CONFIG_CONNECTION_TIMEOUT)) {
-            temperature = dht11_sensor.temperature;
-            humidity = dht11_sensor.humidity;
-            ESP_LOGI(TAG, "Temperature: %.2f, Humidity: %.2f", temperature, humidity);
+        for (size_t i = 0; i < DHT11_SENSOR_COUNT; i++) {
+            // The capture runs in hardware, this task sleeps until it completes
+            samples[i].status = dht11_rmt_select_pin(&dht11_sensor, dht11_pins[i]);
+            if (!samples[i].status) {
+                dht11_rmt_start(&dht11_sensor);
+                samples[i].status = dht11_rmt_wait(&dht11_sensor, &reading, pdMS_TO_TICKS(CONFIG_READ_TIMEOUT_MS));
+            }
+            dht11_record(i, &samples[i], &reading);
+            vTaskDelayUntil(&wake, pdMS_TO_TICKS(slot_ms));
         }
-        vTaskDelay(2000 / portTICK_PERIOD_MS);
     }
 }
 
 void app_main(void) {
-    wifi_connection();
-    vTaskDelay(1500 / portTICK_PERIOD_MS);
+    wifi_station_start();
+    history_init();
+    sensor_log_init();
+    asset_bundle_mount(&assets);
+    sensor_state_init();
+#if SAMPLE_ENCODER_BENCH
+    sample_encoder_bench();
+#endif
+    init_metrics();
+    wifi_station_wait_ready(portMAX_DELAY);
+    ESP_LOGI(TAG, "Task layout %s%s: dht11_task core %d prio %d, httpd core %d prio %d, storage_task core %d prio %d",
+             TASK_LAYOUT_NAME, TASK_TOPOLOGY_BENCH ? " (benchmark)" : "",
+             SENSOR_TASK_CORE, SENSOR_TASK_PRIORITY, HTTPD_TASK_CORE, HTTPD_TASK_PRIORITY,
+             STORAGE_TASK_CORE, STORAGE_TASK_PRIORITY);
     websocket_app_start();
-    xTaskCreate(dht11_task, "dht11_task", 2048, NULL, 5, NULL);
+#if MQTT_PUBLISHER_ENABLE
+    mqtt_publisher_start();
+#endif
+    storage_queue = xQueueCreate(STORAGE_QUEUE_LEN, sizeof(struct storage_item));
+    xTaskCreatePinnedToCore(storage_task, "storage_task", STORAGE_TASK_STACK, NULL, STORAGE_TASK_PRIORITY,
+                            &storage_task_handle, STORAGE_TASK_CORE);
+    xTaskCreatePinnedToCore(dht11_task, "dht11_task", SENSOR_TASK_STACK, NULL, SENSOR_TASK_PRIORITY,
+                            &dht11_task_handle, SENSOR_TASK_CORE);
 }
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <math.h>
+#include <string.h>
+#include "sensor_filter.h"
+
+// Wider than the DHT11 specification (0-50 degC, 20-90 %RH) to keep the sensor's own
+// error; anything outside is a corrupted frame that happened to pass the checksum
+#define TEMP_MIN -20.0f
+#define TEMP_MAX 60.0f
+#define HUM_MIN 0.0f
+#define HUM_MAX 100.0f
+
+static uint8_t queue_front(const sensor_window_queue_t *queue) {
+    return queue->items[queue->head];
+}
+
+static uint8_t queue_back(const sensor_window_queue_t *queue) {
+    return queue->items[(queue->head + queue->len - 1) % SENSOR_WINDOW_LEN];
+}
+
+static void queue_pop_front(sensor_window_queue_t *queue) {
+    queue->head = (queue->head + 1) % SENSOR_WINDOW_LEN;
+    queue->len--;
+}
+
+static void queue_push_back(sensor_window_queue_t *queue, uint8_t slot) {
+    queue->items[(queue->head + queue->len) % SENSOR_WINDOW_LEN] = slot;
+    queue->len++;
+}
+
+void sensor_window_push(sensor_window_t *window, int16_t value) {
+    uint32_t n = window->count;
+    uint8_t slot = n % SENSOR_WINDOW_LEN;
+
+    if (n >= SENSOR_WINDOW_LEN) {
+        int64_t old = window->values[slot];
+        window->sum -= old;
+        window->sum_sq -= old * old;
+        // The sample leaving the window owns `slot`, and can only be at the front of a queue
+        if (window->min_queue.len != 0 && queue_front(&window->min_queue) == slot) {
+            queue_pop_front(&window->min_queue);
+        }
+        if (window->max_queue.len != 0 && queue_front(&window->max_queue) == slot) {
+            queue_pop_front(&window->max_queue);
+        }
+    }
+    window->values[slot] = value;
+    window->sum += value;
+    window->sum_sq += (int64_t)value * value;
+
+    // Drop samples that can no longer be the minimum (or maximum) while `value` is in the window
+    while (window->min_queue.len != 0 && window->values[queue_back(&window->min_queue)] >= value) {
+        window->min_queue.len--;
+    }
+    queue_push_back(&window->min_queue, slot);
+    while (window->max_queue.len != 0 && window->values[queue_back(&window->max_queue)] <= value) {
+        window->max_queue.len--;
+    }
+    queue_push_back(&window->max_queue, slot);
+    window->count = n + 1;
+}
+
+uint16_t sensor_window_stats(const sensor_window_t *window, sensor_window_stats_t *stats) {
+    uint32_t samples = window->count < SENSOR_WINDOW_LEN ? window->count : SENSOR_WINDOW_LEN;
+
+    if (samples == 0) {
+        memset(stats, 0, sizeof(*stats));
+        return 0;
+    }
+    stats->min = window->values[queue_front(&window->min_queue)];
+    stats->max = window->values[queue_front(&window->max_queue)];
+    stats->mean = (int16_t)lroundf((float)window->sum / samples);
+    // Integer sums keep the variance exact however long the window has been sliding
+    int64_t spread = window->sum_sq * samples - window->sum * window->sum;
+    stats->stddev = (uint16_t)lroundf(sqrtf((float)spread) / samples);
+    return samples;
+}
+
+float sensor_dew_point(float temperature, float humidity) {
+    // Magnus formula with the Sonntag (1990) constants
+    const float b = 17.62f;
+    const float c = 243.12f;
+    float gamma = logf(fmaxf(humidity, 1.0f) / 100.0f) + b * temperature / (c + temperature);
+    return c * gamma / (b - gamma);
+}
+
+float sensor_heat_index(float temperature, float humidity) {
+    // NOAA: Steadman's simple fit, and the Rothfusz regression once that reaches 80 degF
+    float t = temperature * 1.8f + 32.0f;
+    float rh = humidity;
+    float hi = 0.5f * (t + 61.0f + (t - 68.0f) * 1.2f + rh * 0.094f);
+
+    if ((hi + t) / 2.0f >= 80.0f) {
+        hi = -42.379f + 2.04901523f * t + 10.14333127f * rh - 0.22475541f * t * rh -
+             0.00683783f * t * t - 0.05481717f * rh * rh + 0.00122874f * t * t * rh +
+             0.00085282f * t * rh * rh - 0.00000199f * t * t * rh * rh;
+        if (rh < 13.0f && t >= 80.0f && t <= 112.0f) {
+            hi -= (13.0f - rh) / 4.0f * sqrtf((17.0f - fabsf(t - 95.0f)) / 17.0f);
+        } else if (rh > 85.0f && t >= 80.0f && t <= 87.0f) {
+            hi += (rh - 85.0f) / 10.0f * (87.0f - t) / 5.0f;
+        }
+    }
+    return (hi - 32.0f) / 1.8f;
+}
+
+static float median(const float *values, size_t count) {
+    float sorted[SENSOR_FILTER_MEDIAN_N];
+
+    for (size_t i = 0; i < count; i++) {
+        size_t j = i;
+        for (; j > 0 && sorted[j - 1] > values[i]; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = values[i];
+    }
+    return count % 2 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0f;
+}
+
+static bool plausible(const sensor_filter_t *filter, int64_t time_us, float temperature, float humidity) {
+    if (temperature < TEMP_MIN || temperature > TEMP_MAX || humidity < HUM_MIN || humidity > HUM_MAX) {
+        return false;
+    }
+    if (!filter->primed) {
+        return true;
+    }
+    // Allow at least one second of change so back-to-back reads are not held to zero
+    float elapsed_s = fmaxf((time_us - filter->last_us) / 1e6f, 1.0f);
+    return fabsf(temperature - filter->last_temperature) <= filter->config.max_temp_rate * elapsed_s &&
+           fabsf(humidity - filter->last_humidity) <= filter->config.max_hum_rate * elapsed_s;
+}
+
+void sensor_filter_init(sensor_filter_t *filter, const sensor_filter_config_t *config) {
+    memset(filter, 0, sizeof(*filter));
+    filter->config = *config;
+}
+
+esp_err_t sensor_filter_update(sensor_filter_t *filter, int64_t time_us, float temperature, float humidity,
+                               sensor_filter_output_t *out) {
+    if (!plausible(filter, time_us, temperature, humidity)) {
+        filter->rejected++;
+        // A run of consistent outliers is a real step, e.g. the sensor moved
+        bool in_range = temperature >= TEMP_MIN && temperature <= TEMP_MAX && humidity >= HUM_MIN && humidity <= HUM_MAX;
+        if (!in_range || ++filter->rejected_run < filter->config.relock_after) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        // Restart the median so the old level does not outvote the new one
+        filter->accepted = 0;
+    }
+    filter->rejected_run = 0;
+    filter->primed = true;
+    filter->last_us = time_us;
+    filter->last_temperature = temperature;
+    filter->last_humidity = humidity;
+
+    size_t slot = filter->accepted % SENSOR_FILTER_MEDIAN_N;
+    filter->temp_history[slot] = temperature;
+    filter->hum_history[slot] = humidity;
+    if (filter->accepted == 0) {
+        filter->temp_ema = temperature;
+        filter->hum_ema = humidity;
+    } else {
+        filter->temp_ema += filter->config.ema_alpha * (temperature - filter->temp_ema);
+        filter->hum_ema += filter->config.ema_alpha * (humidity - filter->hum_ema);
+    }
+    filter->accepted++;
+
+    if (filter->config.mode == SENSOR_FILTER_EMA) {
+        out->temperature = filter->temp_ema;
+        out->humidity = filter->hum_ema;
+    } else {
+        size_t count = filter->accepted < SENSOR_FILTER_MEDIAN_N ? filter->accepted : SENSOR_FILTER_MEDIAN_N;
+        out->temperature = median(filter->temp_history, count);
+        out->humidity = median(filter->hum_history, count);
+    }
+    out->dew_point = sensor_dew_point(out->temperature, out->humidity);
+    out->heat_index = sensor_heat_index(out->temperature, out->humidity);
+
+    sensor_window_push(&filter->temp_window, (int16_t)lroundf(out->temperature * 100));
+    sensor_window_push(&filter->hum_window, (int16_t)lroundf(out->humidity * 100));
+    out->window_samples = sensor_window_stats(&filter->temp_window, &out->temp_stats);
+    sensor_window_stats(&filter->hum_window, &out->hum_stats);
+    out->rejected = filter->rejected;
+    return ESP_OK;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define SENSOR_FILTER_MEDIAN_N 5 // Readings the median is taken over, odd
+#define SENSOR_WINDOW_LEN 30     // Samples in the statistics window, 1 minute at one per 2 s
+
+typedef enum {
+    SENSOR_FILTER_MEDIAN, // Median of the last SENSOR_FILTER_MEDIAN_N accepted readings
+    SENSOR_FILTER_EMA,    // Exponential moving average with weight ema_alpha for the newest
+} sensor_filter_mode_t;
+
+typedef struct {
+    sensor_filter_mode_t mode;
+    float ema_alpha;
+    float max_temp_rate;  // Largest believable change in degC per second
+    float max_hum_rate;   // Largest believable change in %RH per second
+    uint8_t relock_after; // Consecutive rejections after which a new level is believed
+} sensor_filter_config_t;
+
+#define SENSOR_FILTER_DEFAULT_CONFIG() {     \
+    .mode = SENSOR_FILTER_MEDIAN,            \
+    .ema_alpha = 0.25f,                      \
+    .max_temp_rate = 1.0f,                   \
+    .max_hum_rate = 5.0f,                    \
+    .relock_after = 3,                       \
+}
+
+// Sliding window over the last SENSOR_WINDOW_LEN samples of one quantity, in
+// hundredths. Sums give the mean and standard deviation; monotonic queues of
+// indices into values[] give the minimum and maximum. A push is O(1) amortized.
+typedef struct {
+    uint8_t head, len;
+    uint8_t items[SENSOR_WINDOW_LEN];
+} sensor_window_queue_t;
+
+typedef struct {
+    int16_t values[SENSOR_WINDOW_LEN];
+    uint32_t count; // Samples pushed so far
+    int64_t sum;
+    int64_t sum_sq;
+    sensor_window_queue_t min_queue, max_queue;
+} sensor_window_t;
+
+_Static_assert(SENSOR_WINDOW_LEN <= UINT8_MAX, "window queues hold uint8_t indices");
+
+// Window statistics in hundredths
+typedef struct {
+    int16_t min, max, mean;
+    uint16_t stddev;
+} sensor_window_stats_t;
+
+typedef struct {
+    sensor_filter_config_t config;
+    bool primed;
+    int64_t last_us; // Time of the last accepted reading
+    float last_temperature, last_humidity;
+    uint8_t rejected_run;
+    uint32_t rejected;
+    float temp_history[SENSOR_FILTER_MEDIAN_N], hum_history[SENSOR_FILTER_MEDIAN_N];
+    uint32_t accepted;
+    float temp_ema, hum_ema;
+    sensor_window_t temp_window, hum_window;
+} sensor_filter_t;
+
+// Filtered reading with its derived values
+typedef struct {
+    float temperature;
+    float humidity;
+    float dew_point;  // degC
+    float heat_index; // degC, NOAA apparent temperature
+    uint16_t window_samples;
+    sensor_window_stats_t temp_stats, hum_stats;
+    uint32_t rejected; // Readings rejected since boot
+} sensor_filter_output_t;
+
+void sensor_filter_init(sensor_filter_t *filter, const sensor_filter_config_t *config);
+
+// Feed one decoded reading taken at `time_us`. Readings out of the DHT11 range,
+// or moving faster than the configured rates since the last accepted one, are
+// rejected with ESP_ERR_INVALID_RESPONSE unless `relock_after` of them came in a
+// row, in which case the level is taken as a real step. Frames failing their
+// checksum never get here, dht11_decode() already drops them. On success `out`
+// holds the filtered values. Pure function of the filter state, no hardware access.
+esp_err_t sensor_filter_update(sensor_filter_t *filter, int64_t time_us, float temperature, float humidity,
+                               sensor_filter_output_t *out);
+
+void sensor_window_push(sensor_window_t *window, int16_t value);
+uint16_t sensor_window_stats(const sensor_window_t *window, sensor_window_stats_t *stats);
+
+// Magnus dew point and NOAA heat index, both in degC
+float sensor_dew_point(float temperature, float humidity);
+float sensor_heat_index(float temperature, float humidity);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Append-only reading log in a dedicated data partition (see partitions.csv).
+// On the linux target a file stands in for the partition.
+#define SENSOR_LOG_PARTITION_LABEL "sensorlog"
+#define SENSOR_LOG_HOST_PATH "sensorlog.bin"
+#define SENSOR_LOG_HOST_SIZE (64 * 1024)
+
+#define SENSOR_LOG_SECTOR_SIZE 4096 // Flash erase unit
+#define SENSOR_LOG_BATCH_SIZE 256   // Samples are buffered and written as one block of at most this size
+
+// Values are hundredths of a degree / percent. time_s counts from the start of
+// boot `boot`; boots are numbered from 1 in the order they wrote to the log.
+typedef struct {
+    uint32_t boot;
+    uint32_t time_s;
+    int16_t temperature;
+    int16_t humidity;
+} sensor_log_record_t;
+
+typedef struct {
+    uint32_t samples;        // Samples appended since boot
+    uint32_t flushes;        // Block writes issued
+    uint32_t bytes_written;  // Bytes programmed, including block headers
+    uint32_t sectors_erased;
+    uint32_t pending_bytes;  // Encoded bytes still waiting in the RAM batch
+} sensor_log_stats_t;
+
+// Sequential reader, oldest record first. Holds one block so it needs no heap.
+typedef struct {
+    uint32_t sector;   // Physical sector being read
+    uint32_t seq;      // Its sequence number
+    uint32_t offset;   // Next block within the sector
+    bool pending_done; // The unflushed RAM batch has been returned
+    uint8_t block[SENSOR_LOG_BATCH_SIZE];
+    size_t block_len;
+    size_t block_pos;
+    sensor_log_record_t last;
+} sensor_log_reader_t;
+
+// Mount the log and recover the write position after a reboot or power loss
+esp_err_t sensor_log_init(void);
+
+// Buffer one sample taken `time_s` seconds after boot, flushing the batch to flash when it is full
+esp_err_t sensor_log_append(uint32_t time_s, float temperature, float humidity);
+
+// Write out the partial batch, e.g. before a planned restart
+esp_err_t sensor_log_flush(void);
+
+void sensor_log_get_stats(sensor_log_stats_t *stats);
+
+void sensor_log_reader_init(sensor_log_reader_t *reader);
+bool sensor_log_read_next(sensor_log_reader_t *reader, sensor_log_record_t *record);
@@ -0,0 +1,68 @@
+#include <stdatomic.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "server_tuning.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_heap_caps.h"
+#endif
+
+static const char *TAG = "server_tuning";
+
+static const char overload_response[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Retry-After: 1\r\n"
+    "Connection: close\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+static atomic_uint open_sessions;
+static atomic_uint accepted;
+static atomic_uint rejected;
+
+static bool heap_short(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    return false;
+#else
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT) < SERVER_MIN_FREE_HEAP;
+#endif
+}
+
+// httpd calls close_fn for every session it created, including ones refused
+// here, so the session is counted before the check
+static esp_err_t server_open_fn(httpd_handle_t hd, int sockfd) {
+    atomic_fetch_add(&open_sessions, 1);
+    if (heap_short()) {
+        atomic_fetch_add(&rejected, 1);
+        httpd_socket_send(hd, sockfd, overload_response, sizeof(overload_response) - 1, 0);
+        ESP_LOGW(TAG, "Low memory, refused socket %d", sockfd);
+        return ESP_FAIL;
+    }
+    atomic_fetch_add(&accepted, 1);
+    return ESP_OK;
+}
+
+static void server_close_fn(httpd_handle_t hd, int sockfd) {
+    atomic_fetch_sub(&open_sessions, 1);
+    close(sockfd);
+}
+
+void server_tuning_apply(httpd_config_t *config) {
+    config->max_open_sockets = SERVER_MAX_SOCKETS;
+    config->backlog_conn = SERVER_BACKLOG;
+    config->lru_purge_enable = true;
+    config->recv_wait_timeout = SERVER_RECV_TIMEOUT_S;
+    config->send_wait_timeout = SERVER_SEND_TIMEOUT_S;
+    config->keep_alive_enable = true;
+    config->keep_alive_idle = SERVER_KEEP_ALIVE_IDLE_S;
+    config->keep_alive_interval = SERVER_KEEP_ALIVE_INTERVAL_S;
+    config->keep_alive_count = SERVER_KEEP_ALIVE_COUNT;
+    config->open_fn = server_open_fn;
+    config->close_fn = server_close_fn;
+}
+
+void server_tuning_get_stats(server_tuning_stats_t *stats) {
+    stats->open_sessions = atomic_load(&open_sessions);
+    stats->accepted = atomic_load(&accepted);
+    stats->rejected = atomic_load(&rejected);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+
+// Where the tasks of the sensor web server run. Wi-Fi and lwIP sit on core 0
+// by default. Pick a layout with -DTASK_LAYOUT=..., and override any single
+// setting below the same way.
+#define TASK_LAYOUT_UNPINNED 0 // Every task free to run on either core
+#define TASK_LAYOUT_SPLIT 1    // HTTP on core 1, away from Wi-Fi; sensor and storage on core 0
+#define TASK_LAYOUT_SINGLE 2   // Everything on core 0, HTTP above sensor I/O
+
+#ifndef TASK_LAYOUT
+#if CONFIG_IDF_TARGET_LINUX
+#define TASK_LAYOUT TASK_LAYOUT_UNPINNED
+#elif CONFIG_FREERTOS_UNICORE
+#define TASK_LAYOUT TASK_LAYOUT_SINGLE
+#else
+#define TASK_LAYOUT TASK_LAYOUT_SPLIT
+#endif
+#endif
+
+#if TASK_LAYOUT == TASK_LAYOUT_SPLIT && CONFIG_FREERTOS_UNICORE
+#error "TASK_LAYOUT_SPLIT needs a dual-core chip"
+#endif
+
+// The sensor task only starts captures and waits on RMT, so on a shared core it
+// runs above HTTP but for microseconds at a time. Storage writes flash and
+// takes the history lock that /history holds while streaming, so it runs last.
+#if TASK_LAYOUT == TASK_LAYOUT_SPLIT
+#define TASK_LAYOUT_NAME "split"
+#define LAYOUT_SENSOR_CORE 0
+#define LAYOUT_HTTPD_CORE 1
+#define LAYOUT_STORAGE_CORE 0
+#define LAYOUT_SENSOR_PRIORITY 6
+#define LAYOUT_HTTPD_PRIORITY 5
+#define LAYOUT_STORAGE_PRIORITY 2
+#elif TASK_LAYOUT == TASK_LAYOUT_SINGLE
+#define TASK_LAYOUT_NAME "single"
+#define LAYOUT_SENSOR_CORE 0
+#define LAYOUT_HTTPD_CORE 0
+#define LAYOUT_STORAGE_CORE 0
+#define LAYOUT_SENSOR_PRIORITY 6
+#define LAYOUT_HTTPD_PRIORITY 5
+#define LAYOUT_STORAGE_PRIORITY 1
+#else
+#define TASK_LAYOUT_NAME "unpinned"
+#define LAYOUT_SENSOR_CORE tskNO_AFFINITY
+#define LAYOUT_HTTPD_CORE tskNO_AFFINITY
+#define LAYOUT_STORAGE_CORE tskNO_AFFINITY
+#define LAYOUT_SENSOR_PRIORITY 5
+#define LAYOUT_HTTPD_PRIORITY 5
+#define LAYOUT_STORAGE_PRIORITY 5
+#endif
+
+#ifndef SENSOR_TASK_CORE
+#define SENSOR_TASK_CORE LAYOUT_SENSOR_CORE
+#endif
+#ifndef SENSOR_TASK_PRIORITY
+#define SENSOR_TASK_PRIORITY LAYOUT_SENSOR_PRIORITY
+#endif
+// dht11_task logs floats with %f, which needs over 1 KB of vfprintf stack on
+// its own, and renders the sample JSON and CBOR on top of the filter and RMT
+// calls. Watch task_stack_free_min_bytes in /metrics before lowering this.
+#ifndef SENSOR_TASK_STACK
+#define SENSOR_TASK_STACK 3072
+#endif
+
+#ifndef HTTPD_TASK_CORE
+#define HTTPD_TASK_CORE LAYOUT_HTTPD_CORE
+#endif
+#ifndef HTTPD_TASK_PRIORITY
+#define HTTPD_TASK_PRIORITY LAYOUT_HTTPD_PRIORITY
+#endif
+#ifndef HTTPD_TASK_STACK
+#define HTTPD_TASK_STACK 4096
+#endif
+
+#ifndef STORAGE_TASK_CORE
+#define STORAGE_TASK_CORE LAYOUT_STORAGE_CORE
+#endif
+#ifndef STORAGE_TASK_PRIORITY
+#define STORAGE_TASK_PRIORITY LAYOUT_STORAGE_PRIORITY
+#endif
+#ifndef STORAGE_TASK_STACK
+#define STORAGE_TASK_STACK 3072
+#endif
+
+// The MQTT publisher only waits on the network, it runs with storage by default
+#ifndef PUBLISHER_TASK_CORE
+#define PUBLISHER_TASK_CORE STORAGE_TASK_CORE
+#endif
+#ifndef PUBLISHER_TASK_PRIORITY
+#define PUBLISHER_TASK_PRIORITY STORAGE_TASK_PRIORITY
+#endif
+#ifndef PUBLISHER_TASK_STACK
+#define PUBLISHER_TASK_STACK 3072
+#endif
+
+// Benchmark mode: read the sensors back to back, one slot after another with
+// no datasheet interval, so /data latency can be measured under constant
+// acquisition load. A real DHT11 answers only part of these reads.
+#ifndef TASK_TOPOLOGY_BENCH
+#define TASK_TOPOLOGY_BENCH 0
+#endif
@@ -0,0 +1,337 @@
+// Host test for asset_bundle.c on images built by tools/asset_pack.py: lookups
+// that hit, miss or share a path hash, the ETag of each encoding through
+// asset_send, and images with a bad CRC, a bad version or cut short. Build and
+// run from the project directory (python3 must be on the PATH):
+//
+//   gcc -std=gnu11 -O2 -Itest/host -I. test/test_asset_bundle.c asset_bundle.c -o /tmp/test_asset_bundle && /tmp/test_asset_bundle
+//
+// Led_Web_Server and Sensor_Web_Server carry the same asset_bundle.c and this same test.
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asset_bundle.h"
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+#ifndef ASSET_PACK
+#define ASSET_PACK "../tools/asset_pack.py"
+#endif
+
+// Two paths with the same FNV-1a hash, 0x273985c4
+#define COLLIDING_PATH "/c710959.txt"
+#define COLLIDING_OTHER "/c1127602.txt"
+
+void host_log(char level, const char *tag, const char *fmt, ...) {
+    (void)level;
+    (void)tag;
+    (void)fmt;
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    (void)code;
+    return "error";
+}
+
+// Request headers asset_send reads and the response it builds
+static const char *accept_encoding;
+static const char *if_none_match;
+static struct {
+    const char *etag;
+    const char *encoding;
+    const char *status;
+    const char *type;
+    const char *body;
+    ssize_t length;
+} resp;
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size) {
+    const char *value = strcmp(field, "Accept-Encoding") == 0 ? accept_encoding
+                        : strcmp(field, "If-None-Match") == 0 ? if_none_match
+                                                              : NULL;
+    (void)req;
+    if (value == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    snprintf(val, val_size, "%s", value);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value) {
+    (void)req;
+    if (strcmp(field, "ETag") == 0) {
+        resp.etag = value;
+    } else if (strcmp(field, "Content-Encoding") == 0) {
+        resp.encoding = value;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status) {
+    (void)req;
+    resp.status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type) {
+    (void)req;
+    resp.type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len) {
+    (void)req;
+    resp.body = buf;
+    resp.length = buf_len;
+    return ESP_OK;
+}
+
+static void write_file(const char *dir, const char *name, const void *data, size_t len) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "wb");
+    CHECK(f != NULL);
+    CHECK(fwrite(data, 1, len, f) == len);
+    fclose(f);
+}
+
+static int run(const char *fmt, const char *arg1, const char *arg2) {
+    char command[512];
+    snprintf(command, sizeof(command), fmt, arg1, arg2);
+    return system(command);
+}
+
+static uint8_t *read_image(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    CHECK(f != NULL);
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *image = malloc(*size);
+    CHECK(image != NULL);
+    CHECK(fread(image, 1, *size, f) == *size);
+    fclose(f);
+    return image;
+}
+
+// Page, script and collision file compress; the random icon does not
+static char page[4096];
+static char script[2048];
+static uint8_t icon[300];
+
+static void make_tree(const char *www) {
+    for (size_t i = 0; i + 1 < sizeof(page); i++) {
+        page[i] = "<p>hello asset bundle</p>\n"[i % 26];
+    }
+    for (size_t i = 0; i + 1 < sizeof(script); i++) {
+        script[i] = "console.log(1);\n"[i % 16];
+    }
+    srand(7);
+    for (size_t i = 0; i < sizeof(icon); i++) {
+        icon[i] = rand();
+    }
+    CHECK(run("mkdir -p %s/js", www, "") == 0);
+    write_file(www, "index.html", page, strlen(page));
+    write_file(www, "js/app.js", script, strlen(script));
+    write_file(www, "icon.png", icon, sizeof(icon));
+    write_file(www, COLLIDING_PATH + 1, "only one of the pair\n", 21);
+}
+
+static void check_lookups(const asset_bundle_t *bundle) {
+    asset_t asset;
+
+    CHECK(bundle->count == 4);
+    CHECK(asset_bundle_find(bundle, "/index.html", strlen("/index.html"), &asset));
+    CHECK(strcmp(asset.path, "/index.html") == 0);
+    CHECK(strcmp(asset.mime, "text/html") == 0);
+    CHECK(asset.length == strlen(page) && memcmp(asset.data, page, asset.length) == 0);
+    CHECK(asset.gz_length > 0 && asset.gz_length < asset.length);
+    CHECK(asset.gz_data[0] == 0x1f && asset.gz_data[1] == 0x8b);
+
+    // The query string is left out of the length
+    const char *uri = "/js/app.js?v=3";
+    CHECK(asset_bundle_find(bundle, uri, strcspn(uri, "?"), &asset));
+    CHECK(strcmp(asset.mime, "application/javascript") == 0);
+    CHECK(asset.length == strlen(script) && memcmp(asset.data, script, asset.length) == 0);
+
+    CHECK(asset_bundle_find(bundle, "/icon.png", strlen("/icon.png"), &asset));
+    CHECK(strcmp(asset.mime, "image/png") == 0);
+    CHECK(asset.length == sizeof(icon) && memcmp(asset.data, icon, sizeof(icon)) == 0);
+    CHECK(asset.gz_length == 0);
+
+    // Misses: unknown paths, a prefix, a longer name and the uri without its slash
+    CHECK(!asset_bundle_find(bundle, "/missing.css", strlen("/missing.css"), &asset));
+    CHECK(!asset_bundle_find(bundle, "/index.htm", strlen("/index.htm"), &asset));
+    CHECK(!asset_bundle_find(bundle, "/index.html5", strlen("/index.html5"), &asset));
+    CHECK(!asset_bundle_find(bundle, "index.html", strlen("index.html"), &asset));
+    CHECK(!asset_bundle_find(bundle, "", 0, &asset));
+
+    // Same hash as a packed file, the name check has to reject it
+    CHECK(asset_hash(COLLIDING_PATH, strlen(COLLIDING_PATH)) == asset_hash(COLLIDING_OTHER, strlen(COLLIDING_OTHER)));
+    CHECK(asset_bundle_find(bundle, COLLIDING_PATH, strlen(COLLIDING_PATH), &asset));
+    CHECK(!asset_bundle_find(bundle, COLLIDING_OTHER, strlen(COLLIDING_OTHER), &asset));
+
+    asset_bundle_t empty = {0};
+    CHECK(!asset_bundle_find(&empty, "/index.html", strlen("/index.html"), &asset));
+}
+
+static void send_asset(const asset_t *asset, const char *encoding, const char *tag) {
+    memset(&resp, 0, sizeof(resp));
+    accept_encoding = encoding;
+    if_none_match = tag;
+    CHECK(asset_send(NULL, asset) == ESP_OK);
+}
+
+// Each encoding has its own strong ETag, and If-None-Match is held against the one being sent
+static void check_etags(const asset_bundle_t *bundle) {
+    asset_t asset;
+    char expected[64];
+
+    CHECK(asset_bundle_find(bundle, "/index.html", strlen("/index.html"), &asset));
+    CHECK(strlen(asset.etag) == 18 && asset.etag[0] == '"' && asset.etag[17] == '"');
+    snprintf(expected, sizeof(expected), "%.17s-gz\"", asset.etag);
+    CHECK(strcmp(asset.gz_etag, expected) == 0);
+
+    send_asset(&asset, "gzip, deflate", NULL);
+    CHECK(resp.status == NULL && strcmp(resp.type, "text/html") == 0);
+    CHECK(resp.etag == asset.gz_etag && strcmp(resp.encoding, "gzip") == 0);
+    CHECK(resp.body == (const char *)asset.gz_data && resp.length == (ssize_t)asset.gz_length);
+
+    send_asset(&asset, NULL, NULL);
+    CHECK(resp.status == NULL && resp.etag == asset.etag && resp.encoding == NULL);
+    CHECK(resp.body == (const char *)asset.data && resp.length == (ssize_t)asset.length);
+
+    send_asset(&asset, "identity", NULL);
+    CHECK(resp.etag == asset.etag && resp.encoding == NULL);
+
+    // A cached gzip copy revalidates only when gzip would be sent again
+    send_asset(&asset, "gzip", asset.gz_etag);
+    CHECK(resp.status != NULL && strncmp(resp.status, "304", 3) == 0);
+    CHECK(resp.etag == asset.gz_etag && resp.body == NULL && resp.length == 0);
+    send_asset(&asset, NULL, asset.gz_etag);
+    CHECK(resp.status == NULL && resp.etag == asset.etag && resp.length == (ssize_t)asset.length);
+
+    // And a cached plain copy only when plain would be sent again
+    send_asset(&asset, NULL, asset.etag);
+    CHECK(resp.status != NULL && resp.etag == asset.etag && resp.length == 0);
+    send_asset(&asset, "gzip", asset.etag);
+    CHECK(resp.status == NULL && resp.etag == asset.gz_etag && resp.length == (ssize_t)asset.gz_length);
+
+    // Either tag in a list matches its own encoding
+    snprintf(expected, sizeof(expected), "%s, %s", asset.etag, asset.gz_etag);
+    send_asset(&asset, "gzip", expected);
+    CHECK(resp.status != NULL && resp.etag == asset.gz_etag);
+    send_asset(&asset, NULL, expected);
+    CHECK(resp.status != NULL && resp.etag == asset.etag);
+
+    // Without a gzip copy there is one encoding and one tag, whatever the client accepts
+    CHECK(asset_bundle_find(bundle, "/icon.png", strlen("/icon.png"), &asset));
+    CHECK(strcmp(asset.gz_etag, asset.etag) == 0);
+    send_asset(&asset, "gzip", NULL);
+    CHECK(resp.etag == asset.etag && resp.encoding == NULL && resp.length == (ssize_t)sizeof(icon));
+    send_asset(&asset, "gzip", asset.etag);
+    CHECK(resp.status != NULL && resp.length == 0);
+
+    // Different content, different tags
+    asset_t script_asset;
+    CHECK(asset_bundle_find(bundle, "/js/app.js", strlen("/js/app.js"), &script_asset));
+    CHECK(strcmp(script_asset.etag, asset.etag) != 0);
+}
+
+static void check_damage(const uint8_t *image, size_t size) {
+    asset_bundle_t bundle;
+    asset_bundle_header_t header;
+    uint8_t *copy = malloc(size);
+
+    CHECK(copy != NULL);
+    memcpy(&header, image, sizeof(header));
+    CHECK(header.total_size == size);
+
+    // A flipped bit anywhere after the header fails the CRC
+    for (size_t i = sizeof(header); i < size; i += 97) {
+        memcpy(copy, image, size);
+        copy[i] ^= 0x10;
+        CHECK(asset_bundle_open(&bundle, copy, size) == ESP_ERR_INVALID_CRC);
+    }
+    memcpy(copy, image, size);
+    copy[size - 1] ^= 0x01;
+    CHECK(asset_bundle_open(&bundle, copy, size) == ESP_ERR_INVALID_CRC);
+
+    // As does a header CRC that does not match the body
+    memcpy(copy, image, size);
+    ((asset_bundle_header_t *)copy)->crc32 ^= 1;
+    CHECK(asset_bundle_open(&bundle, copy, size) == ESP_ERR_INVALID_CRC);
+
+    // Wrong magic or an older layout
+    memcpy(copy, image, size);
+    ((asset_bundle_header_t *)copy)->magic ^= 1;
+    CHECK(asset_bundle_open(&bundle, copy, size) == ESP_ERR_INVALID_VERSION);
+    memcpy(copy, image, size);
+    ((asset_bundle_header_t *)copy)->version = ASSET_VERSION - 1;
+    CHECK(asset_bundle_open(&bundle, copy, size) == ESP_ERR_INVALID_VERSION);
+
+    // Cut short at every length, down to an empty image
+    for (size_t len = 0; len < size; len++) {
+        CHECK(asset_bundle_open(&bundle, image, len) == ESP_ERR_INVALID_SIZE);
+    }
+
+    // An index claiming more entries than the image holds
+    memcpy(copy, image, size);
+    ((asset_bundle_header_t *)copy)->count = 0xffff;
+    CHECK(asset_bundle_open(&bundle, copy, size) == ESP_ERR_INVALID_SIZE);
+
+    // Trailing bytes past total_size, as in a partition larger than the bundle, are ignored
+    uint8_t *padded = malloc(size + 4096);
+    CHECK(padded != NULL);
+    memcpy(padded, image, size);
+    memset(padded + size, 0xff, 4096);
+    CHECK(asset_bundle_open(&bundle, padded, size + 4096) == ESP_OK);
+    CHECK(bundle.count == 4);
+    free(padded);
+    free(copy);
+}
+
+int main(void) {
+    char dir[] = "/tmp/test_asset_bundle.XXXXXX";
+    char www[64];
+    char bin[64];
+    asset_bundle_t bundle;
+    size_t size;
+
+    CHECK(mkdtemp(dir) != NULL);
+    snprintf(www, sizeof(www), "%s/www", dir);
+    snprintf(bin, sizeof(bin), "%s/assets.bin", dir);
+    make_tree(www);
+    CHECK(run("python3 " ASSET_PACK " %s %s >/dev/null", www, bin) == 0);
+    CHECK(run("python3 " ASSET_PACK " --list %s >/dev/null", bin, "") == 0);
+
+    uint8_t *image = read_image(bin, &size);
+    CHECK(asset_bundle_open(&bundle, image, size) == ESP_OK);
+    check_lookups(&bundle);
+    check_etags(&bundle);
+    check_damage(image, size);
+
+    // Packing is reproducible
+    size_t again_size;
+    CHECK(run("python3 " ASSET_PACK " %s %s.again >/dev/null", www, bin) == 0);
+    snprintf(bin + strlen(bin), sizeof(bin) - strlen(bin), ".again");
+    uint8_t *again = read_image(bin, &again_size);
+    CHECK(again_size == size && memcmp(again, image, size) == 0);
+
+    // The packer refuses a tree with two paths of the same hash
+    write_file(www, COLLIDING_OTHER + 1, "the other one\n", 14);
+    CHECK(run("python3 " ASSET_PACK " %s %s/collide.bin >/dev/null 2>&1", www, dir) != 0);
+
+    free(again);
+    free(image);
+    CHECK(run("rm -rf %s", dir, "") == 0);
+    printf("asset_bundle: all checks passed\n");
+    return 0;
+}
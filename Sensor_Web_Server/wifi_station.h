@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// Connection timing, all in milliseconds since boot; -1 until it happens
+typedef struct {
+    int64_t boot_to_ip_ms;            // First IP address after boot
+    int64_t boot_to_first_request_ms; // First request served after boot
+    int64_t reconnect_ms;             // Link loss to first request served, last reconnect
+    uint32_t reconnects;              // IP addresses obtained after a link loss
+    bool cached_ap;                   // This boot joined through the cached channel/BSSID
+} wifi_station_stats_t;
+
+// Start the station and return at once. Readiness is signalled through an
+// event group, lost links are retried with jittered exponential backoff and
+// the last good channel/BSSID is kept in NVS so the next boot skips the scan.
+// On the linux target the loopback interface is ready immediately.
+void wifi_station_start(void);
+
+// Block until the station has an IP address; false if `timeout` passed first
+bool wifi_station_wait_ready(TickType_t timeout);
+
+// Current IP address as a string, empty while disconnected
+const char *wifi_station_ip(void);
+
+// Call from request handlers: the first call after boot or a reconnect records
+// the time to first served request, later calls are a single atomic load
+void wifi_station_note_request(void);
+
+void wifi_station_get_stats(wifi_station_stats_t *stats);
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""Pack a directory of web assets into a bundle for the assets flash partition.
+
+Every file under the directory is served at its relative path, so
+`www/app.js` becomes `/app.js` and `www/index.html` also answers `/`. Each
+entry carries the path hash, the plain content, a gzip copy when it is
+smaller, the MIME type and a strong ETag for each encoding (the gzip one ends
+in `-gz`). The layout is described in
+asset_bundle.h. Output is reproducible: an unchanged directory packs to an
+identical image.
+
+Pack and flash the bundle without touching the firmware, e.g.:
+    python3 tools/asset_pack.py www/ assets.bin --max-size 512K
+    parttool.py --port /dev/ttyUSB0 write_partition --partition-name assets --input assets.bin
+
+Check and list an existing image with:
+    python3 tools/asset_pack.py --list assets.bin
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = 0x31425341  # "ASB1"
+VERSION = 2
+HEADER = struct.Struct("<IHHIII")
+ENTRY = struct.Struct("<IIIIIHHHH")
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".htm": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".jpg": "image/jpeg",
+    ".jpeg": "image/jpeg",
+    ".gif": "image/gif",
+    ".ico": "image/x-icon",
+    ".txt": "text/plain",
+    ".woff2": "font/woff2",
+}
+
+
+def fnv1a(data):
+    h = 2166136261
+    for byte in data:
+        h = ((h ^ byte) * 16777619) & 0xffffffff
+    return h
+
+
+def parse_size(text):
+    units = {"K": 1024, "M": 1024 * 1024}
+    if text[-1].upper() in units:
+        return int(text[:-1], 0) * units[text[-1].upper()]
+    return int(text, 0)
+
+
+def collect(root):
+    files = []
+    for directory, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for filename in sorted(filenames):
+            full = os.path.join(directory, filename)
+            path = "/" + os.path.relpath(full, root).replace(os.sep, "/")
+            with open(full, "rb") as f:
+                files.append((path, f.read()))
+    return files
+
+
+def pack(files):
+    strings = bytearray()
+    string_offsets = {}
+
+    def intern(text):
+        if text not in string_offsets:
+            string_offsets[text] = len(strings)
+            strings.extend(text.encode() + b"\0")
+        return string_offsets[text]
+
+    entries = []
+    for path, data in files:
+        ext = os.path.splitext(path)[1].lower()
+        mime = MIME_TYPES.get(ext, "application/octet-stream")
+        compressed = gzip.compress(data, compresslevel=9, mtime=0)
+        if len(compressed) >= len(data):
+            compressed = b""
+        digest = hashlib.sha1(data).hexdigest()[:16]
+        etag = '"%s"' % digest
+        gz_etag = '"%s-gz"' % digest if compressed else etag
+        entries.append({
+            "path": path, "hash": fnv1a(path.encode()), "data": data, "gz": compressed,
+            "path_off": intern(path), "mime_off": intern(mime), "etag_off": intern(etag),
+            "gz_etag_off": intern(gz_etag),
+        })
+
+    entries.sort(key=lambda e: e["hash"])
+    for a, b in zip(entries, entries[1:]):
+        if a["hash"] == b["hash"]:
+            sys.exit("hash collision between %s and %s, rename one" % (a["path"], b["path"]))
+    if len(strings) > 0xffff:
+        sys.exit("string table over 64 KiB")
+
+    offset = HEADER.size + ENTRY.size * len(entries) + len(strings)
+    blobs = bytearray()
+    for entry in entries:
+        for key in ("data", "gz"):
+            pad = -(offset + len(blobs)) % 4
+            blobs.extend(b"\0" * pad)
+            entry[key + "_off"] = offset + len(blobs) if entry[key] else 0
+            blobs.extend(entry[key])
+
+    body = bytearray()
+    for entry in entries:
+        body.extend(ENTRY.pack(entry["hash"], entry["data_off"], len(entry["data"]), entry["gz_off"],
+                               len(entry["gz"]), entry["path_off"], entry["mime_off"], entry["etag_off"],
+                               entry["gz_etag_off"]))
+    body.extend(strings)
+    body.extend(blobs)
+    header = HEADER.pack(MAGIC, VERSION, len(entries), len(strings), HEADER.size + len(body), zlib.crc32(body))
+    return header + body
+
+
+def string_at(strings, offset):
+    return strings[offset:strings.index(b"\0", offset)].decode()
+
+
+def list_bundle(image):
+    magic, version, count, strings_size, total, crc = HEADER.unpack_from(image)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("not an asset bundle")
+    if total > len(image) or zlib.crc32(image[HEADER.size:total]) != crc:
+        sys.exit("truncated or corrupt bundle")
+    strings_start = HEADER.size + ENTRY.size * count
+    strings = image[strings_start:strings_start + strings_size]
+    print("%d assets, %d bytes" % (count, total))
+    for i in range(count):
+        fields = ENTRY.unpack_from(image, HEADER.size + ENTRY.size * i)
+        _, _, length, _, gz_length, path, mime, etag, gz_etag = fields
+        tags = string_at(strings, etag)
+        if gz_length:
+            tags += " " + string_at(strings, gz_etag)
+        print("  %-32s %-24s %7d %7s  %s" % (string_at(strings, path), string_at(strings, mime), length,
+                                             gz_length or "-", tags))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="directory to pack, or the image with --list")
+    parser.add_argument("output", nargs="?", help="bundle image to write")
+    parser.add_argument("--max-size", type=parse_size, help="fail if the image exceeds the partition size")
+    parser.add_argument("--list", action="store_true", help="check and list an existing image")
+    args = parser.parse_args()
+
+    if args.list:
+        with open(args.source, "rb") as f:
+            list_bundle(f.read())
+        return
+    if args.output is None:
+        parser.error("output image required")
+
+    image = pack(collect(args.source))
+    if args.max_size is not None and len(image) > args.max_size:
+        sys.exit("bundle is %d bytes, partition holds %d" % (len(image), args.max_size))
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("%s: %d bytes" % (args.output, len(image)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Embed a web page as a C header holding both the plain and gzip encodings.
+
+The header defines `<name>[]` (the plain text, NUL terminated), `<name>_gz[]`
+(the gzip stream), `<NAME>_ETAG`, a strong ETag derived from the content, and
+`<NAME>_ETAG_GZ`, the same tag with a `-gz` suffix for the gzip stream; strong
+ETags must differ between content codings of the same resource.
+The gzip stream is produced with a zero mtime so rebuilding an unchanged page
+yields an identical header and ETag.
+
+Run it from the build whenever the page changes, e.g.:
+    python3 tools/gzip_asset.py Sensor_Web_Server/index.html \\
+        Sensor_Web_Server/index_html.h --name index_html
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+
+
+def c_string_lines(data):
+    # One C string literal per source line, non-ASCII bytes as octal escapes
+    lines = []
+    for raw_line in data.splitlines(keepends=True):
+        out = []
+        for byte in raw_line:
+            ch = chr(byte)
+            if ch == "\\":
+                out.append("\\\\")
+            elif ch == '"':
+                out.append('\\"')
+            elif ch == "\n":
+                out.append("\\n")
+            elif ch == "\r":
+                out.append("\\r")
+            elif ch == "\t":
+                out.append("\\t")
+            elif 0x20 <= byte < 0x7f:
+                out.append(ch)
+            else:
+                out.append("\\%03o" % byte)
+        lines.append('"%s"' % "".join(out))
+    return lines or ['""']
+
+
+def c_byte_lines(data, per_line=16):
+    return [", ".join("0x%02x" % b for b in data[i:i + per_line])
+            for i in range(0, len(data), per_line)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="page to embed")
+    parser.add_argument("header", help="generated C header")
+    parser.add_argument("--name", required=True, help="C identifier for the page")
+    args = parser.parse_args()
+
+    with open(args.source, "rb") as f:
+        data = f.read()
+    compressed = gzip.compress(data, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(data).hexdigest()[:16]
+    guard = os.path.basename(args.header).upper().replace(".", "_").replace("-", "_")
+
+    out = []
+    out.append("// Generated by tools/gzip_asset.py from %s, do not edit" % os.path.basename(args.source))
+    out.append("// %d bytes plain, %d bytes gzip" % (len(data), len(compressed)))
+    out.append("#ifndef %s" % guard)
+    out.append("#define %s" % guard)
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append('#define %s_ETAG "\\"%s\\""' % (args.name.upper(), etag))
+    out.append('#define %s_ETAG_GZ "\\"%s-gz\\""' % (args.name.upper(), etag))
+    out.append("")
+    out.append("static const char %s[] =" % args.name)
+    out.extend("    " + line for line in c_string_lines(data))
+    out[-1] += ";"
+    out.append("")
+    out.append("static const uint8_t %s_gz[] = {" % args.name)
+    out.extend("    %s," % line for line in c_byte_lines(compressed))
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+
+    with open(args.header, "w", newline="\n") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""HTTP load generator for the ESP32 web server projects.
+
+Runs N concurrent keep-alive clients against a board (or the host simulation
+build) and reports requests/sec and p50/p99 latency per path, plus the peak
+memory of the simulated server process when its PID is given, or the board's
+heap figures scraped from /metrics before and after the run.
+
+Examples:
+    python3 tools/http_bench.py --host 127.0.0.1 --port 8080 --clients 8
+    python3 tools/http_bench.py --host 192.168.1.42 --port 80 \\
+        --paths /,/data --duration 30
+    python3 tools/http_bench.py --paths /data,/sensors --accept application/cbor
+"""
+
+import argparse
+import http.client
+import threading
+import time
+
+# POST bodies for the routes that expect one
+DEFAULT_BODIES = {
+    "/ws": "led=on",
+}
+
+
+def percentile(samples, pct):
+    if not samples:
+        return 0.0
+    ordered = sorted(samples)
+    index = min(len(ordered) - 1, int(round(pct / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def read_heap_metrics(args):
+    # Free and minimum free heap as exported by the firmware's /metrics
+    wanted = {"heap_free_bytes": None, "heap_min_free_bytes": None}
+    try:
+        conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+        conn.request("GET", "/metrics")
+        text = conn.getresponse().read().decode("utf-8", "replace")
+        conn.close()
+    except (OSError, http.client.HTTPException):
+        return wanted
+    for line in text.splitlines():
+        name, _, value = line.partition(" ")
+        if name in wanted:
+            wanted[name] = int(float(value))
+    return wanted
+
+
+def read_peak_memory_kb(pid):
+    # VmHWM is the resident high-water mark of the simulated firmware
+    try:
+        with open("/proc/%d/status" % pid) as status:
+            for line in status:
+                if line.startswith("VmHWM:"):
+                    return int(line.split()[1])
+    except OSError:
+        pass
+    return None
+
+
+class Client(threading.Thread):
+    def __init__(self, args, path, deadline):
+        super().__init__(daemon=True)
+        self.args = args
+        self.path = path
+        self.deadline = deadline
+        self.latencies = []
+        self.errors = 0
+        self.rejected = 0  # Clean 503 overload answers, counted apart from failures
+        self.reconnects = 0
+        self.body_bytes = 0
+
+    def connect(self):
+        return http.client.HTTPConnection(self.args.host, self.args.port,
+                                          timeout=self.args.timeout)
+
+    def run(self):
+        conn = self.connect()
+        body = DEFAULT_BODIES.get(self.path)
+        method = "POST" if body is not None else "GET"
+        headers = {"Content-Type": "application/x-www-form-urlencoded"} if body else {}
+        if self.args.accept:
+            headers["Accept"] = self.args.accept
+        while time.monotonic() < self.deadline:
+            start = time.perf_counter()
+            try:
+                conn.request(method, self.path, body=body, headers=headers)
+                response = conn.getresponse()
+                payload = response.read()
+                if response.status == 503:
+                    self.rejected += 1
+                elif response.status >= 400:
+                    self.errors += 1
+                else:
+                    self.latencies.append(time.perf_counter() - start)
+                    self.body_bytes += len(payload)
+                if response.will_close or not self.args.keep_alive:
+                    conn.close()
+                    conn = self.connect()
+            except (OSError, http.client.HTTPException):
+                # Includes sockets closed by the server's LRU purge
+                self.errors += 1
+                self.reconnects += 1
+                conn.close()
+                conn = self.connect()
+        conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--paths", default="/,/data,/ws",
+                        help="comma separated list of paths to exercise")
+    parser.add_argument("--clients", type=int, default=4,
+                        help="concurrent clients per path")
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds")
+    parser.add_argument("--timeout", type=float, default=5.0,
+                        help="per request socket timeout in seconds")
+    parser.add_argument("--no-keep-alive", dest="keep_alive", action="store_false",
+                        help="open a new connection for every request")
+    parser.add_argument("--pid", type=int,
+                        help="PID of the host simulation build, to report peak memory")
+    parser.add_argument("--accept",
+                        help="Accept header to send, e.g. application/cbor")
+    parser.add_argument("--metrics", action="store_true",
+                        help="scrape free and minimum free heap from /metrics before and after the run")
+    args = parser.parse_args()
+
+    paths = [p for p in args.paths.split(",") if p]
+    heap_before = read_heap_metrics(args) if args.metrics else None
+    deadline = time.monotonic() + args.duration
+    clients = [Client(args, path, deadline) for path in paths for _ in range(args.clients)]
+    started = time.monotonic()
+    for client in clients:
+        client.start()
+    for client in clients:
+        client.join()
+    elapsed = time.monotonic() - started
+
+    print("%-10s %8s %10s %10s %10s %8s %8s %8s %8s" % (
+        "path", "requests", "req/s", "p50 ms", "p99 ms", "bytes", "errors", "503s", "reconn"))
+    total = 0
+    sent = 0
+    for path in paths:
+        latencies = [l for c in clients if c.path == path for l in c.latencies]
+        errors = sum(c.errors for c in clients if c.path == path)
+        rejected = sum(c.rejected for c in clients if c.path == path)
+        reconnects = sum(c.reconnects for c in clients if c.path == path)
+        body_bytes = sum(c.body_bytes for c in clients if c.path == path)
+        total += len(latencies)
+        sent += len(latencies) + errors + rejected
+        # Mean body size of the successful responses
+        print("%-10s %8d %10.1f %10.2f %10.2f %8d %8d %8d %8d" % (
+            path, len(latencies), len(latencies) / elapsed,
+            percentile(latencies, 50) * 1000, percentile(latencies, 99) * 1000,
+            body_bytes // len(latencies) if latencies else 0, errors, rejected, reconnects))
+    print("%-10s %8d %10.1f" % ("total", total, total / elapsed))
+
+    if args.pid:
+        peak = read_peak_memory_kb(args.pid)
+        print("peak memory: %s" % ("%d kB" % peak if peak is not None else "unavailable"))
+    if args.metrics:
+        heap_after = read_heap_metrics(args)
+        for name, value in heap_after.items():
+            before = heap_before[name]
+            print("%s: %s -> %s" % (name, before if before is not None else "unavailable",
+                                    value if value is not None else "unavailable"))
+        free_before, free_after = heap_before["heap_free_bytes"], heap_after["heap_free_bytes"]
+        if free_before is not None and free_after is not None:
+            # Negative when the run left less heap free, a leak if it persists across runs
+            print("free heap delta: %+d bytes" % (free_after - free_before))
+        low_before, low_after = heap_before["heap_min_free_bytes"], heap_after["heap_min_free_bytes"]
+        if low_before is not None and low_after is not None and sent:
+            # The low-water mark only falls, so this is the peak heap the run cost per request
+            print("low-water drop: %d bytes, %.2f bytes/request over %d requests" % (
+                low_before - low_after, (low_before - low_after) / sent, sent))
+
+
+if __name__ == "__main__":
+    main()
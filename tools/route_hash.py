@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Generate the perfect hash of a router_route_t table as a C header.
+
+Reads the `.path = "..."` of every entry of the table named by --table in the
+C source, skips '*' prefix routes, and searches for the smallest power-of-two
+slot count and a seed that put every distinct path in a slot of its own. The
+header defines `<NAME>_SEED` and `<name>_slots[]`, where each slot holds the
+index of the first route with that path plus one, 0 when empty. The hash is
+router_hash() from router.c; router_register() refuses a stale table.
+
+Rerun it whenever a route table changes, e.g.:
+    python3 tools/route_hash.py Sensor_Web_Server/sensor_dht11.c \\
+        Sensor_Web_Server/routes_hash.h --table routes --name routes
+"""
+
+import argparse
+import os
+import re
+import sys
+
+SEEDS_PER_SIZE = 1 << 16
+
+
+def route_hash(path, seed):
+    # Must match router_hash() in router.c
+    h = 2166136261 ^ seed
+    for byte in path.encode():
+        h = ((h ^ byte) * 16777619) & 0xffffffff
+    return h ^ (h >> 16)
+
+
+def table_paths(source, table):
+    match = re.search(r"router_route_t\s+%s\s*\[\s*\]\s*=\s*\{" % re.escape(table), source)
+    if not match:
+        sys.exit("route table %s not found" % table)
+    body = source[match.end():source.index("};", match.end())]
+    paths = []
+    for entry in re.findall(r"\{([^{}]*)\}", body):
+        path = re.search(r'\.path\s*=\s*"((?:[^"\\]|\\.)*)"', entry)
+        if not path:
+            sys.exit("route without a .path: {%s}" % entry.strip())
+        paths.append(path.group(1))
+    return paths
+
+
+def find_hash(keys):
+    # keys: (path, route index) of every distinct exact path
+    size = 1
+    while size < len(keys):
+        size *= 2
+    while True:
+        for seed in range(SEEDS_PER_SIZE):
+            slots = [0] * size
+            for path, index in keys:
+                slot = route_hash(path, seed) & (size - 1)
+                if slots[slot]:
+                    break
+                slots[slot] = index + 1
+            else:
+                return seed, slots
+        size *= 2
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="C file holding the route table")
+    parser.add_argument("header", help="generated C header")
+    parser.add_argument("--table", required=True, help="C identifier of the route table")
+    parser.add_argument("--name", required=True, help="C identifier prefix for the hash")
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        paths = table_paths(f.read(), args.table)
+    if len(paths) > 254:
+        sys.exit("at most 254 routes fit in 8-bit slots")
+
+    keys = []
+    for index, path in enumerate(paths):
+        if path.endswith("*") or (index > 0 and path == paths[index - 1]):
+            continue
+        if any(path == other for other, _ in keys):
+            sys.exit("routes for %s must be adjacent" % path)
+        keys.append((path, index))
+    seed, slots = find_hash(keys)
+    guard = os.path.basename(args.header).upper().replace(".", "_").replace("-", "_")
+
+    out = []
+    out.append("// Generated by tools/route_hash.py from %s, do not edit" % os.path.basename(args.source))
+    out.append("// %d paths in %d slots" % (len(keys), len(slots)))
+    out.append("#ifndef %s" % guard)
+    out.append("#define %s" % guard)
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("#define %s_SEED 0x%08xu" % (args.name.upper(), seed))
+    out.append("")
+    out.append("static const uint8_t %s_slots[%d] = {" % (args.name, len(slots)))
+    for index in slots:
+        out.append("    %d,%s" % (index, " // %s" % paths[index - 1] if index else ""))
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+
+    with open(args.header, "w", newline="\n") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()